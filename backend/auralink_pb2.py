@@ -0,0 +1,37 @@
+# -*- coding: utf-8 -*-
+# Generated by the protocol buffer compiler.  DO NOT EDIT!
+# source: auralink.proto
+"""Generated protocol buffer code."""
+from google.protobuf.internal import builder as _builder
+from google.protobuf import descriptor as _descriptor
+from google.protobuf import descriptor_pool as _descriptor_pool
+from google.protobuf import symbol_database as _symbol_database
+# @@protoc_insertion_point(imports)
+
+_sym_db = _symbol_database.Default()
+
+
+
+
+DESCRIPTOR = _descriptor_pool.Default().AddSerializedFile(b'\n\x0e\x61uralink.proto\x12\x08\x61uralink\"\x92\x01\n\rSensorReading\x12\x0b\n\x03seq\x18\x01 \x01(\r\x12\x14\n\x0ctimestamp_ms\x18\x02 \x01(\r\x12\x13\n\x0btemperature\x18\x03 \x01(\x02\x12\x10\n\x08humidity\x18\x04 \x01(\x02\x12\x15\n\rlight_percent\x18\x05 \x01(\r\x12\x13\n\x0bnox_percent\x18\x06 \x01(\r\x12\x0b\n\x03pir\x18\x07 \x01(\x08\"B\n\x06Uplink\x12\x0e\n\x06schema\x18\x01 \x01(\r\x12(\n\x07reading\x18\x02 \x01(\x0b\x32\x17.auralink.SensorReading\"I\n\x0b\x44isplayText\x12\x0e\n\x06msg_id\x18\x01 \x01(\r\x12\r\n\x05index\x18\x02 \x01(\r\x12\r\n\x05\x63ount\x18\x03 \x01(\r\x12\x0c\n\x04text\x18\x04 \x01(\t\"0\n\x07Urgency\x12%\n\x05level\x18\x01 \x01(\x0e\x32\x16.auralink.UrgencyLevel\"\xbe\x01\n\x08\x44ownlink\x12\x0e\n\x06schema\x18\x01 \x01(\r\x12&\n\x05quote\x18\x02 \x01(\x0b\x32\x15.auralink.DisplayTextH\x00\x12(\n\x07summary\x18\x03 \x01(\x0b\x32\x15.auralink.DisplayTextH\x00\x12$\n\x07urgency\x18\x04 \x01(\x0b\x32\x11.auralink.UrgencyH\x00\x12\x0f\n\x05rules\x18\x05 \x01(\x0cH\x00\x12\x11\n\x07\x63\x61pture\x18\x06 \x01(\tH\x00\x42\x06\n\x04\x62ody*6\n\rSchemaVersion\x12\x16\n\x12SCHEMA_UNSPECIFIED\x10\x00\x12\r\n\tSCHEMA_V1\x10\x01*E\n\x0cUrgencyLevel\x12\x0f\n\x0bURGENCY_LOW\x10\x00\x12\x12\n\x0eURGENCY_MEDIUM\x10\x01\x12\x10\n\x0cURGENCY_HIGH\x10\x02\x62\x06proto3')
+
+_builder.BuildMessageAndEnumDescriptors(DESCRIPTOR, globals())
+_builder.BuildTopDescriptorsAndMessages(DESCRIPTOR, 'auralink_pb2', globals())
+if _descriptor._USE_C_DESCRIPTORS == False:
+
+  DESCRIPTOR._options = None
+  _SCHEMAVERSION._serialized_start=563
+  _SCHEMAVERSION._serialized_end=617
+  _URGENCYLEVEL._serialized_start=619
+  _URGENCYLEVEL._serialized_end=688
+  _SENSORREADING._serialized_start=29
+  _SENSORREADING._serialized_end=175
+  _UPLINK._serialized_start=177
+  _UPLINK._serialized_end=243
+  _DISPLAYTEXT._serialized_start=245
+  _DISPLAYTEXT._serialized_end=318
+  _URGENCY._serialized_start=320
+  _URGENCY._serialized_end=368
+  _DOWNLINK._serialized_start=371
+  _DOWNLINK._serialized_end=561
+# @@protoc_insertion_point(module_scope)
@@ -1,8 +1,15 @@
-# MQTT Topics
+# MQTT Topics. Protobuf uplink/downlink carry the typed schema in
+# test/proto/auralink.proto (see wire.py); the plain topics after them
+# are the legacy JSON/text contract, still accepted on both ends.
+TOPIC_UPLINK = "auralink/pb/uplink"
+TOPIC_DOWNLINK = "auralink/pb/downlink"
+
 TOPIC_SENSOR_DATA = "auralink/sensor/data"
+TOPIC_SENSOR_BATCH = "auralink/sensor/batch"
 TOPIC_DISPLAY_QUOTE = "auralink/display/quote"
 TOPIC_DISPLAY_SUMMARY = "auralink/display/summary"
 TOPIC_URGENCY_LED = "auralink/urgency/led"
+TOPIC_DEVICE_RECOVERY = "auralink/device/recovery"  # Sent on every device boot
 
 # MQTT Broker Configuration
 MQTT_BROKER = "test.mosquitto.org"
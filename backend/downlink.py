@@ -0,0 +1,88 @@
+"""Downlink helpers shared by main.py and main_api.py."""
+import itertools
+import os
+import threading
+
+import wire
+from config import TOPIC_DISPLAY_QUOTE, TOPIC_DISPLAY_SUMMARY, TOPIC_URGENCY_LED
+
+# Largest payload sent on a single topic. Anything longer is split into
+# chunks on "<topic>/chunk/<msg_id>/<index>/<count>", which the device
+# folds straight into a fixed-size text store (see test/include/text_store.h),
+# so its RAM use does not depend on how long the LLM output is.
+DOWNLINK_CHUNK_BYTES = 200
+
+# Display text and urgency go out as protobuf on wire.TOPIC_DOWNLINK by
+# default; AURALINK_DOWNLINK_FORMAT=text keeps the legacy plain topics.
+# Devices accept both.
+DOWNLINK_FORMAT = os.getenv("AURALINK_DOWNLINK_FORMAT", "protobuf")
+
+_TEXT_TOPICS = {"quote": TOPIC_DISPLAY_QUOTE, "summary": TOPIC_DISPLAY_SUMMARY}
+
+_msg_ids = itertools.count()
+_msg_id_lock = threading.Lock()
+
+
+def _next_msg_id():
+    with _msg_id_lock:
+        return next(_msg_ids) % 65536
+
+
+def split_utf8(data, limit):
+    """Splits bytes into pieces of at most `limit` bytes, never inside a UTF-8 sequence."""
+    chunks = []
+    start = 0
+    while start < len(data):
+        end = min(start + limit, len(data))
+        # Back off continuation bytes (10xxxxxx) so each chunk decodes alone
+        while end < len(data) and end > start and (data[end] & 0xC0) == 0x80:
+            end -= 1
+        if end == start:
+            end = min(start + limit, len(data))
+        chunks.append(data[start:end])
+        start = end
+    return chunks
+
+
+def publish_text(client, topic, text, chunk_bytes=DOWNLINK_CHUNK_BYTES):
+    """Publishes display text whole when small, otherwise as sequence-numbered chunks.
+
+    Returns the number of MQTT messages sent.
+    """
+    data = text.encode("utf-8")
+    if len(data) <= chunk_bytes:
+        client.publish(topic, data)
+        return 1
+    chunks = split_utf8(data, chunk_bytes)
+    msg_id = _next_msg_id()
+    for index, chunk in enumerate(chunks):
+        # QoS 1 keeps the chunks in order and complete on a flaky link
+        client.publish(f"{topic}/chunk/{msg_id}/{index}/{len(chunks)}", chunk, qos=1)
+    return len(chunks)
+
+
+def publish_display(client, kind, text, chunk_bytes=DOWNLINK_CHUNK_BYTES):
+    """Publishes a quote or summary ("quote"/"summary") in DOWNLINK_FORMAT.
+
+    Returns the number of MQTT messages sent.
+    """
+    if DOWNLINK_FORMAT != "protobuf":
+        return publish_text(client, _TEXT_TOPICS[kind], text, chunk_bytes)
+    data = text.encode("utf-8")
+    if len(data) <= chunk_bytes:
+        client.publish(wire.TOPIC_DOWNLINK, wire.encode_text(kind, text))
+        return 1
+    chunks = split_utf8(data, chunk_bytes)
+    msg_id = _next_msg_id()
+    for index, chunk in enumerate(chunks):
+        payload = wire.encode_text(kind, chunk.decode("utf-8"), msg_id, index, len(chunks))
+        client.publish(wire.TOPIC_DOWNLINK, payload, qos=1)
+    return len(chunks)
+
+
+def publish_urgency(client, level):
+    """Publishes "LOW", "MEDIUM" or "HIGH" in DOWNLINK_FORMAT."""
+    if DOWNLINK_FORMAT != "protobuf":
+        client.publish(TOPIC_URGENCY_LED, level)
+    else:
+        client.publish(wire.TOPIC_DOWNLINK, wire.encode_urgency(level))
@@ -0,0 +1,6 @@
+#!/bin/sh
+# Regenerates auralink_pb2.py from the schema the firmware compiles with
+# nanopb. Run after editing test/proto/auralink.proto.
+set -e
+cd "$(dirname "$0")"
+protoc --python_out=. -I../test/proto ../test/proto/auralink.proto
@@ -0,0 +1,293 @@
+"""Caches for LLM responses, shared by main.py and main_api.py.
+
+The quote depends only on temperature and humidity, and at a 3 s sample
+cadence consecutive readings rarely differ by more than sensor noise. So
+quotes are cached per (temperature, humidity) bucket: readings in the
+same bucket reuse the quote until it expires (TTL) or is evicted (LRU,
+bounded size). The quote is generated for the bucket's centre value, so
+it fits every reading that maps to it.
+
+Email summary and urgency are memoized by a hash of the email content,
+so the LLM only sees an email once however many sensor readings ask for
+it. The memo also remembers what the device was last sent, so results
+that did not change are not published again.
+
+Concurrent misses on the same key share one LLM call, and its outcome:
+if it fails (None or an exception), the waiters get that failure rather
+than each retrying in turn. Failures are not cached.
+
+Settings (environment):
+  QUOTE_CACHE_TEMP_STEP      bucket width in °C (default 1.0)
+  QUOTE_CACHE_HUMIDITY_STEP  bucket width in %RH (default 5)
+  QUOTE_CACHE_TTL_S          seconds a quote stays fresh (default 900)
+  QUOTE_CACHE_SIZE           buckets kept (default 256; 0 disables the cache)
+  EMAIL_MEMO_SIZE            emails remembered (default 64)
+"""
+import asyncio
+import hashlib
+import os
+import threading
+import time
+from collections import OrderedDict
+
+
+class LruTtlCache:
+    """Bounded LRU map whose entries also expire after ttl_s.
+
+    Each entry remembers how long its value took to produce, so a hit can
+    report the latency it saved. Not thread-safe by itself.
+    """
+
+    def __init__(self, max_entries, ttl_s, clock=time.monotonic):
+        self.max_entries = max_entries
+        self.ttl_s = ttl_s
+        self.clock = clock
+        self._entries = OrderedDict()  # key -> (value, stored_at, cost_s)
+        self.hits = 0
+        self.misses = 0
+        self.expired = 0
+        self.evicted = 0
+        self.produced = 0
+        self.saved_s = 0.0
+        self.miss_cost_s = 0.0   # Time spent producing the values stored
+
+    def get(self, key):
+        """Returns (True, value) on a fresh hit, else (False, None)."""
+        entry = self._entries.get(key)
+        if entry is not None and self.clock() - entry[1] > self.ttl_s:
+            del self._entries[key]
+            self.expired += 1
+            entry = None
+        if entry is None:
+            self.misses += 1
+            return False, None
+        self._entries.move_to_end(key)
+        self.hits += 1
+        self.saved_s += entry[2]
+        return True, entry[0]
+
+    def put(self, key, value, cost_s):
+        self.produced += 1
+        self.miss_cost_s += cost_s
+        if self.max_entries <= 0:
+            return
+        self._entries[key] = (value, self.clock(), cost_s)
+        self._entries.move_to_end(key)
+        while len(self._entries) > self.max_entries:
+            self._entries.popitem(last=False)
+            self.evicted += 1
+
+    def stats(self):
+        lookups = self.hits + self.misses
+        return {
+            "entries": len(self._entries),
+            "lookups": lookups,
+            "hits": self.hits,
+            "misses": self.misses,
+            "hit_rate": round(self.hits / lookups, 3) if lookups else 0.0,
+            "expired": self.expired,
+            "evicted": self.evicted,
+            "latency_saved_s": round(self.saved_s, 2),
+            "mean_miss_latency_ms": round(1000 * self.miss_cost_s / self.produced, 1) if self.produced else 0.0,
+        }
+
+
+def _env_float(name, default):
+    return float(os.getenv(name, default))
+
+
+class _Pending:
+    """One in-flight production; callers that joined it take its outcome."""
+
+    __slots__ = ("done", "value", "error", "cost_s")
+
+    def __init__(self, done):
+        self.done = done  # threading.Event or asyncio.Future
+        self.value = None
+        self.error = None
+        self.cost_s = 0.0
+
+
+class CoalescingCache:
+    """LruTtlCache front end where concurrent misses on a key share one call.
+
+    _get() is for threads (main.py), _get_async() for asyncio (main_api.py).
+    produce() returns the value, or None when it failed. Callers that join
+    an in-flight call get its value, None or exception; `coalesced` counts
+    the ones that got a value.
+    """
+
+    def __init__(self, cache):
+        self.cache = cache
+        self.coalesced = 0
+        self._lock = threading.Lock()
+        self._inflight = {}  # key -> _Pending
+
+    def _shared(self, pending):
+        if pending.error is not None:
+            raise pending.error
+        if pending.value is not None:
+            with self._lock:
+                self.coalesced += 1
+                self.cache.saved_s += pending.cost_s
+        return pending.value
+
+    def _finish(self, key, pending, start):
+        pending.cost_s = time.monotonic() - start
+        with self._lock:
+            if pending.value is not None:
+                self.cache.put(key, pending.value, pending.cost_s)
+            del self._inflight[key]
+
+    def _get(self, key, produce):
+        with self._lock:
+            pending = self._inflight.get(key)
+            if pending is None:
+                hit, value = self.cache.get(key)
+                if hit:
+                    return value
+                pending = self._inflight[key] = _Pending(threading.Event())
+                owner = True
+            else:
+                owner = False
+        if not owner:
+            # Another thread is producing this key; share its outcome
+            pending.done.wait()
+            return self._shared(pending)
+        start = time.monotonic()
+        try:
+            pending.value = produce()
+        except Exception as e:
+            pending.error = e
+            raise
+        finally:
+            self._finish(key, pending, start)
+            pending.done.set()
+        return pending.value
+
+    async def _get_async(self, key, produce):
+        pending = self._inflight.get(key)
+        if pending is not None:
+            await asyncio.shield(pending.done)
+            return self._shared(pending)
+        with self._lock:
+            hit, value = self.cache.get(key)
+        if hit:
+            return value
+        pending = self._inflight[key] = _Pending(asyncio.get_running_loop().create_future())
+        start = time.monotonic()
+        try:
+            pending.value = await produce()
+        except Exception as e:
+            pending.error = e
+            raise
+        finally:
+            # A cancelled call leaves value and error unset: waiters get None
+            self._finish(key, pending, start)
+            pending.done.set_result(None)
+        return pending.value
+
+    def stats(self):
+        with self._lock:
+            return dict(self.cache.stats(), coalesced=self.coalesced)
+
+
+class QuoteCache(CoalescingCache):
+    """Quotes per quantized (temperature, humidity) bucket.
+
+    get_quote() and get_quote_async() take the generator to call on a
+    miss, with the bucket's centre temperature and humidity.
+    """
+
+    def __init__(self, temp_step=None, humidity_step=None, ttl_s=None, max_entries=None, clock=time.monotonic):
+        self.temp_step = temp_step or _env_float("QUOTE_CACHE_TEMP_STEP", 1.0)
+        self.humidity_step = humidity_step or _env_float("QUOTE_CACHE_HUMIDITY_STEP", 5.0)
+        super().__init__(LruTtlCache(
+            int(os.getenv("QUOTE_CACHE_SIZE", 256)) if max_entries is None else max_entries,
+            _env_float("QUOTE_CACHE_TTL_S", 900) if ttl_s is None else ttl_s,
+            clock,
+        ))
+
+    def bucket(self, temp, humidity):
+        """Bucket key and the centre values the quote is generated for."""
+        key = (round(temp / self.temp_step), round(humidity / self.humidity_step))
+        return key, round(key[0] * self.temp_step, 1), round(key[1] * self.humidity_step, 1)
+
+    def get_quote(self, temp, humidity, generate):
+        key, t, h = self.bucket(temp, humidity)
+        return self._get(key, lambda: generate(t, h))
+
+    async def get_quote_async(self, temp, humidity, generate):
+        key, t, h = self.bucket(temp, humidity)
+        return await self._get_async(key, lambda: generate(t, h))
+
+    def stats(self):
+        return dict(super().stats(), temp_step=self.temp_step, humidity_step=self.humidity_step)
+
+    def summary(self):
+        s = self.stats()
+        return (f"Quote cache: {s['hits']}/{s['lookups']} hits ({100 * s['hit_rate']:.0f}%), "
+                f"{s['coalesced']} shared in flight, "
+                f"{s['latency_saved_s']:.1f} s LLM latency saved, {s['entries']} buckets, "
+                f"{s['expired']} expired, {s['evicted']} evicted")
+
+
+def content_hash(text):
+    return hashlib.sha256(text.encode("utf-8")).hexdigest()
+
+
+class EmailMemo(CoalescingCache):
+    """Summary and urgency per email, keyed by a hash of its content.
+
+    Entries do not expire: the same email always gets the same answer.
+    changed() is the publish gate: it is true only when a result differs
+    from what the device was last sent. forget_published() makes the next
+    results go out again, e.g. after a reconnect or a device restart.
+    """
+
+    def __init__(self, max_entries=None, clock=time.monotonic):
+        super().__init__(LruTtlCache(
+            int(os.getenv("EMAIL_MEMO_SIZE", 64)) if max_entries is None else max_entries,
+            float("inf"),
+            clock,
+        ))
+        self._published = {}  # kind -> last value sent to the device
+        self.published = 0
+        self.unchanged = 0
+
+    def summary_for(self, email, summarize):
+        return self._get((content_hash(email), "summary"), lambda: summarize(email))
+
+    def urgency_for(self, email, classify):
+        return self._get((content_hash(email), "urgency"), lambda: classify(email))
+
+    async def summary_for_async(self, email, summarize):
+        return await self._get_async((content_hash(email), "summary"), lambda: summarize(email))
+
+    async def urgency_for_async(self, email, classify):
+        return await self._get_async((content_hash(email), "urgency"), lambda: classify(email))
+
+    def changed(self, kind, value):
+        """True (and remembered as sent) if value differs from the last one sent for kind."""
+        with self._lock:
+            if self._published.get(kind) == value:
+                self.unchanged += 1
+                return False
+            self._published[kind] = value
+            self.published += 1
+            return True
+
+    def forget_published(self):
+        with self._lock:
+            self._published.clear()
+
+    def stats(self):
+        s = super().stats()
+        with self._lock:
+            return dict(s, published=self.published, unchanged_skipped=self.unchanged)
+
+    def summary(self):
+        s = self.stats()
+        return (f"Email memo: {s['hits']}/{s['lookups']} hits ({100 * s['hit_rate']:.0f}%), "
+                f"{s['latency_saved_s']:.1f} s LLM latency saved, {s['entries']} results, "
+                f"{s['unchanged_skipped']} unchanged publishes skipped")
@@ -8,6 +8,11 @@ try:
 except Exception:
     openai = None
 from dotenv import load_dotenv
+from config import TOPIC_SENSOR_DATA, TOPIC_SENSOR_BATCH, TOPIC_UPLINK, TOPIC_DEVICE_RECOVERY
+from downlink import publish_display, publish_urgency
+from llm_cache import EmailMemo, QuoteCache
+from series_codec import decode_batch
+from wire import decode_uplink
 
 # Load environment variables from .env file
 load_dotenv()
@@ -18,12 +23,6 @@ MQTT_BROKER_HOST = os.getenv("MQTT_BROKER_HOST", "test.mosquitto.org")
 MQTT_BROKER_PORT = int(os.getenv("MQTT_BROKER_PORT", 1883))
 OPENAI_API_KEY = os.getenv("OPENAI_API_KEY")
 
-# MQTT Topics
-TOPIC_SENSOR_DATA = "auralink/sensor/data"
-TOPIC_DISPLAY_QUOTE = "auralink/display/quote"
-TOPIC_DISPLAY_SUMMARY = "auralink/display/summary"
-TOPIC_URGENCY_LED = "auralink/urgency/led"
-
 # OpenAI availability check
 if openai is None:
     print("WARNING: openai package not installed. LLM features will be disabled.")
@@ -53,13 +52,19 @@ mock_emails = [
         "body": "Hey sweetie, hope you're having a good week. I was wondering if you're free to come over for dinner on Saturday evening? Let me know if you can make it. Love, Mom."
     }
 ]
-email_index = 0
+MOCK_EMAIL_INTERVAL_S = float(os.getenv("MOCK_EMAIL_INTERVAL_S", 60))  # A new mock email "arrives" this often
+mailbox_started = time.monotonic()
+
+# Quotes per quantized (temperature, humidity) bucket, email results per
+# content hash; see llm_cache.py
+quote_cache = QuoteCache()
+email_memo = EmailMemo()
+CACHE_REPORT_EVERY = 20  # Readings between cache stats lines
 
 def get_latest_email():
-    """Fetches the next mock email in the list, cycling through them."""
-    global email_index
-    email = mock_emails[email_index]
-    email_index = (email_index + 1) % len(mock_emails)
+    """Fetches the newest mock email; the mailbox moves on every MOCK_EMAIL_INTERVAL_S."""
+    arrived = int((time.monotonic() - mailbox_started) / MOCK_EMAIL_INTERVAL_S)
+    email = mock_emails[arrived % len(mock_emails)]
     # Return the full email content for processing
     return f"From: {email['sender']}\nSubject: {email['subject']}\n\n{email['body']}"
 
@@ -94,28 +99,55 @@ def summarize_email(email_content):
     return call_openai_api(prompt)
 
 def analyze_email_urgency(email_content):
-    """Analyzes email urgency and returns LOW, MEDIUM, or HIGH."""
+    """Analyzes email urgency and returns LOW, MEDIUM, or HIGH (None if the API call failed)."""
     print("Analyzing email urgency...")
     prompt = f"Analyze the urgency of the following email. Respond with only ONE word: LOW, MEDIUM, or HIGH.\n\n---\n{email_content}\n---"
     urgency = call_openai_api(prompt, max_tokens=5)
-    if urgency and urgency.upper() in ["LOW", "MEDIUM", "HIGH"]:
+    if urgency is None:
+        return None # Not memoized, so the next reading retries
+    if urgency.upper() in ["LOW", "MEDIUM", "HIGH"]:
         return urgency.upper()
-    return "LOW" # Default to LOW on failure
+    return "LOW" # Default to LOW on an unexpected answer
 
 # --- MQTT Client Logic ---
 def on_connect(client, userdata, flags, rc):
     """Callback for when the client connects to the MQTT broker."""
     if rc == 0:
         print("Connected to MQTT Broker!")
+        # Downlinks are not retained; resend everything once reconnected
+        email_memo.forget_published()
+        client.subscribe(TOPIC_UPLINK)
         client.subscribe(TOPIC_SENSOR_DATA)
-        print(f"Subscribed to topic: {TOPIC_SENSOR_DATA}")
+        client.subscribe(TOPIC_SENSOR_BATCH)
+        client.subscribe(TOPIC_DEVICE_RECOVERY)
+        print(f"Subscribed to topics: {TOPIC_UPLINK}, {TOPIC_SENSOR_DATA}, {TOPIC_SENSOR_BATCH}, "
+              f"{TOPIC_DEVICE_RECOVERY}")
     else:
         print(f"Failed to connect, return code {rc}\n")
 
 def process_sensor_data(payload_str):
-    """The main processing logic for incoming sensor data."""
+    """Handles a legacy JSON sensor payload."""
     try:
         data = json.loads(payload_str)
+    except json.JSONDecodeError:
+        print("Error decoding JSON payload.")
+        return
+    process_reading(data)
+
+
+def process_sensor_uplink(payload):
+    """Handles a protobuf Uplink (test/proto/auralink.proto)."""
+    try:
+        data = decode_uplink(payload)
+    except ValueError as e:
+        print(f"Invalid uplink: {e}")
+        return
+    process_reading(data)
+
+
+def process_reading(data):
+    """The main processing logic for incoming sensor data."""
+    try:
         temp = data.get("temperature")
         humidity = data.get("humidity")
 
@@ -125,33 +157,78 @@ def process_sensor_data(payload_str):
 
         print(f"Received Sensor Data -> Temp: {temp}°C, Humidity: {humidity}%")
         
-        # 1. Get a new quote
-        quote = generate_literary_quote(temp, humidity)
+        # 1. Get a quote: cached per sensor bucket, generated on a miss
+        quote = quote_cache.get_quote(temp, humidity, generate_literary_quote)
         if quote:
-            client.publish(TOPIC_DISPLAY_QUOTE, quote)
-            print(f"Published to `{TOPIC_DISPLAY_QUOTE}`: {quote}")
-
-        # 2. Get and process the latest email
+            publish_display(client, "quote", quote)
+            print(f"Published quote: {quote}")
+        if quote_cache.stats()["lookups"] % CACHE_REPORT_EVERY == 0:
+            print(quote_cache.summary())
+            print(email_memo.summary())
+
+        # 2. Get the latest email; the LLM only sees each email once, and
+        # the device only hears about results that changed
         email_content = get_latest_email()
-        summary = summarize_email(email_content)
-        urgency = analyze_email_urgency(email_content)
+        summary = email_memo.summary_for(email_content, summarize_email)
+        urgency = email_memo.urgency_for(email_content, analyze_email_urgency)
 
-        if summary:
-            client.publish(TOPIC_DISPLAY_SUMMARY, summary)
-            print(f"Published to `{TOPIC_DISPLAY_SUMMARY}`: {summary}")
+        if summary and email_memo.changed("summary", summary):
+            publish_display(client, "summary", summary)
+            print(f"Published summary: {summary}")
         
-        if urgency:
-            client.publish(TOPIC_URGENCY_LED, urgency)
-            print(f"Published to `{TOPIC_URGENCY_LED}`: {urgency}")
+        if urgency and email_memo.changed("urgency", urgency):
+            publish_urgency(client, urgency)
+            print(f"Published urgency: {urgency}")
 
-    except json.JSONDecodeError:
-        print("Error decoding JSON payload.")
     except Exception as e:
         print(f"An error occurred in process_sensor_data: {e}")
 
 
+def process_device_recovery(payload_str):
+    """Handles the record a device sends on every boot; after a cold boot
+    its display is blank, so the email results are republished."""
+    try:
+        record = json.loads(payload_str)
+    except json.JSONDecodeError:
+        print("Error decoding recovery record.")
+        return
+    if not record.get("warm", False):
+        print(f"Device cold-booted ({record.get('reset_reason')}); republishing email results")
+        email_memo.forget_published()
+
+
+def process_sensor_batch(payload):
+    """Decodes a compressed backlog batch; only the newest sample drives the display."""
+    try:
+        samples = decode_batch(payload)
+    except ValueError as e:
+        print(f"Invalid sensor batch: {e}")
+        return
+    if not samples:
+        return
+    print(f"Received batch of {len(samples)} samples ({len(payload)} bytes), "
+          f"seq {samples[0]['seq']}..{samples[-1]['seq']}")
+    latest = samples[-1]
+    process_reading({
+        "temperature": round(latest["temperature"], 1),
+        "humidity": round(latest["humidity"], 1),
+        "light_percent": latest["light_percent"],
+        "nox_percent": latest["nox_percent"],
+        "seq": latest["seq"],
+    })
+
+
 def on_message(client, userdata, msg):
     """Callback for when a message is received from the broker."""
+    if msg.topic == TOPIC_UPLINK:
+        threading.Thread(target=process_sensor_uplink, args=(msg.payload,)).start()
+        return
+    if msg.topic == TOPIC_SENSOR_BATCH:
+        threading.Thread(target=process_sensor_batch, args=(msg.payload,)).start()
+        return
+    if msg.topic == TOPIC_DEVICE_RECOVERY:
+        process_device_recovery(msg.payload.decode('utf-8', errors='replace'))
+        return
     payload_str = msg.payload.decode('utf-8')
     # Use a thread to process the data to avoid blocking the MQTT loop
     processing_thread = threading.Thread(target=process_sensor_data, args=(payload_str,))
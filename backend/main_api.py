@@ -4,12 +4,18 @@ from fastapi.responses import FileResponse
 import asyncio
 import json
 import os
+import time
 import logging
 from typing import List, Dict, Any
 from pydantic import BaseModel
 import paho.mqtt.client as mqtt
 import httpx
 from dotenv import load_dotenv
+from config import (TOPIC_SENSOR_DATA, TOPIC_DISPLAY_QUOTE as TOPIC_QUOTE,
+                    TOPIC_DISPLAY_SUMMARY as TOPIC_SUMMARY, TOPIC_URGENCY_LED as TOPIC_URGENCY,
+                    TOPIC_DEVICE_RECOVERY)
+from downlink import publish_display, publish_urgency
+from llm_cache import EmailMemo, QuoteCache
 
 # Configure logging
 logging.basicConfig(level=logging.INFO)
@@ -49,12 +55,7 @@ app.mount("/static", StaticFiles(directory=STATIC_DIR), name="static")
 # WebSocket connections store
 active_connections: List[WebSocket] = []
 
-# MQTT Topics
-TOPIC_SENSOR_DATA = "auralink/sensor/data"
-TOPIC_QUOTE = "auralink/display/quote"
-TOPIC_SUMMARY = "auralink/display/summary"
-TOPIC_URGENCY = "auralink/urgency/led"
-
+# MQTT topics (config.py) key the WebSocket message types below
 # Pydantic model for sensor data
 class SensorData(BaseModel):
     temperature: float
@@ -131,15 +132,20 @@ MOCK_EMAILS = [
 ]
 
 # Global variables
-current_email_index = 0
+MOCK_EMAIL_INTERVAL_S = float(os.getenv("MOCK_EMAIL_INTERVAL_S", 60))  # A new mock email "arrives" this often
+mailbox_started = time.monotonic()
 mqtt_client = mqtt.Client()
 
+# Quotes per quantized (temperature, humidity) bucket, email results per
+# content hash; see llm_cache.py
+quote_cache = QuoteCache()
+email_memo = EmailMemo()
+CACHE_REPORT_EVERY = 20  # Requests between cache stats log lines
+
 def get_latest_email() -> str:
-    """Simulate getting the latest email by cycling through mock emails."""
-    global current_email_index
-    email = MOCK_EMAILS[current_email_index]
-    current_email_index = (current_email_index + 1) % len(MOCK_EMAILS)
-    return email
+    """Simulate the newest email; the mailbox moves on every MOCK_EMAIL_INTERVAL_S."""
+    arrived = int((time.monotonic() - mailbox_started) / MOCK_EMAIL_INTERVAL_S)
+    return MOCK_EMAILS[arrived % len(MOCK_EMAILS)]
 
 async def generate_literary_quote(temp: float, humidity: float) -> str:
     """Generate a literary-style quote based on temperature and humidity."""
@@ -202,14 +208,32 @@ def on_mqtt_connect(client, userdata, flags, rc):
     """Callback for when the client receives a CONNACK response from the server."""
     if rc == 0:
         logger.info("Connected to MQTT broker")
+        # Downlinks are not retained; resend everything once reconnected
+        email_memo.forget_published()
+        client.subscribe(TOPIC_DEVICE_RECOVERY)
     else:
         logger.error(f"Failed to connect to MQTT broker with code: {rc}")
 
+def on_mqtt_message(client, userdata, msg):
+    """Boot records (auralink/device/recovery): a cold-booted device has a
+    blank display, so the next reading republishes the email results."""
+    if msg.topic != TOPIC_DEVICE_RECOVERY:
+        return
+    try:
+        record = json.loads(msg.payload)
+    except ValueError:
+        logger.warning("Invalid recovery record")
+        return
+    if not record.get("warm", False):
+        logger.info(f"Device cold-booted ({record.get('reset_reason')}); republishing email results")
+        email_memo.forget_published()
+
 @app.on_event("startup")
 async def startup_event():
     """Initialize MQTT client on startup."""
     try:
         mqtt_client.on_connect = on_mqtt_connect
+        mqtt_client.on_message = on_mqtt_message
         mqtt_client.connect(MQTT_BROKER_HOST, MQTT_BROKER_PORT)
         mqtt_client.loop_start()
         logger.info("MQTT client initialized")
@@ -234,17 +258,23 @@ async def process_sensor_data(data: SensorData):
         # Get the latest email
         email = get_latest_email()
         
-        # Process all tasks concurrently
+        # Process all tasks concurrently; the email results are memoized
+        # per email, so the LLM only sees a new email once
         quote, summary, urgency = await asyncio.gather(
-            generate_literary_quote(data.temperature, data.humidity),
-            summarize_email(email),
-            analyze_email_urgency(email)
+            quote_cache.get_quote_async(data.temperature, data.humidity, generate_literary_quote),
+            email_memo.summary_for_async(email, summarize_email),
+            email_memo.urgency_for_async(email, analyze_email_urgency)
         )
         
-        # Publish results to MQTT topics
-        mqtt_client.publish(TOPIC_QUOTE, quote)
-        mqtt_client.publish(TOPIC_SUMMARY, summary)
-        mqtt_client.publish(TOPIC_URGENCY, urgency)
+        # Publish results to MQTT topics; unchanged email results are not resent
+        publish_display(mqtt_client, "quote", quote)
+        if email_memo.changed("summary", summary):
+            publish_display(mqtt_client, "summary", summary)
+        if email_memo.changed("urgency", urgency):
+            publish_urgency(mqtt_client, urgency)
+        if quote_cache.stats()["lookups"] % CACHE_REPORT_EVERY == 0:
+            logger.info(quote_cache.summary())
+            logger.info(email_memo.summary())
         
         return {"message": "Data processed successfully"}
     
@@ -254,6 +284,11 @@ async def process_sensor_data(data: SensorData):
             detail=str(e)
         )
 
+@app.get("/cache")
+async def get_cache_stats():
+    """Hit rate and LLM latency saved by the response caches."""
+    return {"quote": quote_cache.stats(), "email": email_memo.stats()}
+
 # For development server
 if __name__ == "__main__":
     import uvicorn
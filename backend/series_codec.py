@@ -0,0 +1,124 @@
+"""Decoder for the device's compressed sample batches (auralink/sensor/batch).
+
+The format is documented in test/include/series_codec.h: delta-of-delta
+timestamps, XOR-compressed float temperature/humidity and zig-zag varint
+deltas for the integer fields, Gorilla style.
+"""
+import struct
+
+TOPIC_SENSOR_BATCH = "auralink/sensor/batch"
+
+_HEADER = struct.Struct("<2sBBHII")
+VERSION = 1
+
+
+class _Bits:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def read(self, n):
+        value = 0
+        for _ in range(n):
+            byte = self.pos >> 3
+            if byte >= len(self.data):
+                raise ValueError("batch truncated")
+            value = (value << 1) | ((self.data[byte] >> (7 - (self.pos & 7))) & 1)
+            self.pos += 1
+        return value
+
+    def varint(self):
+        value = shift = 0
+        while True:
+            group = self.read(8)
+            value |= (group & 0x7F) << shift
+            shift += 7
+            if not group & 0x80:
+                return value
+            if shift > 35:
+                raise ValueError("varint too long")
+
+    def zigzag(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+    def signed(self, n):
+        v = self.read(n)
+        return v - (1 << n) if v & (1 << (n - 1)) else v
+
+
+class _XorFloat:
+    def __init__(self, bits):
+        self.bits = bits
+        self.leading = None
+        self.trailing = 0
+
+    def next(self, r):
+        if r.read(1) == 0:
+            return self.bits
+        if r.read(1) == 0:
+            if self.leading is None:
+                raise ValueError("window reuse before any window")
+            length = 32 - self.leading - self.trailing
+        else:
+            self.leading = r.read(5)
+            length = r.read(5) + 1
+            self.trailing = 32 - self.leading - length
+            if self.trailing < 0:
+                raise ValueError("bad XOR window")
+        self.bits ^= r.read(length) << self.trailing
+        return self.bits
+
+
+def _float(bits):
+    return struct.unpack("<f", struct.pack("<I", bits & 0xFFFFFFFF))[0]
+
+
+# Delta-of-delta payload width after the '10', '110', '1110', '1111' prefixes
+_DOD_WIDTHS = (7, 9, 12, 32)
+
+
+def decode_batch(data):
+    """Returns the samples in the batch as dicts, oldest first."""
+    if len(data) < _HEADER.size:
+        raise ValueError("batch too short")
+    magic, version, _flags, count, seq, ts = _HEADER.unpack_from(data)
+    if magic != b"AG" or version != VERSION:
+        raise ValueError("not a version %d sample batch" % VERSION)
+    r = _Bits(data[_HEADER.size:])
+    samples = []
+    if count == 0:
+        return samples
+    temp = _XorFloat(r.read(32))
+    hum = _XorFloat(r.read(32))
+    light = r.varint()
+    nox = r.varint()
+    pir = r.read(1)
+    delta = 0
+    for i in range(count):
+        if i > 0:
+            seq = (seq + r.zigzag() + 1) & 0xFFFFFFFF
+            if i == 1:
+                delta = r.zigzag()
+            else:
+                prefix = 0
+                while prefix < 4 and r.read(1):
+                    prefix += 1
+                if prefix:
+                    delta += r.signed(_DOD_WIDTHS[prefix - 1])
+            ts = (ts + delta) & 0xFFFFFFFF
+            temp.next(r)
+            hum.next(r)
+            light += r.zigzag()
+            nox += r.zigzag()
+            pir = r.read(1)
+        samples.append({
+            "seq": seq,
+            "timestamp_ms": ts,
+            "temperature": _float(temp.bits),
+            "humidity": _float(hum.bits),
+            "light_percent": light,
+            "nox_percent": nox,
+            "pir": pir,
+        })
+    return samples
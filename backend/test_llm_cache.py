@@ -0,0 +1,274 @@
+"""Tests for llm_cache.py; run with `python -m pytest test_llm_cache.py`.
+
+No broker, network or API key needed: producers are local functions and
+time comes from a fake clock.
+"""
+import asyncio
+import threading
+import time
+
+import pytest
+
+from llm_cache import EmailMemo, LruTtlCache, QuoteCache, content_hash
+
+
+class FakeClock:
+    def __init__(self):
+        self.now = 1000.0
+
+    def __call__(self):
+        return self.now
+
+
+# --- LruTtlCache ---
+
+def test_entry_expires_after_ttl():
+    clock = FakeClock()
+    cache = LruTtlCache(max_entries=4, ttl_s=10, clock=clock)
+    cache.put("k", "v", cost_s=0.5)
+    clock.now += 10
+    assert cache.get("k") == (True, "v")
+    clock.now += 0.1
+    assert cache.get("k") == (False, None)
+    assert cache.expired == 1
+    assert cache.stats()["entries"] == 0
+
+
+def test_lru_evicts_least_recently_used():
+    cache = LruTtlCache(max_entries=2, ttl_s=60, clock=FakeClock())
+    cache.put("a", 1, cost_s=0)
+    cache.put("b", 2, cost_s=0)
+    cache.get("a")  # b is now the oldest
+    cache.put("c", 3, cost_s=0)
+    assert cache.get("b") == (False, None)
+    assert cache.get("a") == (True, 1)
+    assert cache.get("c") == (True, 3)
+    assert cache.evicted == 1
+
+
+def test_zero_size_disables_storage():
+    cache = LruTtlCache(max_entries=0, ttl_s=60, clock=FakeClock())
+    cache.put("k", "v", cost_s=1.0)
+    assert cache.get("k") == (False, None)
+    assert cache.stats()["mean_miss_latency_ms"] == 1000.0
+
+
+def test_hit_reports_saved_latency():
+    cache = LruTtlCache(max_entries=4, ttl_s=60, clock=FakeClock())
+    cache.put("k", "v", cost_s=2.0)
+    cache.get("k")
+    cache.get("k")
+    assert cache.stats()["latency_saved_s"] == 4.0
+
+
+# --- QuoteCache buckets ---
+
+def test_bucket_edges():
+    quotes = QuoteCache(temp_step=1.0, humidity_step=5.0, ttl_s=60, max_entries=8)
+    assert quotes.bucket(20.4, 47.4) == ((20, 9), 20.0, 45.0)
+    assert quotes.bucket(19.6, 42.6) == ((20, 9), 20.0, 45.0)
+    assert quotes.bucket(20.6, 47.4)[0] == (21, 9)
+    assert quotes.bucket(20.4, 47.6)[0] == (20, 10)
+    assert quotes.bucket(-0.4, 0.0) == ((0, 0), 0.0, 0.0)
+
+
+def test_same_bucket_reuses_quote_for_centre_values():
+    quotes = QuoteCache(temp_step=1.0, humidity_step=5.0, ttl_s=60, max_entries=8)
+    asked = []
+
+    def generate(t, h):
+        asked.append((t, h))
+        return f"quote {t} {h}"
+
+    assert quotes.get_quote(20.3, 49.0, generate) == "quote 20.0 50.0"
+    assert quotes.get_quote(19.8, 51.0, generate) == "quote 20.0 50.0"
+    assert asked == [(20.0, 50.0)]
+    assert quotes.stats()["hits"] == 1
+
+
+def test_quote_expires_and_is_regenerated():
+    clock = FakeClock()
+    quotes = QuoteCache(ttl_s=60, max_entries=8, clock=clock)
+    calls = []
+    quotes.get_quote(20, 50, lambda t, h: calls.append(1) or "q")
+    clock.now += 61
+    quotes.get_quote(20, 50, lambda t, h: calls.append(1) or "q")
+    assert len(calls) == 2
+
+
+# --- Coalescing ---
+
+def run_concurrently(n, call, produce_started, release):
+    """Starts one owner, waits for its produce() to begin, then n - 1 joiners."""
+    results = [None] * n
+
+    def worker(i):
+        try:
+            results[i] = call()
+        except Exception as e:  # Collected for the assertions
+            results[i] = e
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(n)]
+    threads[0].start()
+    assert produce_started.wait(2)
+    for t in threads[1:]:
+        t.start()
+    time.sleep(0.1)  # Let the joiners reach the in-flight wait
+    release.set()
+    for t in threads:
+        t.join(2)
+    return results
+
+
+def test_concurrent_misses_share_one_call():
+    quotes = QuoteCache(ttl_s=60, max_entries=8)
+    started, release = threading.Event(), threading.Event()
+    calls = []
+
+    def generate(t, h):
+        calls.append((t, h))
+        started.set()
+        release.wait(2)
+        return "shared"
+
+    results = run_concurrently(8, lambda: quotes.get_quote(20, 50, generate), started, release)
+    assert results == ["shared"] * 8
+    assert len(calls) == 1
+    s = quotes.stats()
+    assert s["coalesced"] + s["hits"] == 7
+
+
+def test_concurrent_async_misses_share_one_call():
+    quotes = QuoteCache(ttl_s=60, max_entries=8)
+    calls = []
+
+    async def generate(t, h):
+        calls.append((t, h))
+        await asyncio.sleep(0.01)
+        return "shared"
+
+    async def main():
+        return await asyncio.gather(*(quotes.get_quote_async(20, 50, generate) for _ in range(8)))
+
+    assert asyncio.run(main()) == ["shared"] * 8
+    assert len(calls) == 1
+    assert quotes.stats()["coalesced"] == 7
+
+
+def test_failure_reaches_every_waiter_and_is_not_cached():
+    quotes = QuoteCache(ttl_s=60, max_entries=8)
+    started, release = threading.Event(), threading.Event()
+    calls = []
+
+    def failing(t, h):
+        calls.append(1)
+        started.set()
+        release.wait(2)
+        raise RuntimeError("LLM down")
+
+    results = run_concurrently(4, lambda: quotes.get_quote(20, 50, failing), started, release)
+    assert all(isinstance(r, RuntimeError) for r in results)
+    assert len(calls) == 1
+    assert quotes.stats()["coalesced"] == 0
+    assert quotes.get_quote(20, 50, lambda t, h: "recovered") == "recovered"
+
+
+def test_none_result_is_shared_and_not_cached():
+    quotes = QuoteCache(ttl_s=60, max_entries=8)
+    started, release = threading.Event(), threading.Event()
+    calls = []
+
+    def unavailable(t, h):
+        calls.append(1)
+        started.set()
+        release.wait(2)
+        return None
+
+    results = run_concurrently(4, lambda: quotes.get_quote(20, 50, unavailable), started, release)
+    assert results == [None] * 4
+    assert len(calls) == 1
+    assert quotes.stats()["entries"] == 0
+    assert quotes.get_quote(20, 50, lambda t, h: "recovered") == "recovered"
+
+
+def test_async_failure_reaches_every_waiter():
+    quotes = QuoteCache(ttl_s=60, max_entries=8)
+    calls = []
+
+    async def failing(t, h):
+        calls.append(1)
+        await asyncio.sleep(0.01)
+        raise RuntimeError("LLM down")
+
+    async def main():
+        return await asyncio.gather(*(quotes.get_quote_async(20, 50, failing) for _ in range(4)),
+                                    return_exceptions=True)
+
+    results = asyncio.run(main())
+    assert all(isinstance(r, RuntimeError) for r in results)
+    assert len(calls) == 1
+    assert quotes.stats()["entries"] == 0
+
+
+# --- EmailMemo ---
+
+def test_email_results_are_keyed_by_content_hash():
+    memo = EmailMemo(max_entries=8)
+    calls = []
+
+    def summarize(email):
+        calls.append(email)
+        return f"summary of {email}"
+
+    first = "From: a\nSubject: hi\n\nbody"
+    assert memo.summary_for(first, summarize) == f"summary of {first}"
+    assert memo.summary_for("".join(list(first)), summarize) == f"summary of {first}"  # Equal content, new object
+    assert memo.summary_for(first + " ", summarize) == f"summary of {first} "
+    assert len(calls) == 2
+    assert (content_hash(first), "summary") in memo.cache._entries
+
+
+def test_summary_and_urgency_are_memoized_separately():
+    memo = EmailMemo(max_entries=8)
+    assert memo.summary_for("email", lambda e: "summary") == "summary"
+    assert memo.urgency_for("email", lambda e: "HIGH") == "HIGH"
+    assert memo.urgency_for("email", lambda e: pytest.fail("urgency asked twice")) == "HIGH"
+
+
+def test_changed_suppresses_a_repeat_until_forgotten():
+    memo = EmailMemo(max_entries=8)
+    assert memo.changed("summary", "s1")
+    assert not memo.changed("summary", "s1")
+    assert memo.changed("urgency", "s1")  # Kinds are gated independently
+    assert memo.changed("summary", "s2")
+    memo.forget_published()
+    assert memo.changed("summary", "s2")
+    assert memo.stats()["unchanged_skipped"] == 1
+
+
+def test_none_result_is_not_memoized():
+    memo = EmailMemo(max_entries=8)
+    calls = []
+
+    def classify(email):
+        calls.append(email)
+        return None if len(calls) == 1 else "MEDIUM"
+
+    assert memo.urgency_for("email", classify) is None
+    assert memo.urgency_for("email", classify) == "MEDIUM"  # The next reading retries
+    assert memo.urgency_for("email", classify) == "MEDIUM"
+    assert len(calls) == 2
+
+
+def test_async_results_share_the_memo():
+    memo = EmailMemo(max_entries=8)
+
+    async def summarize(email):
+        return "async summary"
+
+    assert asyncio.run(memo.summary_for_async("email", summarize)) == "async summary"
+    assert memo.summary_for("email", lambda e: pytest.fail("summarized twice")) == "async summary"
+
+
+if __name__ == "__main__":
+    raise SystemExit(pytest.main([__file__, "-q"]))
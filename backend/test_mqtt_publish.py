@@ -1,3 +1,7 @@
+# Single simulated device publishing legacy JSON every 2 s; a quick smoke
+# test of the backend. For load (thousands of devices, latency percentiles,
+# broker throughput) use the native fleet generator: test/src/native/fleet_main.cpp
+# (`pio run -e native-fleet` in test/).
 import paho.mqtt.client as mqtt
 import json
 import time
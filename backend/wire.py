@@ -0,0 +1,74 @@
+"""Protobuf wire format shared with the firmware (test/proto/auralink.proto).
+
+Uplinks arrive on auralink/pb/uplink, downlinks go out on
+auralink/pb/downlink. auralink_pb2 is generated by gen_proto.sh.
+"""
+import auralink_pb2 as pb
+from config import TOPIC_UPLINK, TOPIC_DOWNLINK  # noqa: F401  (re-exported for callers)
+
+SCHEMA_VERSION = pb.SCHEMA_V1
+
+URGENCY_LEVELS = {
+    "LOW": pb.URGENCY_LOW,
+    "MEDIUM": pb.URGENCY_MEDIUM,
+    "HIGH": pb.URGENCY_HIGH,
+}
+
+
+def decode_uplink(payload):
+    """Decodes an Uplink into the same dict shape as the JSON sensor payload.
+
+    Raises ValueError on malformed input or a schema newer than ours.
+    """
+    msg = pb.Uplink()
+    try:
+        msg.ParseFromString(payload)
+    except Exception as e:
+        raise ValueError(f"malformed uplink: {e}") from e
+    if msg.schema == pb.SCHEMA_UNSPECIFIED or msg.schema > SCHEMA_VERSION:
+        raise ValueError(f"unsupported schema {msg.schema}")
+    if not msg.HasField("reading"):
+        raise ValueError("uplink without a reading")
+    r = msg.reading
+    return {
+        "temperature": round(r.temperature, 1),
+        "humidity": round(r.humidity, 1),
+        "light_percent": r.light_percent,
+        "nox_percent": r.nox_percent,
+        "pir": r.pir,
+        "seq": r.seq,
+        "timestamp_ms": r.timestamp_ms,
+    }
+
+
+def encode_text(kind, chunk, msg_id=0, index=0, count=0):
+    """Encodes one display text downlink; kind is "quote" or "summary".
+
+    count 0 means `chunk` is the whole text, otherwise it is piece `index`
+    of `count` pieces sharing `msg_id`.
+    """
+    msg = pb.Downlink(schema=SCHEMA_VERSION)
+    text = getattr(msg, kind)
+    text.SetInParent()  # Present even when the text is empty
+    text.msg_id = msg_id
+    text.index = index
+    text.count = count
+    text.text = chunk
+    return msg.SerializeToString()
+
+
+def encode_urgency(level):
+    """Encodes an urgency downlink from "LOW", "MEDIUM" or "HIGH"."""
+    msg = pb.Downlink(schema=SCHEMA_VERSION)
+    msg.urgency.SetInParent()
+    msg.urgency.level = URGENCY_LEVELS.get(level.upper(), pb.URGENCY_LOW)
+    return msg.SerializeToString()
+
+
+def encode_rules(program):
+    """Encodes a rules program (text or binary bytes) downlink.
+
+    `rules` sits in the Downlink `body` oneof, so even an empty program is
+    sent as a present body.
+    """
+    return pb.Downlink(schema=SCHEMA_VERSION, rules=program).SerializeToString()
@@ -0,0 +1,22 @@
+#!/bin/sh
+# Generates a throwaway CA and a server certificate for the local TLS
+# broker. Usage: ./gen-certs.sh [broker-hostname]
+set -e
+
+HOST="${1:-auralink-broker.local}"
+DIR="$(dirname "$0")/certs"
+mkdir -p "$DIR"
+cd "$DIR"
+
+openssl req -x509 -newkey rsa:2048 -nodes -days 825 \
+  -keyout ca.key -out ca.crt -subj "/CN=AuraLink Test CA"
+
+openssl req -newkey rsa:2048 -nodes \
+  -keyout server.key -out server.csr -subj "/CN=$HOST"
+
+printf "subjectAltName=DNS:%s\n" "$HOST" > server.ext
+openssl x509 -req -in server.csr -CA ca.crt -CAkey ca.key -CAcreateserial \
+  -days 825 -out server.crt -extfile server.ext
+
+rm -f server.csr server.ext
+echo "Certificates for $HOST written to $DIR"
@@ -14,4 +14,72 @@ env.Append(
         "#include",
         "#lib",
     ]
-)
\ No newline at end of file
+)
+# ------------------------------------------------------------------
+# --- Static memory budget (tools/mem_report.py) ---
+# ------------------------------------------------------------------
+#   pio run -t memreport   per-library / per-symbol RAM and flash report
+# With custom_mem_enforce = yes the same check runs after every link and
+# fails the build when custom_mem_budgets / custom_mem_lib_budgets are
+# exceeded. The full report lands in $BUILD_DIR/memory_report.json.
+import os
+import sys
+
+sys.path.insert(0, os.path.join(env.subst("$PROJECT_DIR"), "tools"))
+import mem_report  # noqa: E402
+
+MAP_FILE = "$BUILD_DIR/${PROGNAME}.map"
+env.Append(LINKFLAGS=["-Wl,-Map=" + MAP_FILE])
+
+
+def _budgets(option):
+    # One "name = bytes" per line
+    budgets = {}
+    for line in env.GetProjectOption(option, "").splitlines():
+        key, _, value = line.partition("=")
+        if key.strip() and value.strip():
+            budgets[key.strip()] = int(value.strip(), 0)
+    return budgets
+
+
+def memory_report(target, source, env):
+    failures = mem_report.run(
+        env.subst(MAP_FILE),
+        top=int(env.GetProjectOption("custom_mem_report_top", "20")),
+        json_path=env.subst("$BUILD_DIR/memory_report.json"),
+        region_budgets=_budgets("custom_mem_budgets"),
+        lib_budgets=_budgets("custom_mem_lib_budgets"),
+    )
+    return 1 if failures else 0
+
+
+env.AddCustomTarget(
+    name="memreport",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions=memory_report,
+    title="Memory Report",
+    description="RAM/flash per library and symbol from the linker map; fails over budget",
+)
+
+if env.GetProjectOption("custom_mem_enforce", "no").lower() in ("yes", "true", "1"):
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", memory_report)
+
+# ------------------------------------------------------------------
+# --- QEMU end-to-end tests (tools/qemu_test.py) ---
+# ------------------------------------------------------------------
+#   pio run -e esp32-qemu -t qemu-test
+# Boots the image in qemu-system-xtensa against a local mosquitto and
+# writes the scenario results to $BUILD_DIR/qemu_results.json.
+if env.GetProjectOption("custom_qemu_test", "no").lower() in ("yes", "true", "1"):
+    env.AddCustomTarget(
+        name="qemu-test",
+        dependencies="$BUILD_DIR/${PROGNAME}.bin",
+        actions=" ".join([
+            env.GetProjectOption("custom_qemu_python", "python3"),
+            os.path.join("$PROJECT_DIR", "tools", "qemu_test.py"),
+            "--build-dir", "$BUILD_DIR",
+            "--json", "$BUILD_DIR/qemu_results.json",
+        ]),
+        title="QEMU Test",
+        description="Publish cadence, downlink and reconnect scenarios in QEMU with a local broker",
+    )
@@ -0,0 +1,60 @@
+# ------------------------------------------------------------------
+# --- Native fuzzers (src/native/fuzz/, envs fuzz-*) ---
+# ------------------------------------------------------------------
+#   pio run -e fuzz-rules -t fuzz    build, then fuzz for custom_fuzz_seconds
+# Seeds are read from fuzz/corpus/<target>/ (tools/fuzz_corpus.py) and new
+# inputs go to $BUILD_DIR/corpus. Crashes, timeouts and slow inputs land
+# in $BUILD_DIR as crash-*, timeout-* and slow-* files; pass one to the
+# program to reproduce it.
+#
+# With clang this is libFuzzer + ASan + UBSan. Without clang the harness
+# is built with gcc's sanitizers and its standalone main, and the `fuzz`
+# target only replays the seed corpus (a regression run, no search).
+import os
+import shutil
+
+Import("env")
+
+target = env.GetProjectOption("custom_fuzz_target")
+libfuzzer = shutil.which("clang++") is not None and \
+    env.GetProjectOption("custom_fuzz_engine", "libfuzzer") == "libfuzzer"
+
+sanitizers = ["-fsanitize=address,undefined", "-fno-sanitize-recover=undefined", "-fno-omit-frame-pointer"]
+if libfuzzer:
+    env.Replace(CC="clang", CXX="clang++", LINK="clang++")
+    sanitizers[0] = "-fsanitize=fuzzer,address,undefined"
+else:
+    print("fuzz: clang++ not found, building the standalone corpus replay instead of libFuzzer")
+    env.Append(CPPDEFINES=["AURALINK_FUZZ_STANDALONE"])
+env.Append(CCFLAGS=sanitizers, LINKFLAGS=sanitizers)
+
+seeds = os.path.join("$PROJECT_DIR", "fuzz", "corpus", target)
+work = os.path.join("$BUILD_DIR", "corpus")
+runner = [
+    "AURALINK_FUZZ_ARTIFACTS=$BUILD_DIR",
+    "AURALINK_FUZZ_SLOW_US=" + env.GetProjectOption("custom_fuzz_slow_us", "20000"),
+    "$BUILD_DIR/${PROGNAME}${PROGSUFFIX}",
+]
+if libfuzzer:
+    dictionary = env.GetProjectOption("custom_fuzz_dict", "")
+    runner += [
+        "-max_total_time=" + env.GetProjectOption("custom_fuzz_seconds", "60"),
+        "-timeout=" + env.GetProjectOption("custom_fuzz_timeout", "2"),
+        "-report_slow_units=1",
+        "-print_final_stats=1",
+        "-artifact_prefix=$BUILD_DIR/",
+    ]
+    if dictionary:
+        runner.append("-dict=" + os.path.join("$PROJECT_DIR", dictionary))
+    runner += [work, seeds]
+    actions = ["mkdir -p " + work, " ".join(runner)]
+else:
+    actions = [" ".join(runner + [seeds])]
+
+env.AddCustomTarget(
+    name="fuzz",
+    dependencies="$BUILD_DIR/${PROGNAME}${PROGSUFFIX}",
+    actions=actions,
+    title="Fuzz",
+    description="libFuzzer over fuzz/corpus/%s with per-input time budget" % target,
+)
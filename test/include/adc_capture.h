@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "capture_codec.h"
+
+// ------------------------------------------------------------------
+// --- High-Rate Raw ADC Capture ---
+// ------------------------------------------------------------------
+// Streams raw 12-bit samples from LDR_AO (GPIO34, ADC1_CH6) and NOX_PIN
+// (GPIO35, ADC1_CH7) for field noise analysis. The I2S peripheral drives
+// ADC1 in scan mode and DMAs conversions into a ring of descriptors; a
+// reader task demultiplexes them into frames and delta-encodes each
+// CAPTURE_BLOCK_FRAMES into one of CAPTURE_SLOTS block buffers, and a
+// sink task writes finished blocks to LittleFS, TCP or UDP. The two tasks
+// only exchange slot indices, so a slow sink never stalls the DMA: when
+// every slot is busy the block is dropped and counted instead.
+//
+// While a capture runs ADC1 belongs to I2S; the sensor task reads the
+// latest captured values (captureLatest) instead of analogRead().
+
+#define CAPTURE_SLOTS 6                  // Encoded blocks in flight (~6 KB)
+#define CAPTURE_DMA_BUFFERS 8
+#define CAPTURE_DMA_SAMPLES 512          // Per DMA descriptor
+#define CAPTURE_FILE_PATH "/capture.bin"
+#define CAPTURE_CONNECT_TIMEOUT_MS 3000
+
+// Creates the (idle) reader and sink tasks
+void captureBegin();
+
+// Starts or stops a capture; runs on the network task. False with a
+// message in err when the request cannot be honoured.
+bool captureControl(const CaptureRequest& req, char* err, size_t errLen);
+
+bool captureActive();
+
+// Latest captured LDR_AO / NOX_PIN values; false when no capture runs
+bool captureLatest(uint16_t& ldr, uint16_t& nox);
+
+// {"state":"running","sink":"udp","rate":4000,"frames":...}
+size_t captureFormatJson(char* buf, size_t len);
+
+// Reads the last file capture for the HTTP server; 0 at the end or
+// while a file capture is being written
+size_t captureReadFile(uint32_t offset, char* buf, size_t len);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ------------------------------------------------------------------
+// --- Boot Profile ---
+// ------------------------------------------------------------------
+// Milliseconds since reset at which each boot milestone was first
+// reached. Phases overlap (LCD init, sensor warm-up and WiFi association
+// all run concurrently), so these are timestamps, not durations.
+// Reported in every health record.
+
+enum BootPhase : uint8_t {
+  BOOT_SETUP_DONE,       // setup() returned; tasks running
+  BOOT_LCD_READY,        // LCD initialised, splash shown
+  BOOT_FIRST_SAMPLE,     // First valid sensor reading (after DHT warm-up)
+  BOOT_WIFI_UP,          // Got an IP address
+  BOOT_BROKERS_LISTED,   // mDNS discovery done, probes started
+  BOOT_BROKER_HEALTHY,   // First broker vouched for by a probe
+  BOOT_MQTT_CONNECTED,
+  BOOT_FIRST_PUBLISH,    // First sensor sample accepted by the socket
+  BOOT_PHASE_COUNT
+};
+
+// Records `phase` the first time it is reached; later calls are ignored.
+// Safe from any task.
+void bootMark(BootPhase phase);
+
+bool bootReached(BootPhase phase);
+
+// {"setup_done":41,"lcd_ready":97,...}; phases not yet reached are omitted
+size_t bootProfileFormatJson(char* buf, size_t len);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// ------------------------------------------------------------------
+// --- Broker Pool: ordered MQTT brokers with background probing ---
+// ------------------------------------------------------------------
+// Index 0 is the primary broker; the rest are failover targets in order
+// of preference. A low-priority task probes every broker on its own
+// socket (TCP connect RTT, then CONNECT/CONNACK and PINGREQ/PINGRESP) so
+// the main loop can pick a healthy broker without ever blocking on a
+// dead one. TLS endpoints are probed at the TCP level only, since a
+// handshake per probe would cost more than the probe is worth.
+
+#define BROKER_POOL_MAX 4
+
+struct BrokerEndpoint {
+  const char* host;
+  uint16_t port;
+  bool tls;      // Speaks MQTT over TLS
+  const char* tlsName;  // Certificate/SNI name when `host` is an address (null: host)
+};
+
+struct BrokerHealth {
+  IPAddress ip;                  // Resolved by the last successful probe
+  uint32_t connectRttMs;         // TCP connect time of the last probe
+  uint32_t pingRttMs;            // PINGREQ -> PINGRESP of the last probe
+  uint32_t lastProbeMs;          // millis() when the last probe finished
+  uint16_t consecutiveFailures;
+  uint16_t consecutiveSuccesses;
+  bool probed;                   // At least one probe has completed
+  bool healthy;
+};
+
+// Probes only run while this returns true (WiFi associated, or the
+// Ethernet link up in QEMU builds)
+typedef bool (*BrokerLinkUp)();
+
+// Starts the probe task. The endpoints (host names included) are copied,
+// so the caller may rebuild its list afterwards. Calling it again only
+// swaps the list and resets its health; the one probe task carries on.
+void brokerPoolBegin(const BrokerEndpoint* brokers, uint8_t count,
+                     const char* probeClientId, BrokerLinkUp linkUp);
+
+uint8_t brokerPoolCount();
+// Valid until the next brokerPoolBegin()
+const BrokerEndpoint& brokerPoolEndpoint(uint8_t index);
+
+// Snapshot of a broker's health (copied under lock)
+BrokerHealth brokerPoolHealth(uint8_t index);
+
+// Lowest-index healthy broker, or -1 when none is currently healthy
+int8_t brokerPoolPreferred();
+
+// Called by the main client when a real connection attempt or session
+// fails, so the pool does not wait for the next probe to notice.
+void brokerPoolReportFailure(uint8_t index);
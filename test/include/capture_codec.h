@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ------------------------------------------------------------------
+// --- Raw ADC Capture: Block Format and Control Commands ---
+// ------------------------------------------------------------------
+// A capture is a sequence of self-contained blocks, so a file, a TCP
+// stream (blocks back to back) and UDP (one block per datagram) all
+// decode the same way. Little-endian:
+//
+//   "AC" | u8 version | u8 channels | u32 rateHz (per channel) |
+//   u32 firstFrame | u32 droppedFrames | u16 frames | u16 payloadBytes
+//
+// followed, per channel, by the first 12-bit value as u16 and then the
+// remaining frames as zig-zag varint deltas (1 byte for |delta| < 64,
+// which covers ADC noise). A frame holds one value per channel.
+// droppedFrames is cumulative, so the host can tell lost blocks (a gap
+// in firstFrame) from samples the device itself could not keep.
+// tools/capture_tool.py reconstructs blocks into CSV.
+// Portable (no Arduino).
+
+#define CAPTURE_VERSION 1
+#define CAPTURE_HEADER_BYTES 20
+#define CAPTURE_MAX_CHANNELS 2
+#define CAPTURE_BLOCK_FRAMES 256   // Worst-case block fits one Ethernet MTU
+#define CAPTURE_BLOCK_MAX \
+  (CAPTURE_HEADER_BYTES + CAPTURE_MAX_CHANNELS * (2 + (CAPTURE_BLOCK_FRAMES - 1) * 2))
+
+struct CaptureBlockInfo {
+  uint8_t channels;
+  uint32_t rateHz;
+  uint32_t firstFrame;
+  uint32_t droppedFrames;
+};
+
+// Encodes `frames` interleaved frames (values[f * channels + c]) into
+// out. Returns the block size, or 0 if it does not fit.
+size_t captureEncodeBlock(const CaptureBlockInfo& info, const uint16_t* values, uint16_t frames,
+                          uint8_t* out, size_t len);
+
+// --- Control (auralink/device/capture) ---
+//   start <sink> [rate=<Hz>] [secs=<n>]
+//   stop
+// where <sink> is `file` (LittleFS, fetched over HTTP at /capture) or
+// tcp://<ip>:<port> / udp://<ip>:<port>. rate is per channel.
+#define CAPTURE_DEFAULT_RATE_HZ 4000
+#define CAPTURE_MAX_RATE_HZ 20000
+#define CAPTURE_DEFAULT_SECS 10
+#define CAPTURE_MAX_SECS 3600
+
+enum CaptureAction : uint8_t { CAPTURE_START, CAPTURE_STOP };
+enum CaptureSink : uint8_t { CAPTURE_SINK_FILE, CAPTURE_SINK_TCP, CAPTURE_SINK_UDP };
+
+struct CaptureRequest {
+  uint8_t action;
+  uint8_t sink;
+  char host[16];      // Dotted IPv4 for the stream sinks
+  uint16_t port;
+  uint32_t rateHz;
+  uint32_t seconds;
+};
+
+// False (with a message in err) on anything malformed or out of range
+bool captureParseCommand(const char* text, size_t len, CaptureRequest& out, char* err, size_t errLen);
@@ -0,0 +1,7 @@
+#pragma once
+
+// Default rule set, equivalent to the original hardcoded LED logic.
+// Replaced at runtime by publishing to TOPIC_RULES_SET (text or binary);
+// the last accepted program is kept in NVS across reboots. Shared with
+// the native replay tool.
+extern const char defaultRules[];
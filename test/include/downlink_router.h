@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "auralink.pb.h"
+#include "text_store.h"
+
+// ------------------------------------------------------------------
+// --- Downlink Topic Dispatch ---
+// ------------------------------------------------------------------
+// Maps an incoming topic to the parser that owns it. callback() acts on
+// the result; the parsers themselves (wire.h, rules.h, text_store.h,
+// capture_codec.h) never see the topic. Kept free of Arduino types so
+// the same dispatch runs under the native fuzzers (src/native/fuzz/).
+// Portable (no Arduino).
+
+// --- Downlink topics (must match the Python backend) ---
+#define TOPIC_DOWNLINK "auralink/pb/downlink"                         // Protobuf, see proto/auralink.proto
+#define TOPIC_DISPLAY_QUOTE "auralink/display/quote"
+#define TOPIC_DISPLAY_SUMMARY "auralink/display/summary"
+#define TOPIC_DISPLAY_QUOTE_CHUNKS TOPIC_DISPLAY_QUOTE "/chunk/#"      // Long text, see text_store.h
+#define TOPIC_DISPLAY_SUMMARY_CHUNKS TOPIC_DISPLAY_SUMMARY "/chunk/#"
+#define TOPIC_URGENCY_LED "auralink/urgency/led"
+#define TOPIC_RULES_SET "auralink/rules/set"
+#define TOPIC_CAPTURE_CONTROL "auralink/device/capture"          // Capture builds only, see capture_codec.h
+
+#define DOWNLINK_TOPIC_MAX 128   // Longer topics are never ours
+
+enum TextSlot : uint8_t { TEXT_SLOT_QUOTE, TEXT_SLOT_SUMMARY, TEXT_SLOT_COUNT };
+
+enum DownlinkRoute : uint8_t {
+  DOWNLINK_ROUTE_NONE,       // Not a downlink topic
+  DOWNLINK_ROUTE_PROTOBUF,   // wireDecodeDownlink
+  DOWNLINK_ROUTE_RULES,      // Rule text or RULES_BINARY_MAGIC program
+  DOWNLINK_ROUTE_CAPTURE,    // captureParseCommand
+  DOWNLINK_ROUTE_TEXT,       // Quote/summary, whole or one chunk
+  DOWNLINK_ROUTE_URGENCY     // One word: LOW, MEDIUM or HIGH
+};
+
+struct DownlinkTarget {
+  DownlinkRoute route;
+  TextSlot textSlot;         // DOWNLINK_ROUTE_TEXT only
+  TextTopicKind textKind;
+  ChunkHeader chunk;         // TEXT_TOPIC_CHUNK only
+};
+
+extern const char* const textTopics[TEXT_SLOT_COUNT];
+
+// Classifies `topic`; out.route is DOWNLINK_ROUTE_NONE for anything else,
+// including malformed chunk suffixes
+DownlinkRoute downlinkRoute(const char* topic, DownlinkTarget& out);
+
+// Plain-text urgency: any mention of HIGH wins, then MEDIUM, else LOW
+auralink_UrgencyLevel urgencyFromText(const uint8_t* payload, size_t len);
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "flicker.h"
+#include "histogram.h"
+#include "led_effects.h"
+#include "payload.h"
+
+// ------------------------------------------------------------------
+// --- In-Firmware Event Bus ---
+// ------------------------------------------------------------------
+// Publishers fan typed, fixed-size events out to every subscriber whose
+// mask matches. Each subscriber owns a lock-free MPMC queue and runs in
+// its own task, so a slow consumer (the I2C LCD) can never stall a
+// producer (the MQTT callback): its queue fills and further events for
+// it are counted as dropped. Publishing is safe from any task.
+//
+// Every subscriber is measured on its own: delivered/dropped counts,
+// peak queue depth, and a publish-to-receive latency histogram.
+
+#define EVENT_BUS_MAX_SUBSCRIBERS 6
+#define EVENT_QUEUE_DEPTH 16
+#define EVENT_TEXT_LEN 21   // One LCD row plus terminator
+
+enum EventType : uint8_t {
+  EVENT_SAMPLE,        // sensors -> telemetry
+  EVENT_RULE_TRIGGER,  // sensors -> telemetry
+  EVENT_DISPLAY_TEXT,  // anyone -> display
+  EVENT_DISPLAY_CLEAR, // anyone -> display
+  EVENT_DISPLAY_STORE, // downlink -> display: a text store changed
+  EVENT_LED,           // rules, downlink -> leds
+  EVENT_FLICKER,       // flicker stage -> telemetry
+  EVENT_TYPE_COUNT
+};
+
+#define EVENT_MASK(type) (1UL << (type))
+
+struct DisplayTextEvent {
+  uint8_t row;
+  char text[EVENT_TEXT_LEN];
+};
+
+struct DisplayStoreEvent {
+  uint8_t slot;
+};
+
+struct LedEvent {
+  uint8_t index;
+  LedEffect effect;
+};
+
+struct RuleTriggerEvent {
+  uint8_t code;
+  SensorSample sample;
+};
+
+struct Event {
+  uint8_t type;
+  uint32_t publishedUs;   // Set by eventBusPublish()
+  union {
+    SensorSample sample;
+    RuleTriggerEvent trigger;
+    DisplayTextEvent display;
+    DisplayStoreEvent store;
+    LedEvent led;
+    FlickerResult flicker;
+  };
+};
+
+// Registers subscriber `name` for events in `typeMask`; call during
+// setup, before any publisher runs. `latency` may be null. Returns the
+// subscriber id, or -1 when the bus is full.
+int8_t eventBusSubscribe(const char* name, uint32_t typeMask, Histogram* latency);
+
+// Copies `event` into every matching subscriber queue and wakes those
+// tasks. Returns the number of subscribers it was delivered to.
+uint8_t eventBusPublish(Event& event);
+
+// Pops the next event for subscriber `id`, waiting up to `wait` ticks
+// for one to arrive. Only call from the subscriber's own task; the first
+// call binds that task (again after a restart) for wake-ups.
+bool eventBusReceive(int8_t id, Event& event, TickType_t wait);
+
+// Convenience publishers
+void eventBusDisplayText(uint8_t row, const char* fmt, ...);
+void eventBusDisplayClear();
+void eventBusDisplayStore(uint8_t slot);
+void eventBusLed(uint8_t index, const LedEffect& effect);
+
+// {"display":{"delivered":12,"dropped":0,"peak_depth":2},...}
+size_t eventBusFormatJson(char* buf, size_t len);
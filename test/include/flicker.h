@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ------------------------------------------------------------------
+// --- Light Flicker Analysis ---
+// ------------------------------------------------------------------
+// Analyses one high-rate block of raw LDR_AO samples:
+//   1. flickerPrepare: raw -> light (inverted, bright = high), time-domain
+//      stats, DC removed, written as complex input {re, 0} pairs
+//   2. a Hann window and a radix-2 complex FFT; the scalar versions here
+//      are the reference, the firmware uses ESP-DSP (flicker_stage.cpp)
+//   3. flickerFromSpectrum: strongest bin above FLICKER_MIN_HZ, refined by
+//      parabolic interpolation
+// The flicker index is the IES definition (area above the mean over the
+// total area) taken over the whole block rather than a single period.
+// Portable (no Arduino).
+
+#define FLICKER_MIN_HZ 5.0f
+#define FLICKER_NOISE_FLOOR 2.0f   // AC RMS in ADC counts below which no frequency is reported
+
+struct FlickerResult {
+  float flickerIndex;     // 0 = steady light, 1 = fully pulsed
+  float percentFlicker;   // (max - min) / (max + min) * 100
+  float dominantHz;       // 0 when the AC component is within noise
+  float acRms;            // ADC counts
+  float meanLight;        // ADC counts, bright = high
+};
+
+// Hann window, same definition as ESP-DSP's dsps_wind_hann_f32
+void flickerHannWindow(float* window, size_t n);
+
+// Fills cplx[2n] and the time-domain fields of out
+void flickerPrepare(const uint16_t* raw, size_t n, float* cplx, FlickerResult& out);
+
+// Scalar reference stages; n must be a power of two
+void flickerWindowScalar(float* cplx, const float* window, size_t n);
+void flickerFftScalar(float* cplx, size_t n);
+
+// Consumes the transformed cplx[2n] (bins in natural order)
+void flickerFromSpectrum(float* cplx, size_t n, float rateHz, FlickerResult& out);
+
+// Whole pipeline with the scalar stages. `window` comes from
+// flickerHannWindow; when null it is computed inline.
+void flickerAnalyzeScalar(const uint16_t* raw, size_t n, float rateHz, float* cplx, const float* window,
+                          FlickerResult& out);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "flicker.h"
+
+// ------------------------------------------------------------------
+// --- Flicker Analysis Stage (optional, -D AURALINK_FLICKER) ---
+// ------------------------------------------------------------------
+// Every FLICKER_INTERVAL_MS a low-priority task borrows ADC1 (under
+// `adcLock`, which the sensor task also takes around analogRead), lets
+// I2S DMA one FLICKER_SAMPLES block from LDR_AO at FLICKER_RATE_HZ, and
+// runs flicker.h on it with ESP-DSP's optimised window multiply and FFT.
+// Results go out on the event bus as EVENT_FLICKER.
+// Buffers and the FFT twiddle table are static (~18 KB).
+
+#define FLICKER_SAMPLES 1024           // Power of two; ~0.5 s of light
+#define FLICKER_RATE_HZ 2000           // Covers 100/120 Hz mains flicker and its harmonics
+#define FLICKER_INTERVAL_MS 30000
+#define FLICKER_LOCK_WAIT_MS 1000
+
+void flickerBegin(SemaphoreHandle_t adcLock);
+
+// Blocks analysed, and rounds skipped because ADC1/I2S was busy
+uint32_t flickerRuns();
+uint32_t flickerSkipped();
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ------------------------------------------------------------------
+// --- Subsystem Heartbeats ---
+// ------------------------------------------------------------------
+// Each subsystem task beats at least once per `timeoutMs`. The
+// supervisor (loop()) checks them; a silent subsystem is flagged and its
+// recovery hook is run once (e.g. ask the task to restart itself). If it is
+// still silent one timeout later the device reboots, remembering which
+// subsystem caused it. The ESP task watchdog sits behind all of this
+// with a longer timeout, as the last resort.
+
+#define HEARTBEAT_MAX 6
+
+typedef void (*HeartbeatRecovery)();
+
+// Returns the heartbeat id, or -1 when the registry is full
+int8_t heartbeatRegister(const char* name, uint32_t timeoutMs, HeartbeatRecovery recover);
+
+// Safe to call from any task
+void heartbeatBeat(int8_t id);
+
+// Run periodically from the supervisor
+void heartbeatSupervise();
+
+// {"sensor":{"stalls":0,"recoveries":0,"silent_ms":12},...}
+size_t heartbeatFormatJson(char* buf, size_t len);
+
+// Name of the subsystem whose stall forced the last reboot, or nullptr
+const char* heartbeatLastRebootCause();
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+// ------------------------------------------------------------------
+// --- Latency Histograms ---
+// ------------------------------------------------------------------
+// Fixed log2 buckets: bucket i counts values <= 2^i, the last bucket is
+// +Inf. Bucket and count updates are atomic, so any task may read while
+// the owner records; each histogram should have a single writer so the
+// 64-bit sum is never torn by concurrent updates.
+
+#define HISTOGRAM_BUCKETS 24
+#define METRICS_MAX_HISTOGRAMS 16  // A flicker build registers 11
+
+class Histogram {
+ public:
+  Histogram(const char* name, const char* help) : name_(name), help_(help) {}
+
+  void record(uint32_t value);
+  void reset();
+
+  const char* name() const { return name_; }
+  const char* help() const { return help_; }
+  uint32_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t sum() const { return sum_; }
+  uint32_t max() const { return max_; }
+  uint32_t bucket(uint8_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+
+  // Upper bound of bucket i (UINT32_MAX for the +Inf bucket)
+  static uint32_t bucketBound(uint8_t i);
+
+  // Upper bound of the bucket holding the p-th percentile (0-100)
+  uint32_t percentile(float p) const;
+
+ private:
+  const char* name_;
+  const char* help_;
+  std::atomic<uint32_t> buckets_[HISTOGRAM_BUCKETS] = {};
+  std::atomic<uint32_t> count_{0};
+  uint64_t sum_ = 0;
+  uint32_t max_ = 0;
+};
+
+// --- Registry: every histogram exported by the device ---
+// metricsRegister() logs and returns false once the registry is full.
+bool metricsRegister(Histogram* h);
+uint8_t metricsCount();
+Histogram* metricsAt(uint8_t i);
+Histogram* metricsFind(const char* name);
+
+// Renders one histogram; return bytes written (0 if it did not fit)
+size_t histogramToJson(const Histogram& h, char* buf, size_t len);
+size_t histogramToPrometheus(const Histogram& h, char* buf, size_t len);
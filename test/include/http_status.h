@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ------------------------------------------------------------------
+// --- Local HTTP Status / Metrics Endpoint ---
+// ------------------------------------------------------------------
+//   GET /readings     latest sample (JSON)
+//   GET /health       health record (JSON, same as auralink/device/health)
+//   GET /histograms   every registered histogram (JSON)
+//   GET /metrics      readings, health counters and histograms (Prometheus)
+//   GET /capture      last raw ADC file capture (adc_capture.h), binary
+//
+// Runs on the ESP-IDF HTTP server task, pinned to core 0 below the
+// sampling loop's priority. Responses are rendered into one preallocated
+// buffer and streamed in chunks, so nothing is allocated per request.
+
+#define HTTP_STATUS_PORT 80
+#define HTTP_MAX_CLIENTS 2              // Concurrent sockets; extra ones are purged LRU
+#define HTTP_LATENCY_BUDGET_US 20000    // Render budget per request
+#define HTTP_CHUNK_BYTES 2048
+
+// Providers render into buf and return the length, or 0 on overflow.
+typedef size_t (*HttpStatusRenderer)(char* buf, size_t len);
+
+// Reads up to len bytes at offset; 0 at the end
+typedef size_t (*HttpStatusFileReader)(uint32_t offset, char* buf, size_t len);
+
+struct HttpStatusProviders {
+  HttpStatusRenderer readingsJson;
+  HttpStatusRenderer healthJson;
+  // Prometheus lines for readings and health counters (histograms are
+  // appended by the server from the metrics registry)
+  HttpStatusRenderer metricsText;
+  // Raw capture download; streamed without the latency budget and kept
+  // out of auralink_http_handler_us, since it is bounded by the client
+  // rather than by rendering
+  HttpStatusFileReader captureFile;
+};
+
+bool httpStatusBegin(const HttpStatusProviders& providers);
+
+// Requests that ran past HTTP_LATENCY_BUDGET_US. Histogram streams are
+// cut short at that point; single-buffer responses are only counted.
+uint32_t httpStatusBudgetOverruns();
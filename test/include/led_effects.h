@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ------------------------------------------------------------------
+// --- LED Effect Engine (LEDC PWM + hardware fades) ---
+// ------------------------------------------------------------------
+// Each LED owns one LEDC channel and one LEDC timer, so patterns run
+// entirely in hardware between state changes:
+//   SOLID        fixed duty on a 5 kHz carrier
+//   BLINK        square wave: the timer itself runs at the blink rate
+//   BREATHE      hardware fade up/down; the CPU only reverses direction
+//   PULSE_TRAIN  `pulses` blinks, then `gapMs` dark, repeated; the CPU
+//                only gates the train on and off
+// ledEffectSet() is cheap to call every sample: unchanged effects are
+// left running without a glitch.
+
+#define LED_EFFECTS_MAX 8
+
+enum LedEffectKind : uint8_t {
+  LED_EFFECT_OFF,
+  LED_EFFECT_SOLID,
+  LED_EFFECT_BLINK,
+  LED_EFFECT_BREATHE,
+  LED_EFFECT_PULSE_TRAIN
+};
+
+struct LedEffect {
+  uint8_t kind;
+  uint8_t brightness;   // 0-255, SOLID and BREATHE peak
+  uint16_t periodMs;    // Full on+off period (BLINK, PULSE_TRAIN) or breath cycle
+  uint8_t pulses;       // PULSE_TRAIN: pulses per train
+  uint16_t gapMs;       // PULSE_TRAIN: dark time between trains
+};
+
+inline bool operator==(const LedEffect& a, const LedEffect& b) {
+  return a.kind == b.kind && a.brightness == b.brightness && a.periodMs == b.periodMs &&
+         a.pulses == b.pulses && a.gapMs == b.gapMs;
+}
+inline bool operator!=(const LedEffect& a, const LedEffect& b) { return !(a == b); }
+
+// Convenience constructors
+inline LedEffect ledOff() { return LedEffect{LED_EFFECT_OFF, 0, 0, 0, 0}; }
+inline LedEffect ledSolid(uint8_t brightness = 255) { return LedEffect{LED_EFFECT_SOLID, brightness, 0, 0, 0}; }
+inline LedEffect ledBlink(uint16_t periodMs) { return LedEffect{LED_EFFECT_BLINK, 255, periodMs, 0, 0}; }
+inline LedEffect ledBreathe(uint16_t periodMs, uint8_t brightness = 255) {
+  return LedEffect{LED_EFFECT_BREATHE, brightness, periodMs, 0, 0};
+}
+inline LedEffect ledPulseTrain(uint16_t periodMs, uint8_t pulses, uint16_t gapMs) {
+  return LedEffect{LED_EFFECT_PULSE_TRAIN, 255, periodMs, pulses, gapMs};
+}
+
+// Configures one LEDC channel/timer per pin (max LED_EFFECTS_MAX) and
+// starts the helper task that services fade-end and train events.
+void ledEffectsBegin(const uint8_t* pins, uint8_t count);
+
+// Switches LED `index` to `effect`; no-op when it is already running.
+void ledEffectSet(uint8_t index, const LedEffect& effect);
+
+LedEffect ledEffectGet(uint8_t index);
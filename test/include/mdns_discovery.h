@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// ------------------------------------------------------------------
+// --- mDNS Broker Discovery ---
+// ------------------------------------------------------------------
+// Browses for MQTT brokers advertised on the LAN and picks the one with
+// the lowest TCP connect RTT, so an on-premises broker is preferred over
+// the WAN ones in the configured list.
+
+#define MDNS_DEVICE_HOSTNAME "auralink"
+#define MDNS_RTT_SAMPLES 3          // Connects per candidate; the minimum is kept
+#define MDNS_CONNECT_TIMEOUT_MS 500
+// Discovery runs on the network task, inside its heartbeat: besides the
+// query itself (~3 s in ESPmDNS), RTT measurement is capped in candidates
+// and in total time, so a busy LAN cannot stall bring-up
+#define MDNS_MAX_CANDIDATES 4
+#define MDNS_RTT_BUDGET_MS 4000
+
+struct DiscoveredBroker {
+  char name[40];   // mDNS host name, for reporting
+  char host[16];   // Dotted IP, usable as a BrokerEndpoint host
+  IPAddress ip;
+  uint16_t port;
+  uint32_t rttMs;
+};
+
+// `service` is "mqtt" or "secure-mqtt" (queried over tcp). Returns false
+// when nothing answered or no responder accepted a connection.
+bool discoverLocalBroker(const char* service, DiscoveredBroker& out);
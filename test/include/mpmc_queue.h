@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// ------------------------------------------------------------------
+// --- Bounded Lock-Free MPMC Queue ---
+// ------------------------------------------------------------------
+// Vyukov-style ring: every cell carries a sequence number that tells
+// producers and consumers whose turn it is, so push/pop are a single
+// CAS on the shared index plus one release store on the cell. Neither
+// side ever blocks or takes a lock; a full queue makes push() fail and
+// an empty one makes pop() fail. N must be a power of two.
+// Portable (no Arduino/FreeRTOS), so it also builds in native envs.
+template <typename T, size_t N>
+class MpmcQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "MpmcQueue size must be a power of two");
+
+ public:
+  MpmcQueue() {
+    for (size_t i = 0; i < N; i++) cells_[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  size_t capacity() const { return N; }
+
+  // Approximate under concurrency; exact when quiescent
+  size_t size() const {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    return head - tail;
+  }
+
+  bool push(const T& item) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & (N - 1)];
+      size_t seq = cell.seq.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.item = item;
+          cell.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // Full
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool pop(T& item) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & (N - 1)];
+      size_t seq = cell.seq.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          item = cell.item;
+          cell.seq.store(pos + N, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // Empty
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T item;
+  };
+
+  Cell cells_[N];
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ------------------------------------------------------------------
+// --- Bounded Outbound Publish Queue ---
+// ------------------------------------------------------------------
+// Every uplink message is queued here and sent by the network task at
+// the pace the socket accepts. Payloads live back to back in one byte
+// arena, so a 900-byte health record and a 90-byte sample cost only
+// what they use. When the queue is full the message's policy decides:
+//   DROP_OLDEST  evict from the front until the new message fits
+//   DROP_NEWEST  refuse the new message
+//   COALESCE     drop any queued message on the same topic first (only
+//                the latest health/status matters), then DROP_OLDEST
+// A send that fails stays at the front and is retried; after
+// OUTBOUND_MAX_RETRIES it is dropped and counted as failed.
+// Portable (no Arduino), so it also builds in native envs.
+
+#ifndef OUTBOUND_ARENA_BYTES
+#define OUTBOUND_ARENA_BYTES 4096
+#endif
+#ifndef OUTBOUND_MAX_ENTRIES
+#define OUTBOUND_MAX_ENTRIES 24
+#endif
+#define OUTBOUND_MAX_RETRIES 5
+
+// PubSubClient reserves this many bytes for the fixed header
+#define MQTT_FIXED_HEADER_MAX 5
+
+// Bytes a QoS 0 PUBLISH occupies in PubSubClient's buffer; it refuses
+// (returns false) anything larger than the size given to setBufferSize().
+constexpr size_t mqttPublishPacketSize(size_t topicLen, size_t payloadLen) {
+  return MQTT_FIXED_HEADER_MAX + 2 + topicLen + payloadLen;
+}
+
+// For string-literal topics: compile-time length without the NUL
+#define MQTT_TOPIC_LEN(topic) (sizeof(topic) - 1)
+
+enum OutboundPolicy : uint8_t {
+  OUTBOUND_DROP_OLDEST,
+  OUTBOUND_DROP_NEWEST,
+  OUTBOUND_COALESCE
+};
+
+struct OutboundStats {
+  uint32_t enqueued;
+  uint32_t sent;
+  uint32_t droppedOldest;   // Evicted to make room
+  uint32_t droppedNewest;   // Refused for lack of room
+  uint32_t coalesced;       // Superseded by a newer message on the topic
+  uint32_t retries;         // Failed sends that were kept for another try
+  uint32_t failed;          // Dropped after OUTBOUND_MAX_RETRIES
+  uint32_t oversize;        // Could never fit the MQTT or arena buffer
+};
+
+struct OutboundMessage {
+  const char* topic;        // Must outlive the queue (topics are literals)
+  const uint8_t* payload;   // Valid until the next push/pop
+  uint16_t len;
+};
+
+class OutboundQueue {
+ public:
+  // `maxPacket` is the MQTT client buffer size; larger messages are refused
+  explicit OutboundQueue(size_t maxPacket) : maxPacket_(maxPacket) {}
+  void setMaxPacket(size_t maxPacket) { maxPacket_ = maxPacket; }
+
+  bool push(const char* topic, const uint8_t* payload, size_t len, OutboundPolicy policy);
+  bool push(const char* topic, const char* payload, OutboundPolicy policy);
+
+  // True when a message of `len` bytes would be accepted without evicting
+  bool hasRoom(size_t len) const;
+
+  bool empty() const { return live_ == 0; }
+  size_t size() const { return live_; }
+  size_t bytesUsed() const;
+
+  // Oldest live message; only valid when !empty()
+  OutboundMessage front();
+  // Removes the front message after a successful send
+  void popSent();
+  // Records a failed send of the front message; drops it after too many
+  void sendFailed();
+
+  const OutboundStats& stats() const { return stats_; }
+
+ private:
+  struct Entry {
+    const char* topic;
+    uint16_t offset;
+    uint16_t len;
+    uint8_t retries;
+    bool live;
+  };
+
+  Entry& at(size_t i) { return entries_[(head_ + i) % OUTBOUND_MAX_ENTRIES]; }
+  const Entry& at(size_t i) const { return entries_[(head_ + i) % OUTBOUND_MAX_ENTRIES]; }
+  bool allocate(size_t len, uint16_t& offset) const;
+  void popFront();
+  void skipDead();
+
+  size_t maxPacket_;
+  Entry entries_[OUTBOUND_MAX_ENTRIES];
+  uint8_t arena_[OUTBOUND_ARENA_BYTES];
+  size_t head_ = 0;    // Oldest entry, live or not
+  size_t count_ = 0;   // Entries holding arena space
+  size_t live_ = 0;    // Entries still to be sent
+  OutboundStats stats_ = {};
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ------------------------------------------------------------------
+// --- Sensor Sample ---
+// ------------------------------------------------------------------
+// One reading of every sensor, as taken by loop(). Kept small and
+// trivially copyable so it can sit in ring buffers while offline.
+struct SensorSample {
+  uint32_t seq;          // Monotonic sample counter
+  uint32_t timestampMs;  // millis() at capture
+  float temperature;
+  float humidity;
+  uint8_t lightPercent;
+  uint8_t noxPercent;
+  uint8_t pir;
+};
+
+// Worst case for in-range readings (seq up to 10 digits), with margin
+#define SENSOR_PAYLOAD_MAX 128
+
+// Formats the uplink JSON for TOPIC_SENSOR_DATA.
+// Returns the number of characters written (excluding NUL), or 0 if the
+// buffer was too small.
+size_t formatSensorPayload(const SensorSample& s, char* buf, size_t len);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// ------------------------------------------------------------------
+// --- QEMU Networking (OpenETH) ---
+// ------------------------------------------------------------------
+// Espressif's QEMU emulates no WiFi radio; it exposes an OpenCores
+// Ethernet MAC instead (-nic user,model=open_eth). QEMU builds
+// (-D AURALINK_QEMU) bring that up through esp_eth/esp_netif in place of
+// WiFi. lwIP sockets, and so WiFiClient and PubSubClient, work unchanged
+// on top of it. Needs CONFIG_ETH_USE_OPENETH, which the Arduino core's
+// prebuilt SDK lacks, hence the arduino+espidf esp32-qemu environment.
+// With QEMU's user-mode network the host is reachable at 10.0.2.2.
+
+// Starts the MAC and DHCP; returns false if the driver failed to install
+bool qemuNetBegin();
+
+// True once DHCP has assigned an address
+bool qemuNetUp();
+
+IPAddress qemuNetLocalIP();
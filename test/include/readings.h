@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "payload.h"
+#include "rules.h"
+
+// ------------------------------------------------------------------
+// --- Raw Sensor Readings ---
+// ------------------------------------------------------------------
+// What the sensor task reads from the hardware (or a replay trace),
+// before any scaling. The conversion to a SensorSample and to rule
+// inputs is shared by the firmware and the native replay tool, so both
+// produce bit-identical output from the same trace.
+// Portable (no Arduino).
+
+#define ADC_FULL_SCALE 4095
+
+struct RawReadings {
+  float temperature;    // NaN when the DHT22 read failed
+  float humidity;       // NaN when the DHT22 read failed
+  uint16_t ldrAnalog;   // LDR_AO, 0-4095 (bright = low)
+  uint16_t noxRaw;      // NOX_PIN, 0-4095
+  uint8_t ldrDigital;   // LDR_DO
+  uint8_t pir;          // PIR_PIN
+};
+
+// False when the DHT22 read failed
+bool readingsValid(const RawReadings& r);
+
+// Same integer math as Arduino's map()
+long mapRange(long x, long inMin, long inMax, long outMin, long outMax);
+
+SensorSample readingsToSample(const RawReadings& r, uint32_t seq, uint32_t timestampMs);
+
+void sampleToRuleInputs(const SensorSample& s, RuleInputs& inputs);
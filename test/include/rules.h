@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ------------------------------------------------------------------
+// --- Rules Engine ---
+// ------------------------------------------------------------------
+// Rules are written one per line as `condition -> action`, e.g.
+//
+//   # NOx caution band
+//   nox > 30 && nox <= 60 -> led nox blink 100
+//   temp > 30 || temp < 20 -> publish 1
+//
+// Variables: temp, hum, light, nox, pir
+// Operators: < <= > >= == != && || ! and parentheses
+// Actions:   led <temp|light|nox|pir|urgency> off|on
+//            led <name> blink <ms>                   ms on, ms off (ms <= 32767)
+//            led <name> breathe <ms>                 one breath every ms
+//            led <name> pulse <ms> <count> <gapMs>   pulse train (ms <= 32767)
+//            alert <0-31>     local alert, level-triggered
+//            publish <0-31>   publish trigger, fires on the rising edge
+//
+// Text is compiled into a flat bytecode array with no jumps, so one
+// evaluation is a single linear pass bounded by RULES_MAX_CODE, on a
+// fixed-size stack, with no allocation. A compiled program can also be
+// shipped as-is (RULES_BINARY_MAGIC header) and is verified before use.
+
+#define RULES_MAX_CODE 384
+#define RULES_MAX_RULES 32
+#define RULES_STACK_MAX 8
+#define RULES_MAX_LINE 128
+#define RULES_BINARY_MAGIC "ARB2"
+
+enum RuleVar : uint8_t {
+  RULE_VAR_TEMP,
+  RULE_VAR_HUM,
+  RULE_VAR_LIGHT,
+  RULE_VAR_NOX,
+  RULE_VAR_PIR,
+  RULE_VAR_COUNT
+};
+
+enum RuleLed : uint8_t {
+  RULE_LED_TEMP,
+  RULE_LED_LIGHT,
+  RULE_LED_NOX,
+  RULE_LED_PIR,
+  RULE_LED_URGENCY,
+  RULE_LED_COUNT
+};
+
+enum RuleLedMode : uint8_t {
+  RULE_LED_UNSET,  // No rule drove this LED during the pass
+  RULE_LED_OFF,
+  RULE_LED_ON,
+  RULE_LED_BLINK,    // periodMs on, periodMs off
+  RULE_LED_BREATHE,  // One fade up/down cycle every periodMs
+  RULE_LED_PULSE     // `count` blinks of periodMs, then gapMs dark
+};
+
+struct RuleLedCommand {
+  uint8_t mode;
+  uint8_t count;
+  uint16_t periodMs;
+  uint16_t gapMs;
+};
+
+struct RuleInputs {
+  float values[RULE_VAR_COUNT];
+};
+
+struct RuleOutputs {
+  RuleLedCommand leds[RULE_LED_COUNT];
+  uint32_t alertMask;     // Alerts whose condition holds this pass
+  uint32_t publishMask;   // Publish triggers that became true this pass
+};
+
+struct RuleProgram {
+  uint8_t code[RULES_MAX_CODE];
+  uint16_t len;
+  uint8_t ruleCount;
+};
+
+// Edge-detection state carried between evaluations; reset when the
+// program is replaced.
+struct RuleState {
+  uint32_t lastResults;
+};
+
+// Compiles rule text. On failure returns false and writes a message
+// (including the line number) into err; `out` is left untouched.
+bool rulesCompile(const char* text, size_t len, RuleProgram& out, char* err, size_t errLen);
+
+// Loads a compiled program (RULES_BINARY_MAGIC + u16 length + code) after
+// verifying opcodes, operands and stack depth.
+bool rulesLoadBinary(const uint8_t* data, size_t len, RuleProgram& out, char* err, size_t errLen);
+
+// Serializes a program into the binary format; returns bytes written or 0.
+size_t rulesSaveBinary(const RuleProgram& prog, uint8_t* buf, size_t len);
+
+void rulesEvaluate(const RuleProgram& prog, const RuleInputs& in, RuleState& state, RuleOutputs& out);
+
+const char* rulesLedName(uint8_t led);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "payload.h"
+
+// ------------------------------------------------------------------
+// --- Offline Sample Buffer ---
+// ------------------------------------------------------------------
+// Fixed-capacity FIFO of samples waiting to be published. When full the
+// oldest sample is overwritten, so a long outage keeps the most recent
+// history instead of blocking the sampler.
+template <size_t N>
+class SampleBuffer {
+ public:
+  bool empty() const { return count_ == 0; }
+  size_t size() const { return count_; }
+  size_t capacity() const { return N; }
+  uint32_t dropped() const { return dropped_; }
+
+  void push(const SensorSample& s) {
+    if (count_ == N) {
+      tail_ = (tail_ + 1) % N;
+      count_--;
+      dropped_++;
+    }
+    items_[(tail_ + count_) % N] = s;
+    count_++;
+  }
+
+  // Oldest sample; only valid when !empty()
+  const SensorSample& front() const { return items_[tail_]; }
+
+  // i-th oldest sample; only valid when i < size()
+  const SensorSample& at(size_t i) const { return items_[(tail_ + i) % N]; }
+
+  void pop() {
+    if (count_ == 0) return;
+    tail_ = (tail_ + 1) % N;
+    count_--;
+  }
+
+ private:
+  SensorSample items_[N];
+  size_t tail_ = 0;
+  size_t count_ = 0;
+  uint32_t dropped_ = 0;
+};
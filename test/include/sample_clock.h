@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+#include "histogram.h"
+
+// ------------------------------------------------------------------
+// --- Hardware Sampling Clock ---
+// ------------------------------------------------------------------
+// A periodic esp_timer (hardware-timer backed, dispatched from the
+// high-priority esp_timer task) ticks every sampling period. The callback
+// only stamps the time and queues the tick; the sensor task does the
+// slow reads (the DHT22 alone takes ~5 ms with interrupts off) against
+// that stamp. Sample times therefore no longer depend on how long the
+// previous sample, the network or the display took.
+//
+// Spacing jitter (|tick interval - period|) is measured in the callback
+// itself; the time from tick to the worker picking it up is measured
+// separately. A worker that falls SAMPLE_CLOCK_QUEUE_DEPTH ticks behind
+// loses ticks, which are counted.
+
+#define SAMPLE_CLOCK_QUEUE_DEPTH 4
+#define SAMPLE_CLOCK_JITTER_BUDGET_US 1000
+
+struct SampleTick {
+  uint32_t index;      // Ticks since the clock started, including missed ones
+  int64_t captureUs;   // esp_timer_get_time() in the callback
+};
+
+struct SampleClockStats {
+  uint32_t ticks;
+  uint32_t missed;        // Queue full: the worker fell behind
+  uint32_t overBudget;    // Intervals off by more than the jitter budget
+  uint32_t maxJitterUs;
+};
+
+// Creates the timer and queue; call once from setup()
+bool sampleClockBegin(uint32_t periodMs);
+
+// First tick after `delayMs`, then every period. Later calls are no-ops,
+// so a restarted worker keeps the original schedule.
+void sampleClockStart(uint32_t delayMs);
+
+// Next tick, or false after `wait` ticks without one. Records the
+// handoff latency.
+bool sampleClockWait(SampleTick& tick, TickType_t wait);
+
+SampleClockStats sampleClockStats();
+
+// Changes the period at runtime (any task). Takes effect from the next
+// tick, which still comes at the old spacing; jitter is measured against
+// whichever period the interval was scheduled with.
+void sampleClockSetPeriod(uint32_t periodMs);
+uint32_t sampleClockPeriodMs();
+
+// {"period_ms":3000,"ticks":..,"missed":..,"jitter_max_us":..,...}
+size_t sampleClockFormatJson(char* buf, size_t len);
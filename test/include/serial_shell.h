@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ------------------------------------------------------------------
+// --- Serial Command Shell ---
+// ------------------------------------------------------------------
+// A line editor and command dispatcher fed whatever bytes the UART has
+// already received, a few at a time, from the supervisor (loop()). It
+// never waits for input, so a half-typed line costs nothing; only the
+// loop task ever blocks on shell output. The editor handles backspace/
+// DEL, Ctrl-C (drop the line), Ctrl-U (erase the line), and up-arrow to
+// recall the previous command; other escape sequences are swallowed.
+// CR, LF and CRLF all end a line.
+// Portable (no Arduino): output goes through a ShellWrite callback.
+
+#define SHELL_LINE_MAX 80
+#define SHELL_MAX_ARGS 6
+#define SHELL_PROMPT "> "
+
+typedef void (*ShellWrite)(const char* data, size_t len);
+
+struct ShellCommand {
+  const char* name;
+  const char* usage;   // Shown by `help`
+  void (*run)(int argc, char** argv);   // argv[0] is the command name
+};
+
+class LineEditor {
+ public:
+  enum Result : uint8_t {
+    LINE_PENDING,   // Keep feeding
+    LINE_READY,     // line() holds a complete command
+    LINE_CANCELLED  // Ctrl-C
+  };
+
+  LineEditor() { reset(); }
+
+  // Consumes one byte, echoing what the terminal should show
+  Result feed(char c, ShellWrite echo);
+
+  // The completed line, NUL-terminated; valid until the next feed()
+  char* line() { return line_; }
+  void reset();
+
+ private:
+  void erase(size_t count, ShellWrite echo);
+
+  char line_[SHELL_LINE_MAX + 1];
+  char history_[SHELL_LINE_MAX + 1];
+  size_t len_;
+  uint8_t escape_;     // Progress through an ESC [ x sequence
+  bool lastWasCr_;     // Swallow the LF of a CRLF
+  bool ready_;         // line_ was handed out; start over on the next byte
+};
+
+// Registers the command table (not copied) and the output sink
+void shellBegin(const ShellCommand* commands, size_t count, ShellWrite write);
+
+// Feeds received bytes; commands run inline as their lines complete
+void shellFeed(const char* data, size_t len);
+
+// Formatted output for command handlers, truncated to one line buffer
+void shellPrintf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Splits `line` in place on spaces; returns argc (extra words are dropped)
+int shellTokenize(char* line, char** argv, int maxArgs);
+
+// Runs one command line; false if the command is unknown
+bool shellExecute(char* line);
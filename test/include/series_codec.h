@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "payload.h"
+
+// ------------------------------------------------------------------
+// --- Sample Batch Compression (Gorilla-style) ---
+// ------------------------------------------------------------------
+// Packs a run of buffered samples into one binary message for
+// TOPIC_SENSOR_BATCH, for draining the backlog after an outage.
+//
+//   header (14 bytes, LE): "AG" | u8 version | u8 flags (0) |
+//                          u16 count | u32 firstSeq | u32 firstTimestampMs
+//   then a bit stream, MSB first. Sample 0: temperature and humidity as
+//   raw float bits, light and nox as varints, pir as one bit. Then, per
+//   sample:
+//     seq          zig-zag varint of (delta - 1)
+//     timestamp    sample 1: zig-zag varint of the delta; later samples:
+//                  delta-of-delta '0' | '10'+7 | '110'+9 | '1110'+12 | '1111'+32
+//     temp, hum    XOR with the previous value: '0' same | '10' + bits
+//                  inside the previous window | '11' + 5-bit leading zeros
+//                  + 5-bit (length - 1) + bits
+//     light, nox   zig-zag varint of the delta
+//     pir          one bit
+// Varints are 8-bit groups (7 data bits + continuation) in the stream.
+// backend/series_codec.py decodes it.
+// Portable (no Arduino).
+
+#define SERIES_VERSION 1
+#define SERIES_HEADER_BYTES 14
+#define SERIES_FIRST_SAMPLE_BITS 81    // 32 + 32 + 8 + 8 + 1
+#define SERIES_SAMPLE_MAX_BITS 201     // Worst case for any later sample
+
+class SeriesEncoder {
+ public:
+  // Encodes into buf[cap]; cap must hold at least the header
+  void begin(uint8_t* buf, size_t cap);
+
+  // False (and nothing written) when the sample might not fit
+  bool add(const SensorSample& s);
+
+  // Finalises the header; returns the message length (0 if empty)
+  size_t finish();
+
+  uint16_t count() const { return count_; }
+
+ private:
+  void putBits(uint32_t value, uint8_t bits);
+  void putVarint(uint32_t value);
+  void putFloat(float value, uint32_t& prev, uint8_t& leading, uint8_t& trailing);
+
+  uint8_t* buf_ = nullptr;
+  size_t capBits_ = 0;
+  size_t bitPos_ = 0;
+  uint16_t count_ = 0;
+  SensorSample first_;
+  SensorSample prev_;
+  int32_t prevDelta_ = 0;
+  uint32_t prevTemp_ = 0, prevHum_ = 0;
+  uint8_t tempLeading_ = 0xFF, tempTrailing_ = 0;
+  uint8_t humLeading_ = 0xFF, humTrailing_ = 0;
+};
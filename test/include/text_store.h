@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ------------------------------------------------------------------
+// --- Display Text Store (streamed downlink text) ---
+// ------------------------------------------------------------------
+// Long quotes/summaries arrive either whole on their topic (when they fit
+// the MQTT buffer) or split by the backend into chunks on
+//   <topic>/chunk/<msgId>/<index>/<count>
+// Each chunk is folded straight into a fixed-size store as it arrives,
+// sanitised for the HD44780 character set, so RAM use does not depend on
+// the message length: anything past TEXT_STORE_CAPACITY is dropped and
+// the text is marked truncated. A missing or out-of-order chunk ends the
+// message early with what has been received.
+// Portable (no Arduino), so it also builds in native envs.
+
+#define TEXT_STORE_CAPACITY 240   // 12 LCD rows' worth
+
+struct ChunkHeader {
+  uint16_t msgId;
+  uint16_t index;
+  uint16_t count;
+};
+
+enum TextTopicKind : int8_t {
+  TEXT_TOPIC_NONE = -1,    // Not this text topic, or a malformed chunk suffix
+  TEXT_TOPIC_WHOLE = 0,    // Exactly `base`
+  TEXT_TOPIC_CHUNK = 1     // `base`/chunk/<msgId>/<index>/<count>; header filled in
+};
+
+// Classifies `topic` against a text topic `base`
+TextTopicKind parseTextTopic(const char* topic, const char* base, ChunkHeader& header);
+
+enum ChunkResult : uint8_t {
+  CHUNK_APPENDED,
+  CHUNK_COMPLETE,
+  CHUNK_IGNORED     // Not part of the message being received
+};
+
+class TextStore {
+ public:
+  TextStore() { clear(); }
+
+  void clear();
+
+  // Replaces the text with a whole (unchunked) message
+  void set(const uint8_t* data, size_t len);
+
+  ChunkResult appendChunk(const ChunkHeader& header, const uint8_t* data, size_t len);
+
+  const char* text() const { return text_; }
+  size_t length() const { return len_; }
+  bool truncated() const { return truncated_; }
+  uint32_t gaps() const { return gaps_; }
+
+ private:
+  void putByte(uint8_t b);
+  void putChar(char c);
+
+  char text_[TEXT_STORE_CAPACITY + 1];
+  size_t len_;
+  bool truncated_;
+  bool receiving_;       // A chunked message is in progress
+  uint16_t msgId_;
+  uint16_t nextIndex_;
+  uint16_t count_;
+  uint32_t codepoint_;   // UTF-8 decoder state, carried across chunks
+  uint8_t pending_;
+  uint32_t gaps_ = 0;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+
+// ------------------------------------------------------------------
+// --- TLS Client with Session Resumption ---
+// ------------------------------------------------------------------
+// mbedTLS client layered over any Arduino Client (normally WiFiClient),
+// usable as the transport for PubSubClient. The negotiated session
+// (ticket or ID) is serialized into RTC memory after every full
+// handshake, so reconnects -- including after a software reset -- can
+// resume instead of paying for a full handshake.
+
+// Serialized session blob kept in RTC slow memory
+#define TLS_SESSION_CACHE_BYTES 2048
+#define TLS_HANDSHAKE_TIMEOUT_MS 10000
+// A write that makes no progress for this long drops the connection
+#define TLS_WRITE_TIMEOUT_MS 5000
+
+struct TlsHandshakeStats {
+  uint32_t fullCount;
+  uint32_t resumedCount;
+  uint32_t failedCount;
+  uint32_t lastFullMs;
+  uint32_t lastResumedMs;
+  uint32_t totalFullMs;
+  uint32_t totalResumedMs;
+};
+
+class TlsSessionClient : public Client {
+ public:
+  explicit TlsSessionClient(Client& transport);
+  ~TlsSessionClient() override;
+
+  // One-time setup: seeds the DRBG and parses the PEM CA certificate
+  // (NUL-terminated). Returns false if either step fails.
+  bool begin(const char* caPem);
+
+  // Name used for SNI and certificate verification; required when
+  // connecting by IP address.
+  void setHostname(const char* host);
+
+  const TlsHandshakeStats& stats() const { return stats_; }
+  bool lastHandshakeResumed() const { return lastResumed_; }
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t* buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buf, size_t size) override;
+  int peek() override;
+  void flush() override;
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+
+ private:
+  int handshake(uint16_t port);
+  void saveSession(uint16_t port);
+  bool restoreSession(uint16_t port);
+
+  static int bioSend(void* ctx, const unsigned char* buf, size_t len);
+  static int bioRecv(void* ctx, unsigned char* buf, size_t len);
+  static int verifyCallback(void* ctx, mbedtls_x509_crt* crt, int depth, uint32_t* flags);
+
+  Client& transport_;
+  mbedtls_entropy_context entropy_;
+  mbedtls_ctr_drbg_context drbg_;
+  mbedtls_ssl_config conf_;
+  mbedtls_ssl_context ssl_;
+  mbedtls_x509_crt ca_;
+  const char* hostname_ = nullptr;
+  bool ready_ = false;
+  bool connected_ = false;
+  bool certVerified_ = false;  // Set by the verify callback; only a full handshake verifies
+  bool lastResumed_ = false;
+  int peeked_ = -1;
+  TlsHandshakeStats stats_ = {};
+};
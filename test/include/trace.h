@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "readings.h"
+
+// ------------------------------------------------------------------
+// --- Sensor Traces (record / replay) ---
+// ------------------------------------------------------------------
+// A trace is a 16-byte header followed by fixed 20-byte records, all
+// little-endian:
+//   header: "ALTR" | u16 version | u16 record size | u32 count | u32 reserved
+//   record: u32 offsetMs | f32 temperature | f32 humidity |
+//           u16 ldrAnalog | u16 noxRaw | u8 ldrDigital | u8 pir | u16 reserved
+// offsetMs is the capture time relative to the first record; a NaN
+// temperature/humidity replays a failed DHT22 read. Traces are built by
+// tools/trace_tool.py from a recording log or a CSV.
+// The reader pulls bytes through a callback, so the same code replays
+// from a flash partition on target and from a file on the native env.
+// Portable (no Arduino).
+
+#define TRACE_MAGIC "ALTR"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_BYTES 16
+#define TRACE_RECORD_BYTES 20
+
+struct TraceRecord {
+  uint32_t offsetMs;
+  RawReadings readings;
+};
+
+// Reads `len` bytes at `offset`; false on I/O error
+typedef bool (*TraceReadFn)(void* ctx, uint32_t offset, uint8_t* buf, size_t len);
+
+class TraceReader {
+ public:
+  // `sizeBytes` bounds the readable area (e.g. the partition size).
+  // False if the header is missing, of another version, or overruns it.
+  bool begin(TraceReadFn read, void* ctx, uint32_t sizeBytes);
+
+  // Next record; false at the end of the trace or on a read error
+  bool next(TraceRecord& rec);
+
+  void rewind() { position_ = 0; }
+  uint32_t count() const { return count_; }
+  uint32_t position() const { return position_; }
+
+ private:
+  TraceReadFn read_ = nullptr;
+  void* ctx_ = nullptr;
+  uint32_t count_ = 0;
+  uint32_t position_ = 0;
+};
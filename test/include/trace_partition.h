@@ -0,0 +1,16 @@
+#pragma once
+
+#include "trace.h"
+
+// ------------------------------------------------------------------
+// --- Trace Partition (replay builds) ---
+// ------------------------------------------------------------------
+// Replay builds use partitions_replay.csv, which carves a "trace" data
+// partition out of the app space. Flash a trace into it with
+//   tools/trace_tool.py flash <trace.bin>
+
+#define TRACE_PARTITION_LABEL "trace"
+#define TRACE_PARTITION_SUBTYPE 0x40   // Custom data subtype
+
+// Opens the partition and validates the trace header
+bool tracePartitionBegin(TraceReader& reader);
@@ -0,0 +1,20 @@
+#pragma once
+
+// ------------------------------------------------------------------
+// --- Uplink Topics (device -> backend) ---
+// ------------------------------------------------------------------
+// Everything the device publishes. Shared by the firmware and the native
+// fleet generator (src/native/fleet_main.cpp) so both send to the same
+// topics; downlink topics live with their dispatcher in downlink_router.h.
+// Portable (no Arduino).
+
+// --- Uplink topics (must match the Python backend) ---
+#define TOPIC_UPLINK "auralink/pb/uplink"                             // Protobuf, see proto/auralink.proto
+#define TOPIC_SENSOR_DATA "auralink/sensor/data"                      // JSON uplink (AURALINK_UPLINK_JSON builds)
+#define TOPIC_SENSOR_BATCH "auralink/sensor/batch"                    // Compressed backlog, see series_codec.h
+#define TOPIC_SENSOR_FLICKER "auralink/sensor/flicker"                // Flicker builds only, see flicker.h
+#define TOPIC_DEVICE_HEALTH "auralink/device/health"
+#define TOPIC_DEVICE_EVENT "auralink/device/event"
+#define TOPIC_DEVICE_RECOVERY "auralink/device/recovery"              // Every boot; "warm":false means a blank display
+#define TOPIC_RULES_STATUS "auralink/rules/status"
+#define TOPIC_CAPTURE_STATUS "auralink/device/capture/status"
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "led_effects.h"
+#include "payload.h"
+
+// ------------------------------------------------------------------
+// --- Warm Start State (RTC memory) ---
+// ------------------------------------------------------------------
+// Critical state mirrored into RTC slow memory, which survives software
+// resets, panics, watchdog resets and brownouts (but not power-on). Every
+// update recomputes a CRC32 over the whole record; on boot a record with
+// a bad magic, version or CRC (power-on garbage, or a reset mid-update)
+// is discarded and the device cold-starts.
+// With a valid record the device repaints the LCD, restores the urgency
+// LED, continues sequence numbers and rejoins the last WiFi channel/BSSID
+// and local broker without scanning or mDNS.
+
+#define WARM_TEXT_SLOTS 2
+#define WARM_TEXT_MAX 240   // Matches TEXT_STORE_CAPACITY
+
+struct WarmBrokerHint {
+  char name[40];
+  char host[16];   // Dotted IP
+  uint16_t port;
+};
+
+struct WarmState {
+  uint32_t bootCount;        // Consecutive warm boots + 1
+  uint32_t sampleSeq;        // Next sample sequence number
+  SensorSample lastSample;
+  bool haveSample;
+  char text[WARM_TEXT_SLOTS][WARM_TEXT_MAX + 1];
+  LedEffect urgency;
+  bool haveUrgency;
+  uint8_t wifiChannel;       // 0 = unknown
+  uint8_t wifiBssid[6];
+  WarmBrokerHint localBroker;
+  bool haveLocalBroker;
+};
+
+// Validates the RTC record and starts a fresh one if it is unusable.
+// Returns true when the previous state survived the reset.
+bool warmStateBegin();
+
+// Copy of the state as found at boot (zeroed on a cold start)
+const WarmState& warmStateRestored();
+
+// Setters are safe from any task; each re-seals the record.
+void warmStateSaveSample(const SensorSample& sample, uint32_t nextSeq);
+void warmStateSaveText(uint8_t slot, const char* text);
+void warmStateSaveUrgency(const LedEffect& effect);
+void warmStateSaveWifi(uint8_t channel, const uint8_t* bssid);
+void warmStateSaveLocalBroker(const WarmBrokerHint* hint);   // nullptr clears it
+
+const char* resetReasonName(esp_reset_reason_t reason);
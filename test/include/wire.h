@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "auralink.pb.h"
+#include "payload.h"
+#include "text_store.h"
+
+// ------------------------------------------------------------------
+// --- Protobuf Wire Format (proto/auralink.proto, nanopb) ---
+// ------------------------------------------------------------------
+// Uplink samples are encoded from a stack-allocated message into a
+// caller buffer of WIRE_UPLINK_MAX bytes. Downlinks are decoded without
+// copying: text, rules and capture bodies come back as spans into the
+// received payload, which the caller hands on to the same text store,
+// rules loader and capture parser the plain-topic path uses. Nothing is
+// heap-allocated on either path.
+// Portable (no Arduino).
+
+#define WIRE_SCHEMA_VERSION auralink_SchemaVersion_SCHEMA_V1
+#define WIRE_UPLINK_MAX auralink_Uplink_size
+
+enum WireDownlinkKind : uint8_t {
+  WIRE_DOWNLINK_QUOTE,
+  WIRE_DOWNLINK_SUMMARY,
+  WIRE_DOWNLINK_URGENCY,
+  WIRE_DOWNLINK_RULES,
+  WIRE_DOWNLINK_CAPTURE
+};
+
+struct WireDownlink {
+  uint8_t schema;
+  WireDownlinkKind kind;
+  bool chunked;              // Quote/summary: one piece of a longer text
+  ChunkHeader chunk;         // Valid when chunked
+  auralink_UrgencyLevel urgency;
+  const uint8_t* data;       // Text/rules/capture body, points into the payload (NULL if empty)
+  size_t len;
+};
+
+// Encodes one sample as an Uplink; 0 if buf is too small
+size_t wireEncodeSample(const SensorSample& s, uint8_t* buf, size_t len);
+
+// Decodes a Downlink carrying exactly one body (the `body` oneof, which
+// nanopb generates as separate fields). False with a reason in err on
+// malformed input, an unknown schema version or zero/several bodies;
+// `out` is only valid while `payload` is.
+bool wireDecodeDownlink(const uint8_t* payload, size_t len, WireDownlink& out,
+                        char* err, size_t errLen);
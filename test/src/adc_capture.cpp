@@ -0,0 +1,324 @@
+#include "adc_capture.h"
+
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <driver/adc.h>
+#include <driver/i2s.h>
+#include <esp_timer.h>
+#include <soc/syscon_struct.h>
+
+#define CAPTURE_I2S I2S_NUM_0
+#define CAPTURE_CHANNELS 2
+#define CAPTURE_SLOT_END 0xFF   // Reader -> sink: capture over, close the sink
+
+enum CaptureState : uint8_t { STATE_IDLE, STATE_OPENING, STATE_RUNNING, STATE_DONE, STATE_FAILED };
+static const char* const stateNames[] = {"idle", "opening", "running", "done", "failed"};
+static const char* const sinkNames[] = {"file", "tcp", "udp"};
+
+// ADC1 channel -> capture channel (LDR first, then NOx)
+static const adc1_channel_t adcChannels[CAPTURE_CHANNELS] = {ADC1_CHANNEL_6, ADC1_CHANNEL_7};
+
+static TaskHandle_t readerTask = nullptr;
+static TaskHandle_t sinkTask = nullptr;
+static QueueHandle_t freeSlots = nullptr;
+static QueueHandle_t readySlots = nullptr;
+static QueueHandle_t i2sEvents = nullptr;
+
+static uint8_t slots[CAPTURE_SLOTS][CAPTURE_BLOCK_MAX];
+static uint16_t slotLen[CAPTURE_SLOTS];
+static uint16_t dmaWords[CAPTURE_DMA_SAMPLES];
+static uint16_t frameBuf[CAPTURE_BLOCK_FRAMES * CAPTURE_CHANNELS];
+
+static CaptureRequest active;
+static volatile uint8_t state = STATE_IDLE;
+static volatile bool stopRequested = false;
+static volatile bool sinkFailed = false;
+static char lastError[48] = "";
+
+static portMUX_TYPE latestMux = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t latest[CAPTURE_CHANNELS];
+
+// Stats of the current (or last) capture
+static uint32_t framesCaptured = 0;
+static uint32_t framesDropped = 0;      // No free slot: the sink fell behind
+static uint32_t dmaOverruns = 0;        // The reader fell behind the DMA
+static uint32_t blocksWritten = 0;
+static uint32_t bytesWritten = 0;
+static uint32_t encodeMaxUs = 0;
+static uint64_t startedUs = 0;
+static uint64_t endedUs = 0;
+
+static File file;
+static WiFiClient tcp;
+static WiFiUDP udp;
+
+// ------------------------------------------------------------------
+// --- Reader: I2S DMA -> frames -> encoded blocks ---
+// ------------------------------------------------------------------
+static bool startAdc(uint32_t rateHz) {
+  i2s_config_t config = {};
+  config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+  config.sample_rate = rateHz * CAPTURE_CHANNELS;   // Conversions per second across the scan
+  config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+  config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+  config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+  config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+  config.dma_buf_count = CAPTURE_DMA_BUFFERS;
+  config.dma_buf_len = CAPTURE_DMA_SAMPLES;
+  if (i2s_driver_install(CAPTURE_I2S, &config, 4, &i2sEvents) != ESP_OK) return false;
+  for (adc1_channel_t ch : adcChannels) adc1_config_channel_atten(ch, ADC_ATTEN_DB_11);
+  adc1_config_width(ADC_WIDTH_BIT_12);
+  i2s_set_adc_mode(ADC_UNIT_1, adcChannels[0]);
+  i2s_adc_enable(CAPTURE_I2S);
+  // The driver programs a one-entry scan; extend the SAR1 pattern table
+  // to both channels. Entry: channel << 4 | width (3 = 12 bit) << 2 | atten.
+  uint32_t pattern = 0;
+  for (uint8_t i = 0; i < CAPTURE_CHANNELS; i++) {
+    pattern |= (uint32_t)((adcChannels[i] << 4) | (3 << 2) | ADC_ATTEN_DB_11) << (24 - 8 * i);
+  }
+  SYSCON.saradc_ctrl.sar1_patt_len = CAPTURE_CHANNELS - 1;
+  SYSCON.saradc_sar1_patt_tab[0] = pattern;
+  return true;
+}
+
+static void stopAdc() {
+  i2s_adc_disable(CAPTURE_I2S);
+  i2s_driver_uninstall(CAPTURE_I2S);
+  i2sEvents = nullptr;
+}
+
+// Hands `frames` buffered frames to the sink, or drops them if every slot
+// is still being written
+static void emitBlock(uint32_t firstFrame, uint16_t frames) {
+  uint8_t slot;
+  if (xQueueReceive(freeSlots, &slot, 0) != pdTRUE) {
+    framesDropped += frames;
+    return;
+  }
+  CaptureBlockInfo info = {CAPTURE_CHANNELS, active.rateHz, firstFrame, framesDropped};
+  uint64_t t0 = esp_timer_get_time();
+  slotLen[slot] = captureEncodeBlock(info, frameBuf, frames, slots[slot], CAPTURE_BLOCK_MAX);
+  uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+  if (us > encodeMaxUs) encodeMaxUs = us;
+  xQueueSend(readySlots, &slot, portMAX_DELAY);
+}
+
+static void runCapture() {
+  if (!startAdc(active.rateHz)) {
+    snprintf(lastError, sizeof(lastError), "i2s adc init failed");
+    sinkFailed = true;
+    return;
+  }
+  state = STATE_RUNNING;
+  startedUs = esp_timer_get_time();
+  uint64_t deadlineUs = startedUs + (uint64_t)active.seconds * 1000000ULL;
+  uint32_t frameIndex = 0;
+  uint16_t fill = 0;
+  uint16_t current[CAPTURE_CHANNELS] = {0, 0};
+  uint8_t seen = 0;
+
+  while (!stopRequested && !sinkFailed && (uint64_t)esp_timer_get_time() < deadlineUs) {
+    size_t got = 0;
+    i2s_read(CAPTURE_I2S, dmaWords, sizeof(dmaWords), &got, pdMS_TO_TICKS(100));
+    i2s_event_t event;
+    while (xQueueReceive(i2sEvents, &event, 0) == pdTRUE) {
+      if (event.type == I2S_EVENT_RX_Q_OVF) dmaOverruns++;
+    }
+    for (size_t i = 0; i < got / sizeof(uint16_t); i++) {
+      // Each word carries its channel in the top nibble, so the pairwise
+      // word swap of the I2S FIFO does not matter
+      uint8_t ch = dmaWords[i] >> 12;
+      uint8_t c = ch == adcChannels[0] ? 0 : ch == adcChannels[1] ? 1 : CAPTURE_CHANNELS;
+      if (c >= CAPTURE_CHANNELS) continue;
+      current[c] = dmaWords[i] & 0x0FFF;
+      seen |= 1 << c;
+      if (seen != (1 << CAPTURE_CHANNELS) - 1) continue;
+      seen = 0;
+      memcpy(&frameBuf[fill * CAPTURE_CHANNELS], current, sizeof(current));
+      if (++fill == CAPTURE_BLOCK_FRAMES) {
+        emitBlock(frameIndex, fill);
+        frameIndex += fill;
+        fill = 0;
+      }
+    }
+    framesCaptured = frameIndex + fill;
+    portENTER_CRITICAL(&latestMux);
+    memcpy(latest, current, sizeof(latest));
+    portEXIT_CRITICAL(&latestMux);
+  }
+  if (fill > 0) emitBlock(frameIndex, fill);
+  stopAdc();
+}
+
+static void readerLoop(void*) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);   // Sink is open
+    runCapture();
+    endedUs = esp_timer_get_time();
+    uint8_t end = CAPTURE_SLOT_END;
+    xQueueSend(readySlots, &end, portMAX_DELAY);
+  }
+}
+
+// ------------------------------------------------------------------
+// --- Sink: encoded blocks -> LittleFS / TCP / UDP ---
+// ------------------------------------------------------------------
+static bool openSink() {
+  IPAddress ip;
+  switch (active.sink) {
+    case CAPTURE_SINK_FILE:
+      if (!LittleFS.begin(true)) {
+        snprintf(lastError, sizeof(lastError), "littlefs mount failed");
+        return false;
+      }
+      LittleFS.remove(CAPTURE_FILE_PATH);
+      file = LittleFS.open(CAPTURE_FILE_PATH, FILE_WRITE);
+      if (!file) snprintf(lastError, sizeof(lastError), "cannot create " CAPTURE_FILE_PATH);
+      return (bool)file;
+    case CAPTURE_SINK_TCP:
+      ip.fromString(active.host);
+      if (!tcp.connect(ip, active.port, CAPTURE_CONNECT_TIMEOUT_MS)) {
+        snprintf(lastError, sizeof(lastError), "connect %s:%u failed", active.host, active.port);
+        return false;
+      }
+      tcp.setNoDelay(true);
+      return true;
+    default:
+      return udp.begin(0) != 0;
+  }
+}
+
+static bool writeSink(const uint8_t* data, size_t len) {
+  IPAddress ip;
+  switch (active.sink) {
+    case CAPTURE_SINK_FILE:
+      return file.write(data, len) == len;
+    case CAPTURE_SINK_TCP:
+      return tcp.write(data, len) == len;
+    default:
+      // A lost datagram shows up as a gap in firstFrame; only a local
+      // send failure ends the capture
+      ip.fromString(active.host);
+      return udp.beginPacket(ip, active.port) && udp.write(data, len) == len && udp.endPacket();
+  }
+}
+
+static void closeSink() {
+  switch (active.sink) {
+    case CAPTURE_SINK_FILE: file.close(); break;
+    case CAPTURE_SINK_TCP:  tcp.stop(); break;
+    default:                udp.stop(); break;
+  }
+}
+
+static void sinkLoop(void*) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);   // Start requested
+    if (!openSink()) {
+      state = STATE_FAILED;
+      continue;
+    }
+    xTaskNotifyGive(readerTask);
+    for (;;) {
+      uint8_t slot;
+      xQueueReceive(readySlots, &slot, portMAX_DELAY);
+      if (slot == CAPTURE_SLOT_END) break;
+      if (!sinkFailed) {
+        if (writeSink(slots[slot], slotLen[slot])) {
+          blocksWritten++;
+          bytesWritten += slotLen[slot];
+        } else {
+          snprintf(lastError, sizeof(lastError), "%s write failed", sinkNames[active.sink]);
+          sinkFailed = true;
+        }
+      }
+      xQueueSend(freeSlots, &slot, portMAX_DELAY);
+    }
+    closeSink();
+    state = sinkFailed ? STATE_FAILED : STATE_DONE;
+    Serial.printf("Capture %s: %lu frames, %lu dropped, %lu DMA overruns, %lu bytes\n", stateNames[state],
+                  (unsigned long)framesCaptured, (unsigned long)framesDropped, (unsigned long)dmaOverruns,
+                  (unsigned long)bytesWritten);
+  }
+}
+
+// ------------------------------------------------------------------
+// --- Control ---
+// ------------------------------------------------------------------
+void captureBegin() {
+  freeSlots = xQueueCreate(CAPTURE_SLOTS, sizeof(uint8_t));
+  readySlots = xQueueCreate(CAPTURE_SLOTS + 1, sizeof(uint8_t));
+  for (uint8_t i = 0; i < CAPTURE_SLOTS; i++) xQueueSend(freeSlots, &i, 0);
+  // The reader outranks the sensor task so the DMA ring never overruns;
+  // the sink shares core 0 with the network task
+  xTaskCreatePinnedToCore(readerLoop, "capture", 3072, nullptr, 4, &readerTask, 1);
+  xTaskCreatePinnedToCore(sinkLoop, "capsink", 4096, nullptr, 1, &sinkTask, 0);
+}
+
+bool captureControl(const CaptureRequest& req, char* err, size_t errLen) {
+  if (req.action == CAPTURE_STOP) {
+    if (!captureActive()) {
+      snprintf(err, errLen, "no capture running");
+      return false;
+    }
+    stopRequested = true;
+    return true;
+  }
+  if (captureActive()) {
+    snprintf(err, errLen, "capture already running");
+    return false;
+  }
+  if (req.sink != CAPTURE_SINK_FILE && WiFi.status() != WL_CONNECTED) {
+    snprintf(err, errLen, "no network");
+    return false;
+  }
+  active = req;
+  stopRequested = false;
+  sinkFailed = false;
+  lastError[0] = '\0';
+  framesCaptured = framesDropped = dmaOverruns = 0;
+  blocksWritten = bytesWritten = encodeMaxUs = 0;
+  startedUs = endedUs = 0;
+  state = STATE_OPENING;
+  xTaskNotifyGive(sinkTask);
+  return true;
+}
+
+bool captureActive() { return state == STATE_OPENING || state == STATE_RUNNING; }
+
+bool captureLatest(uint16_t& ldr, uint16_t& nox) {
+  if (state != STATE_RUNNING) return false;
+  portENTER_CRITICAL(&latestMux);
+  ldr = latest[0];
+  nox = latest[1];
+  portEXIT_CRITICAL(&latestMux);
+  return true;
+}
+
+size_t captureFormatJson(char* buf, size_t len) {
+  uint64_t end = endedUs ? endedUs : esp_timer_get_time();
+  uint32_t elapsedMs = startedUs ? (uint32_t)((end - startedUs) / 1000) : 0;
+  // Measured frame rate, to check against the requested one
+  uint32_t measuredHz = elapsedMs ? (uint32_t)((uint64_t)framesCaptured * 1000 / elapsedMs) : 0;
+  uint32_t rawBytes = framesCaptured * CAPTURE_CHANNELS * 2;
+  int n = snprintf(buf, len,
+                   "{\"state\":\"%s\", \"sink\":\"%s\", \"rate\":%lu, \"measured_rate\":%lu, \"frames\":%lu, "
+                   "\"dropped\":%lu, \"dma_overruns\":%lu, \"blocks\":%lu, \"bytes\":%lu, \"ratio\":%.2f, "
+                   "\"encode_max_us\":%lu, \"error\":\"%s\"}",
+                   stateNames[state], sinkNames[active.sink], (unsigned long)active.rateHz,
+                   (unsigned long)measuredHz, (unsigned long)framesCaptured, (unsigned long)framesDropped,
+                   (unsigned long)dmaOverruns, (unsigned long)blocksWritten, (unsigned long)bytesWritten,
+                   bytesWritten ? (float)rawBytes / bytesWritten : 0.0f, (unsigned long)encodeMaxUs, lastError);
+  if (n < 0 || (size_t)n >= len) return 0;
+  return (size_t)n;
+}
+
+size_t captureReadFile(uint32_t offset, char* buf, size_t len) {
+  if (captureActive() && active.sink == CAPTURE_SINK_FILE) return 0;
+  if (!LittleFS.begin(false)) return 0;
+  File f = LittleFS.open(CAPTURE_FILE_PATH, FILE_READ);
+  if (!f || !f.seek(offset)) return 0;
+  size_t n = f.read((uint8_t*)buf, len);
+  f.close();
+  return n;
+}
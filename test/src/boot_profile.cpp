@@ -0,0 +1,39 @@
+#include "boot_profile.h"
+
+static const char* const phaseNames[BOOT_PHASE_COUNT] = {
+  "setup_done", "lcd_ready", "first_sample", "wifi_up",
+  "brokers_listed", "broker_healthy", "mqtt_connected", "first_publish"
+};
+
+#define BOOT_NOT_REACHED UINT32_MAX
+static volatile uint32_t phaseMs[BOOT_PHASE_COUNT] = {
+  BOOT_NOT_REACHED, BOOT_NOT_REACHED, BOOT_NOT_REACHED, BOOT_NOT_REACHED,
+  BOOT_NOT_REACHED, BOOT_NOT_REACHED, BOOT_NOT_REACHED, BOOT_NOT_REACHED
+};
+static portMUX_TYPE bootMux = portMUX_INITIALIZER_UNLOCKED;
+
+void bootMark(BootPhase phase) {
+  if (phase >= BOOT_PHASE_COUNT || phaseMs[phase] != BOOT_NOT_REACHED) return;
+  uint32_t now = millis();
+  portENTER_CRITICAL(&bootMux);
+  if (phaseMs[phase] == BOOT_NOT_REACHED) phaseMs[phase] = now;
+  portEXIT_CRITICAL(&bootMux);
+  Serial.printf("[boot] %s at %lu ms\n", phaseNames[phase], (unsigned long)now);
+}
+
+bool bootReached(BootPhase phase) {
+  return phase < BOOT_PHASE_COUNT && phaseMs[phase] != BOOT_NOT_REACHED;
+}
+
+size_t bootProfileFormatJson(char* buf, size_t len) {
+  int n = snprintf(buf, len, "{");
+  bool first = true;
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT && n > 0 && n < (int)len; i++) {
+    uint32_t ms = phaseMs[i];
+    if (ms == BOOT_NOT_REACHED) continue;
+    n += snprintf(buf + n, len - n, "%s\"%s\":%lu", first ? "" : ",", phaseNames[i], (unsigned long)ms);
+    first = false;
+  }
+  if (n > 0 && n < (int)len) n += snprintf(buf + n, len - n, "}");
+  return (n > 0 && n < (int)len) ? n : 0;
+}
@@ -0,0 +1,243 @@
+#include "broker_pool.h"
+
+#include <WiFi.h>
+
+#include "histogram.h"
+
+// Probe cadence and thresholds
+#define PROBE_INTERVAL_MS 10000
+#define PROBE_TIMEOUT_MS 2000
+#define PROBE_FAILS_TO_DOWN 2    // Consecutive failed probes before a broker is marked down
+#define PROBE_OKS_TO_UP 2        // Consecutive good probes before it is trusted again
+#define PROBE_TASK_STACK 4096
+#define PROBE_TASK_PRIORITY 1    // Below loopTask so sampling always wins
+
+#define POOL_HOST_MAX 64
+
+// The pool keeps its own copy of every endpoint: the caller may rebuild
+// its list (and the strings in it) while a probe is using an entry
+struct PoolEntry {
+  BrokerEndpoint ep;           // host/tlsName point into the arrays below
+  char host[POOL_HOST_MAX];
+  char tlsName[POOL_HOST_MAX];
+};
+
+static PoolEntry poolEntries[BROKER_POOL_MAX];
+static uint8_t poolCount = 0;
+static uint32_t poolGeneration = 0;   // Bumped per list; stale probe results are dropped
+static const char* poolProbeClientId = nullptr;
+static BrokerLinkUp poolLinkUp = nullptr;
+static BrokerHealth poolHealth[BROKER_POOL_MAX];
+static portMUX_TYPE poolMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t probeTaskHandle = nullptr;
+
+// Written only by the probe task
+static Histogram probeConnectHist("auralink_probe_connect_ms", "Broker probe TCP connect RTT");
+static Histogram probePingHist("auralink_probe_ping_ms", "Broker probe PINGREQ to PINGRESP latency");
+
+// ------------------------------------------------------------------
+// --- Helper: Copy an endpoint and its strings into an entry ---
+// ------------------------------------------------------------------
+// Runs inside the pool's critical section, so plain copies only
+static void copyString(char* dst, const char* src, size_t size) {
+  size_t n = src ? strnlen(src, size - 1) : 0;
+  if (n) memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+static void copyEntry(PoolEntry& dst, const BrokerEndpoint& src) {
+  copyString(dst.host, src.host, sizeof(dst.host));
+  copyString(dst.tlsName, src.tlsName, sizeof(dst.tlsName));
+  dst.ep = src;
+  dst.ep.host = dst.host;
+  dst.ep.tlsName = src.tlsName ? dst.tlsName : nullptr;
+}
+
+// ------------------------------------------------------------------
+// --- Helper: Wait for N bytes on the probe socket ---
+// ------------------------------------------------------------------
+static bool readExact(WiFiClient& c, uint8_t* buf, size_t len, uint32_t timeoutMs) {
+  uint32_t start = millis();
+  size_t got = 0;
+  while (got < len) {
+    if (millis() - start > timeoutMs || !c.connected()) return false;
+    int avail = c.available();
+    if (avail <= 0) {
+      vTaskDelay(pdMS_TO_TICKS(5));
+      continue;
+    }
+    int n = c.read(buf + got, len - got);
+    if (n > 0) got += n;
+  }
+  return true;
+}
+
+// ------------------------------------------------------------------
+// --- Probe one broker: TCP connect, CONNECT/CONNACK, PINGREQ/PINGRESP ---
+// ------------------------------------------------------------------
+static bool probeBroker(const BrokerEndpoint& ep, IPAddress& ip,
+                        uint32_t& connectRtt, uint32_t& pingRtt) {
+  // Addresses skip DNS; hostByName() also waits on WiFi state, which
+  // QEMU (Ethernet) builds never start
+  if (!ip.fromString(ep.host) && !WiFi.hostByName(ep.host, ip)) return false;
+
+  WiFiClient probe;
+  uint32_t t0 = millis();
+  if (!probe.connect(ip, ep.port, PROBE_TIMEOUT_MS)) return false;
+  connectRtt = millis() - t0;
+  if (ep.tls) {
+    probe.stop();   // No ping: pingRtt is left alone
+    return true;
+  }
+
+  // MQTT 3.1.1 CONNECT, clean session, 10 s keep-alive, no credentials
+  size_t idLen = strlen(poolProbeClientId);
+  uint8_t pkt[64];
+  if (idLen > sizeof(pkt) - 14) idLen = sizeof(pkt) - 14;
+  size_t n = 0;
+  pkt[n++] = 0x10;
+  pkt[n++] = (uint8_t)(12 + idLen);
+  const uint8_t header[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, 0x02, 0x00, 0x0A};
+  memcpy(pkt + n, header, sizeof(header));
+  n += sizeof(header);
+  pkt[n++] = (uint8_t)(idLen >> 8);
+  pkt[n++] = (uint8_t)(idLen & 0xFF);
+  memcpy(pkt + n, poolProbeClientId, idLen);
+  n += idLen;
+  probe.write(pkt, n);
+
+  uint8_t connack[4];
+  if (!readExact(probe, connack, sizeof(connack), PROBE_TIMEOUT_MS) ||
+      connack[0] != 0x20 || connack[3] != 0x00) {
+    probe.stop();
+    return false;
+  }
+
+  const uint8_t pingreq[] = {0xC0, 0x00};
+  uint8_t pingresp[2];
+  t0 = millis();
+  probe.write(pingreq, sizeof(pingreq));
+  bool ok = readExact(probe, pingresp, sizeof(pingresp), PROBE_TIMEOUT_MS) &&
+            pingresp[0] == 0xD0;
+  if (ok) pingRtt = millis() - t0;
+
+  const uint8_t disconnect[] = {0xE0, 0x00};
+  probe.write(disconnect, sizeof(disconnect));
+  probe.stop();
+  return ok;
+}
+
+// ------------------------------------------------------------------
+// --- Helper: Record one probe outcome with hysteresis ---
+// ------------------------------------------------------------------
+// `pingRtt` is null when the probe did not measure one (TLS), so the
+// last good value stays; a failed probe keeps both RTTs as they were.
+static void recordOutcome(uint32_t generation, uint8_t index, bool ok, const IPAddress* ip,
+                          uint32_t connectRtt, const uint32_t* pingRtt) {
+  portENTER_CRITICAL(&poolMux);
+  if (generation != poolGeneration) {
+    // The list was replaced while this probe ran
+    portEXIT_CRITICAL(&poolMux);
+    return;
+  }
+  BrokerHealth& h = poolHealth[index];
+  h.lastProbeMs = millis();
+  if (ok) {
+    // A broker that has never been probed comes up on its first good probe;
+    // one that went down has to prove itself PROBE_OKS_TO_UP times.
+    bool firstProbe = !h.probed;
+    h.probed = true;
+    h.ip = *ip;
+    h.connectRttMs = connectRtt;
+    if (pingRtt) h.pingRttMs = *pingRtt;
+    h.consecutiveFailures = 0;
+    if (h.consecutiveSuccesses < 0xFFFF) h.consecutiveSuccesses++;
+    if (firstProbe || h.consecutiveSuccesses >= PROBE_OKS_TO_UP) h.healthy = true;
+  } else {
+    h.probed = true;
+    h.consecutiveSuccesses = 0;
+    if (h.consecutiveFailures < 0xFFFF) h.consecutiveFailures++;
+    if (h.consecutiveFailures >= PROBE_FAILS_TO_DOWN) h.healthy = false;
+  }
+  portEXIT_CRITICAL(&poolMux);
+}
+
+static void probeTask(void*) {
+  for (;;) {
+    if (poolLinkUp()) {
+      for (uint8_t i = 0;; i++) {
+        // Copied under lock, strings included: brokerPoolBegin() may
+        // replace the list while this probe runs
+        PoolEntry entry;
+        portENTER_CRITICAL(&poolMux);
+        bool more = i < poolCount;
+        if (more) copyEntry(entry, poolEntries[i].ep);
+        uint32_t generation = poolGeneration;
+        portEXIT_CRITICAL(&poolMux);
+        if (!more) break;
+        const BrokerEndpoint& ep = entry.ep;
+
+        IPAddress ip;
+        uint32_t connectRtt = 0, pingRtt = 0;
+        bool ok = probeBroker(ep, ip, connectRtt, pingRtt);
+        if (ok) {
+          probeConnectHist.record(connectRtt);
+          if (!ep.tls) probePingHist.record(pingRtt);
+        }
+        recordOutcome(generation, i, ok, &ip, connectRtt, ep.tls ? nullptr : &pingRtt);
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(PROBE_INTERVAL_MS));
+  }
+}
+
+void brokerPoolBegin(const BrokerEndpoint* brokers, uint8_t count,
+                     const char* probeClientId, BrokerLinkUp linkUp) {
+  if (count > BROKER_POOL_MAX) count = BROKER_POOL_MAX;
+  portENTER_CRITICAL(&poolMux);
+  for (uint8_t i = 0; i < count; i++) copyEntry(poolEntries[i], brokers[i]);
+  poolCount = count;
+  poolGeneration++;
+  poolProbeClientId = probeClientId;
+  poolLinkUp = linkUp;
+  for (uint8_t i = 0; i < BROKER_POOL_MAX; i++) poolHealth[i] = BrokerHealth();
+  portEXIT_CRITICAL(&poolMux);
+  if (probeTaskHandle) return;
+
+  metricsRegister(&probeConnectHist);
+  metricsRegister(&probePingHist);
+  xTaskCreatePinnedToCore(probeTask, "brokerProbe", PROBE_TASK_STACK, nullptr,
+                          PROBE_TASK_PRIORITY, &probeTaskHandle, 0);
+}
+
+uint8_t brokerPoolCount() { return poolCount; }
+
+const BrokerEndpoint& brokerPoolEndpoint(uint8_t index) { return poolEntries[index].ep; }
+
+BrokerHealth brokerPoolHealth(uint8_t index) {
+  portENTER_CRITICAL(&poolMux);
+  BrokerHealth h = poolHealth[index];
+  portEXIT_CRITICAL(&poolMux);
+  return h;
+}
+
+int8_t brokerPoolPreferred() {
+  int8_t best = -1;
+  portENTER_CRITICAL(&poolMux);
+  for (uint8_t i = 0; i < poolCount; i++) {
+    if (poolHealth[i].healthy) {
+      best = i;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&poolMux);
+  return best;
+}
+
+void brokerPoolReportFailure(uint8_t index) {
+  if (index >= poolCount) return;
+  portENTER_CRITICAL(&poolMux);
+  poolHealth[index].healthy = false;
+  poolHealth[index].consecutiveSuccesses = 0;
+  portEXIT_CRITICAL(&poolMux);
+}
@@ -0,0 +1,153 @@
+#include "capture_codec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void putU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+size_t captureEncodeBlock(const CaptureBlockInfo& info, const uint16_t* values, uint16_t frames,
+                          uint8_t* out, size_t len) {
+  if (info.channels == 0 || info.channels > CAPTURE_MAX_CHANNELS || frames == 0) return 0;
+  if (len < CAPTURE_HEADER_BYTES) return 0;
+  size_t n = CAPTURE_HEADER_BYTES;
+  for (uint8_t c = 0; c < info.channels; c++) {
+    uint16_t prev = values[c];
+    if (n + 2 > len) return 0;
+    putU16(out + n, prev);
+    n += 2;
+    for (uint16_t f = 1; f < frames; f++) {
+      uint16_t v = values[f * info.channels + c];
+      int32_t delta = (int32_t)v - (int32_t)prev;
+      uint32_t zz = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+      prev = v;
+      do {
+        if (n >= len) return 0;
+        uint8_t byte = zz & 0x7F;
+        zz >>= 7;
+        out[n++] = zz ? (byte | 0x80) : byte;
+      } while (zz);
+    }
+  }
+  out[0] = 'A';
+  out[1] = 'C';
+  out[2] = CAPTURE_VERSION;
+  out[3] = info.channels;
+  putU32(out + 4, info.rateHz);
+  putU32(out + 8, info.firstFrame);
+  putU32(out + 12, info.droppedFrames);
+  putU16(out + 16, frames);
+  putU16(out + 18, (uint16_t)(n - CAPTURE_HEADER_BYTES));
+  return n;
+}
+
+// ------------------------------------------------------------------
+// --- Command parsing ---
+// ------------------------------------------------------------------
+static bool fail(char* err, size_t errLen, const char* msg, const char* arg, size_t argLen) {
+  snprintf(err, errLen, "%s: %.*s", msg, (int)argLen, arg);
+  return false;
+}
+
+static bool parseUint(const char* s, size_t len, uint32_t max, uint32_t& out) {
+  if (len == 0 || len > 10) return false;
+  uint64_t v = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (s[i] < '0' || s[i] > '9') return false;
+    v = v * 10 + (s[i] - '0');
+  }
+  if (v > max) return false;
+  out = (uint32_t)v;
+  return true;
+}
+
+// <a.b.c.d>:<port>
+static bool parseEndpoint(const char* s, size_t len, CaptureRequest& out) {
+  const char* colon = (const char*)memchr(s, ':', len);
+  if (!colon) return false;
+  size_t hostLen = colon - s;
+  if (hostLen < 7 || hostLen >= sizeof(out.host)) return false;
+  uint8_t dots = 0;
+  uint32_t octet = 0;
+  size_t digits = 0;
+  for (size_t i = 0; i <= hostLen; i++) {
+    if (i == hostLen || s[i] == '.') {
+      if (digits == 0 || octet > 255) return false;
+      if (i < hostLen) dots++;
+      octet = 0;
+      digits = 0;
+    } else if (s[i] >= '0' && s[i] <= '9' && digits < 3) {
+      octet = octet * 10 + (s[i] - '0');
+      digits++;
+    } else {
+      return false;
+    }
+  }
+  uint32_t port;
+  if (dots != 3 || !parseUint(colon + 1, len - hostLen - 1, 65535, port) || port == 0) return false;
+  memcpy(out.host, s, hostLen);
+  out.host[hostLen] = '\0';
+  out.port = (uint16_t)port;
+  return true;
+}
+
+bool captureParseCommand(const char* text, size_t len, CaptureRequest& out, char* err, size_t errLen) {
+  CaptureRequest req = {};
+  req.rateHz = CAPTURE_DEFAULT_RATE_HZ;
+  req.seconds = CAPTURE_DEFAULT_SECS;
+
+  uint8_t index = 0;
+  size_t i = 0;
+  while (i < len) {
+    while (i < len && (text[i] == ' ' || text[i] == '\t' || text[i] == '\r' || text[i] == '\n')) i++;
+    size_t start = i;
+    while (i < len && text[i] != ' ' && text[i] != '\t' && text[i] != '\r' && text[i] != '\n') i++;
+    const char* tok = text + start;
+    size_t tokLen = i - start;
+    if (tokLen == 0) break;
+
+    if (index == 0) {
+      if (tokLen == 5 && memcmp(tok, "start", 5) == 0) {
+        req.action = CAPTURE_START;
+      } else if (tokLen == 4 && memcmp(tok, "stop", 4) == 0) {
+        req.action = CAPTURE_STOP;
+      } else {
+        return fail(err, errLen, "unknown command", tok, tokLen);
+      }
+    } else if (req.action == CAPTURE_STOP) {
+      return fail(err, errLen, "unexpected argument", tok, tokLen);
+    } else if (index == 1) {
+      if (tokLen == 4 && memcmp(tok, "file", 4) == 0) {
+        req.sink = CAPTURE_SINK_FILE;
+      } else if (tokLen > 6 && memcmp(tok, "tcp://", 6) == 0 && parseEndpoint(tok + 6, tokLen - 6, req)) {
+        req.sink = CAPTURE_SINK_TCP;
+      } else if (tokLen > 6 && memcmp(tok, "udp://", 6) == 0 && parseEndpoint(tok + 6, tokLen - 6, req)) {
+        req.sink = CAPTURE_SINK_UDP;
+      } else {
+        return fail(err, errLen, "bad sink", tok, tokLen);
+      }
+    } else if (tokLen > 5 && memcmp(tok, "rate=", 5) == 0) {
+      if (!parseUint(tok + 5, tokLen - 5, CAPTURE_MAX_RATE_HZ, req.rateHz) || req.rateHz == 0) {
+        return fail(err, errLen, "bad rate", tok, tokLen);
+      }
+    } else if (tokLen > 5 && memcmp(tok, "secs=", 5) == 0) {
+      if (!parseUint(tok + 5, tokLen - 5, CAPTURE_MAX_SECS, req.seconds) || req.seconds == 0) {
+        return fail(err, errLen, "bad duration", tok, tokLen);
+      }
+    } else {
+      return fail(err, errLen, "unknown argument", tok, tokLen);
+    }
+    index++;
+  }
+  if (index == 0) return fail(err, errLen, "empty command", "", 0);
+  if (req.action == CAPTURE_START && index < 2) return fail(err, errLen, "missing sink", "", 0);
+  out = req;
+  return true;
+}
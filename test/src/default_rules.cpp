@@ -0,0 +1,12 @@
+#include "default_rules.h"
+
+const char defaultRules[] =
+  "nox <= 30 -> led nox off\n"
+  "nox > 60 -> led nox on\n"
+  "nox > 30 && nox <= 60 -> led nox blink 100\n"
+  "pir == 1 -> led pir blink 100\n"
+  "pir != 1 -> led pir off\n"
+  "temp > 30 || temp < 20 -> led temp blink 150\n"
+  "temp >= 20 && temp <= 30 -> led temp on\n"
+  "light > 50 -> led light off\n"
+  "light <= 50 -> led light on\n";
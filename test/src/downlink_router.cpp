@@ -0,0 +1,43 @@
+#include "downlink_router.h"
+
+#include <string.h>
+
+const char* const textTopics[TEXT_SLOT_COUNT] = {TOPIC_DISPLAY_QUOTE, TOPIC_DISPLAY_SUMMARY};
+
+DownlinkRoute downlinkRoute(const char* topic, DownlinkTarget& out) {
+  out.route = DOWNLINK_ROUTE_NONE;
+  if (strcmp(topic, TOPIC_DOWNLINK) == 0) {
+    out.route = DOWNLINK_ROUTE_PROTOBUF;
+  } else if (strcmp(topic, TOPIC_RULES_SET) == 0) {
+    out.route = DOWNLINK_ROUTE_RULES;
+  } else if (strcmp(topic, TOPIC_CAPTURE_CONTROL) == 0) {
+    out.route = DOWNLINK_ROUTE_CAPTURE;
+  } else if (strcmp(topic, TOPIC_URGENCY_LED) == 0) {
+    out.route = DOWNLINK_ROUTE_URGENCY;
+  } else {
+    for (uint8_t slot = 0; slot < TEXT_SLOT_COUNT; slot++) {
+      TextTopicKind kind = parseTextTopic(topic, textTopics[slot], out.chunk);
+      if (kind == TEXT_TOPIC_NONE) continue;
+      out.route = DOWNLINK_ROUTE_TEXT;
+      out.textSlot = (TextSlot)slot;
+      out.textKind = kind;
+      break;
+    }
+  }
+  return out.route;
+}
+
+// The payload is not NUL-terminated
+static bool contains(const uint8_t* payload, size_t len, const char* word) {
+  size_t n = strlen(word);
+  for (size_t i = 0; i + n <= len; i++) {
+    if (memcmp(payload + i, word, n) == 0) return true;
+  }
+  return false;
+}
+
+auralink_UrgencyLevel urgencyFromText(const uint8_t* payload, size_t len) {
+  if (contains(payload, len, "HIGH")) return auralink_UrgencyLevel_URGENCY_HIGH;
+  if (contains(payload, len, "MEDIUM")) return auralink_UrgencyLevel_URGENCY_MEDIUM;
+  return auralink_UrgencyLevel_URGENCY_LOW;
+}
@@ -0,0 +1,131 @@
+#include "event_bus.h"
+
+#include <stdarg.h>
+
+#include "mpmc_queue.h"
+
+struct Subscriber {
+  const char* name;
+  uint32_t typeMask;
+  Histogram* latency;
+  volatile TaskHandle_t task;
+  MpmcQueue<Event, EVENT_QUEUE_DEPTH> queue;
+  std::atomic<uint32_t> delivered{0};
+  std::atomic<uint32_t> dropped{0};
+  std::atomic<uint32_t> peakDepth{0};
+};
+
+static Subscriber subscribers[EVENT_BUS_MAX_SUBSCRIBERS];
+static std::atomic<uint8_t> subscriberCount{0};
+static portMUX_TYPE subscribeMux = portMUX_INITIALIZER_UNLOCKED;
+
+int8_t eventBusSubscribe(const char* name, uint32_t typeMask, Histogram* latency) {
+  int8_t id = -1;
+  portENTER_CRITICAL(&subscribeMux);
+  uint8_t count = subscriberCount.load(std::memory_order_relaxed);
+  if (count < EVENT_BUS_MAX_SUBSCRIBERS) {
+    Subscriber& sub = subscribers[count];
+    sub.name = name;
+    sub.typeMask = typeMask;
+    sub.latency = latency;
+    sub.task = nullptr;
+    // Publishers only look at slots below the count, so the slot must be
+    // fully written before it is published
+    subscriberCount.store(count + 1, std::memory_order_release);
+    id = count;
+  }
+  portEXIT_CRITICAL(&subscribeMux);
+  return id;
+}
+
+uint8_t eventBusPublish(Event& event) {
+  event.publishedUs = micros();
+  uint32_t bit = EVENT_MASK(event.type);
+  uint8_t count = subscriberCount.load(std::memory_order_acquire);
+  uint8_t delivered = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    Subscriber& sub = subscribers[i];
+    if (!(sub.typeMask & bit)) continue;
+    if (!sub.queue.push(event)) {
+      sub.dropped.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    uint32_t depth = sub.queue.size();
+    if (depth > sub.peakDepth.load(std::memory_order_relaxed)) {
+      sub.peakDepth.store(depth, std::memory_order_relaxed);
+    }
+    TaskHandle_t task = sub.task;
+    if (task) xTaskNotifyGive(task);
+    delivered++;
+  }
+  return delivered;
+}
+
+bool eventBusReceive(int8_t id, Event& event, TickType_t wait) {
+  if (id < 0 || id >= subscriberCount.load(std::memory_order_acquire)) return false;
+  Subscriber& sub = subscribers[id];
+  // A restarted task takes over its predecessor's queue
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  if (sub.task != self) sub.task = self;
+  bool got = sub.queue.pop(event);
+  if (!got && wait > 0) {
+    // Notifications can outnumber events (one per push, drained by one
+    // pop), so a wake-up with an empty queue is normal
+    ulTaskNotifyTake(pdTRUE, wait);
+    got = sub.queue.pop(event);
+  }
+  if (!got) return false;
+  sub.delivered.fetch_add(1, std::memory_order_relaxed);
+  if (sub.latency) sub.latency->record(micros() - event.publishedUs);
+  return true;
+}
+
+// ------------------------------------------------------------------
+// --- Convenience Publishers ---
+// ------------------------------------------------------------------
+void eventBusDisplayText(uint8_t row, const char* fmt, ...) {
+  Event event;
+  event.type = EVENT_DISPLAY_TEXT;
+  event.display.row = row;
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(event.display.text, sizeof(event.display.text), fmt, ap);
+  va_end(ap);
+  eventBusPublish(event);
+}
+
+void eventBusDisplayClear() {
+  Event event;
+  event.type = EVENT_DISPLAY_CLEAR;
+  eventBusPublish(event);
+}
+
+void eventBusDisplayStore(uint8_t slot) {
+  Event event;
+  event.type = EVENT_DISPLAY_STORE;
+  event.store.slot = slot;
+  eventBusPublish(event);
+}
+
+void eventBusLed(uint8_t index, const LedEffect& effect) {
+  Event event;
+  event.type = EVENT_LED;
+  event.led.index = index;
+  event.led.effect = effect;
+  eventBusPublish(event);
+}
+
+size_t eventBusFormatJson(char* buf, size_t len) {
+  uint8_t count = subscriberCount.load(std::memory_order_acquire);
+  int n = snprintf(buf, len, "{");
+  for (uint8_t i = 0; i < count && n > 0 && n < (int)len; i++) {
+    const Subscriber& sub = subscribers[i];
+    n += snprintf(buf + n, len - n, "%s\"%s\":{\"delivered\":%lu,\"dropped\":%lu,\"peak_depth\":%lu}",
+                  i ? "," : "", sub.name,
+                  (unsigned long)sub.delivered.load(std::memory_order_relaxed),
+                  (unsigned long)sub.dropped.load(std::memory_order_relaxed),
+                  (unsigned long)sub.peakDepth.load(std::memory_order_relaxed));
+  }
+  if (n > 0 && n < (int)len) n += snprintf(buf + n, len - n, "}");
+  return (n > 0 && n < (int)len) ? n : 0;
+}
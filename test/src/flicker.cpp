@@ -0,0 +1,105 @@
+#include "flicker.h"
+
+#include <math.h>
+
+#include "readings.h"
+
+void flickerHannWindow(float* window, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / (float)(n - 1));
+  }
+}
+
+void flickerPrepare(const uint16_t* raw, size_t n, float* cplx, FlickerResult& out) {
+  float sum = 0, lo = ADC_FULL_SCALE, hi = 0;
+  for (size_t i = 0; i < n; i++) {
+    float v = (float)(ADC_FULL_SCALE - raw[i]);
+    sum += v;
+    if (v < lo) lo = v;
+    if (v > hi) hi = v;
+  }
+  float mean = sum / n;
+  float above = 0, power = 0;
+  for (size_t i = 0; i < n; i++) {
+    float ac = (float)(ADC_FULL_SCALE - raw[i]) - mean;
+    if (ac > 0) above += ac;
+    power += ac * ac;
+    cplx[2 * i] = ac;
+    cplx[2 * i + 1] = 0;
+  }
+  out.meanLight = mean;
+  out.acRms = sqrtf(power / n);
+  out.flickerIndex = sum > 0 ? above / sum : 0;
+  out.percentFlicker = hi + lo > 0 ? (hi - lo) / (hi + lo) * 100.0f : 0;
+  out.dominantHz = 0;
+}
+
+void flickerWindowScalar(float* cplx, const float* window, size_t n) {
+  for (size_t i = 0; i < n; i++) cplx[2 * i] *= window[i];
+}
+
+// Iterative radix-2 decimation-in-time, in place, natural-order output
+void flickerFftScalar(float* cplx, size_t n) {
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j |= bit;
+    if (i < j) {
+      float re = cplx[2 * i], im = cplx[2 * i + 1];
+      cplx[2 * i] = cplx[2 * j];
+      cplx[2 * i + 1] = cplx[2 * j + 1];
+      cplx[2 * j] = re;
+      cplx[2 * j + 1] = im;
+    }
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    float angle = -2.0f * (float)M_PI / len;
+    for (size_t k = 0; k < len / 2; k++) {
+      float wr = cosf(angle * k), wi = sinf(angle * k);
+      for (size_t s = 0; s < n; s += len) {
+        float* a = &cplx[2 * (s + k)];
+        float* b = &cplx[2 * (s + k + len / 2)];
+        float tr = b[0] * wr - b[1] * wi;
+        float ti = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+}
+
+void flickerFromSpectrum(float* cplx, size_t n, float rateHz, FlickerResult& out) {
+  out.dominantHz = 0;
+  if (out.acRms < FLICKER_NOISE_FLOOR) return;
+  // Magnitudes of the positive half, written over the real parts
+  for (size_t k = 0; k <= n / 2; k++) {
+    cplx[k] = sqrtf(cplx[2 * k] * cplx[2 * k] + cplx[2 * k + 1] * cplx[2 * k + 1]);
+  }
+  float binHz = rateHz / n;
+  size_t first = (size_t)ceilf(FLICKER_MIN_HZ / binHz);
+  if (first < 1) first = 1;
+  size_t peak = 0;
+  for (size_t k = first; k < n / 2; k++) {
+    if (peak == 0 || cplx[k] > cplx[peak]) peak = k;
+  }
+  if (peak == 0) return;
+  float offset = 0;
+  float a = cplx[peak - 1], b = cplx[peak], c = cplx[peak + 1];
+  float denom = a - 2 * b + c;
+  if (denom != 0) offset = 0.5f * (a - c) / denom;
+  out.dominantHz = (peak + offset) * binHz;
+}
+
+void flickerAnalyzeScalar(const uint16_t* raw, size_t n, float rateHz, float* cplx, const float* window,
+                          FlickerResult& out) {
+  flickerPrepare(raw, n, cplx, out);
+  if (window) {
+    flickerWindowScalar(cplx, window, n);
+  } else {
+    for (size_t i = 0; i < n; i++) cplx[2 * i] *= 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / (float)(n - 1));
+  }
+  flickerFftScalar(cplx, n);
+  flickerFromSpectrum(cplx, n, rateHz, out);
+}
@@ -0,0 +1,111 @@
+#include "flicker_stage.h"
+
+#include <driver/adc.h>
+#include <driver/i2s.h>
+#include <esp_dsp.h>
+#include <esp_timer.h>
+
+#include "event_bus.h"
+#include "histogram.h"
+
+#define FLICKER_I2S I2S_NUM_0
+#define FLICKER_ADC_CHANNEL ADC1_CHANNEL_6   // LDR_AO, GPIO34
+#define FLICKER_SETTLE_SAMPLES 256           // Discarded while the ADC settles
+
+static SemaphoreHandle_t adcLock = nullptr;
+static uint16_t raw[FLICKER_SAMPLES];
+static float cplx[2 * FLICKER_SAMPLES];
+static float window[FLICKER_SAMPLES];
+static float fftTable[FLICKER_SAMPLES];
+static uint32_t runs = 0;
+static uint32_t skipped = 0;
+static Histogram analysisHist("auralink_flicker_analysis_us", "Flicker window + FFT + peak search duration");
+
+// ------------------------------------------------------------------
+// --- Acquisition: one DMA block of LDR_AO ---
+// ------------------------------------------------------------------
+static bool acquire() {
+  i2s_config_t config = {};
+  config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+  config.sample_rate = FLICKER_RATE_HZ;
+  config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+  config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+  config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+  config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+  config.dma_buf_count = 4;
+  config.dma_buf_len = 256;
+  // Fails while a raw capture owns I2S0
+  if (i2s_driver_install(FLICKER_I2S, &config, 0, nullptr) != ESP_OK) return false;
+  adc1_config_width(ADC_WIDTH_BIT_12);
+  adc1_config_channel_atten(FLICKER_ADC_CHANNEL, ADC_ATTEN_DB_11);
+  i2s_set_adc_mode(ADC_UNIT_1, FLICKER_ADC_CHANNEL);
+  i2s_adc_enable(FLICKER_I2S);
+
+  size_t have = 0, settle = FLICKER_SETTLE_SAMPLES;
+  uint16_t words[128];
+  TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(2000 + FLICKER_SAMPLES * 1000 / FLICKER_RATE_HZ);
+  while (have < FLICKER_SAMPLES && (int32_t)(deadline - xTaskGetTickCount()) > 0) {
+    size_t got = 0;
+    i2s_read(FLICKER_I2S, words, sizeof(words), &got, pdMS_TO_TICKS(100));
+    for (size_t i = 0; i < got / sizeof(uint16_t) && have < FLICKER_SAMPLES; i++) {
+      if ((words[i] >> 12) != FLICKER_ADC_CHANNEL) continue;
+      if (settle > 0) {
+        settle--;
+        continue;
+      }
+      raw[have++] = words[i] & 0x0FFF;
+    }
+  }
+  i2s_adc_disable(FLICKER_I2S);
+  i2s_driver_uninstall(FLICKER_I2S);
+  return have == FLICKER_SAMPLES;
+}
+
+// ------------------------------------------------------------------
+// --- Analysis: shared stages from flicker.h, ESP-DSP in the middle ---
+// ------------------------------------------------------------------
+static void analyze(FlickerResult& out) {
+  int64_t start = esp_timer_get_time();
+  flickerPrepare(raw, FLICKER_SAMPLES, cplx, out);
+  dsps_mul_f32(cplx, window, cplx, FLICKER_SAMPLES, 2, 1, 2);   // Real parts only
+  dsps_fft2r_fc32(cplx, FLICKER_SAMPLES);
+  dsps_bit_rev_fc32(cplx, FLICKER_SAMPLES);
+  flickerFromSpectrum(cplx, FLICKER_SAMPLES, FLICKER_RATE_HZ, out);
+  analysisHist.record((uint32_t)(esp_timer_get_time() - start));
+}
+
+static void flickerTask(void*) {
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;) {
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(FLICKER_INTERVAL_MS));
+    if (xSemaphoreTake(adcLock, pdMS_TO_TICKS(FLICKER_LOCK_WAIT_MS)) != pdTRUE) {
+      skipped++;
+      continue;
+    }
+    bool ok = acquire();
+    xSemaphoreGive(adcLock);
+    if (!ok) {
+      skipped++;
+      continue;
+    }
+    Event event;
+    event.type = EVENT_FLICKER;
+    analyze(event.flicker);
+    runs++;
+    eventBusPublish(event);
+  }
+}
+
+// ------------------------------------------------------------------
+// --- Startup ---
+// ------------------------------------------------------------------
+void flickerBegin(SemaphoreHandle_t lock) {
+  adcLock = lock;
+  dsps_fft2r_init_fc32(fftTable, FLICKER_SAMPLES);
+  dsps_wind_hann_f32(window, FLICKER_SAMPLES);
+  metricsRegister(&analysisHist);
+  xTaskCreatePinnedToCore(flickerTask, "flicker", 3072, nullptr, 1, nullptr, 1);
+}
+
+uint32_t flickerRuns() { return runs; }
+uint32_t flickerSkipped() { return skipped; }
@@ -0,0 +1,108 @@
+#include "heartbeat.h"
+
+struct Heartbeat {
+  const char* name;
+  uint32_t timeoutMs;
+  HeartbeatRecovery recover;
+  volatile uint32_t lastBeatMs;
+  volatile uint32_t beats;
+  uint32_t beatsAtRecovery;
+  uint32_t recoveryStartMs;
+  uint32_t stalls;
+  uint32_t recoveries;
+  bool recovering;
+};
+
+static Heartbeat heartbeats[HEARTBEAT_MAX];
+static uint8_t heartbeatCount = 0;
+
+// Survives the reboot the supervisor triggers
+#define REBOOT_CAUSE_MAGIC 0x48424154  // "HBAT"
+RTC_NOINIT_ATTR static uint32_t rebootCauseMagic;
+RTC_NOINIT_ATTR static char rebootCauseName[16];
+static char lastRebootCause[16];
+static bool rebootCauseLoaded = false;
+
+int8_t heartbeatRegister(const char* name, uint32_t timeoutMs, HeartbeatRecovery recover) {
+  if (heartbeatCount >= HEARTBEAT_MAX) return -1;
+  Heartbeat& hb = heartbeats[heartbeatCount];
+  hb.name = name;
+  hb.timeoutMs = timeoutMs;
+  hb.recover = recover;
+  hb.lastBeatMs = millis();
+  hb.beats = 0;
+  hb.stalls = 0;
+  hb.recoveries = 0;
+  hb.recovering = false;
+  return heartbeatCount++;
+}
+
+void heartbeatBeat(int8_t id) {
+  if (id < 0 || id >= heartbeatCount) return;
+  heartbeats[id].lastBeatMs = millis();
+  heartbeats[id].beats = heartbeats[id].beats + 1;
+}
+
+static void rebootFor(const Heartbeat& hb) {
+  Serial.printf("Subsystem '%s' did not recover; rebooting\n", hb.name);
+  snprintf(rebootCauseName, sizeof(rebootCauseName), "%s", hb.name);
+  rebootCauseMagic = REBOOT_CAUSE_MAGIC;
+  Serial.flush();
+  ESP.restart();
+}
+
+void heartbeatSupervise() {
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < heartbeatCount; i++) {
+    Heartbeat& hb = heartbeats[i];
+
+    if (hb.recovering) {
+      if (hb.beats != hb.beatsAtRecovery) {
+        hb.recovering = false;
+        Serial.printf("Subsystem '%s' recovered after %lu ms\n", hb.name,
+                      (unsigned long)(now - hb.recoveryStartMs));
+      } else if (now - hb.recoveryStartMs > hb.timeoutMs) {
+        rebootFor(hb);
+      }
+      continue;
+    }
+
+    if (now - hb.lastBeatMs <= hb.timeoutMs) continue;
+
+    hb.stalls++;
+    Serial.printf("Subsystem '%s' stalled (silent %lu ms)\n", hb.name,
+                  (unsigned long)(now - hb.lastBeatMs));
+    if (!hb.recover) rebootFor(hb);
+    hb.recovering = true;
+    hb.recoveries++;
+    hb.beatsAtRecovery = hb.beats;
+    hb.recoveryStartMs = now;
+    hb.recover();
+  }
+}
+
+size_t heartbeatFormatJson(char* buf, size_t len) {
+  uint32_t now = millis();
+  int n = snprintf(buf, len, "{");
+  for (uint8_t i = 0; i < heartbeatCount && n > 0 && n < (int)len; i++) {
+    const Heartbeat& hb = heartbeats[i];
+    n += snprintf(buf + n, len - n, "%s\"%s\":{\"stalls\":%lu,\"recoveries\":%lu,\"silent_ms\":%lu}",
+                  i ? "," : "", hb.name, (unsigned long)hb.stalls, (unsigned long)hb.recoveries,
+                  (unsigned long)(now - hb.lastBeatMs));
+  }
+  if (n > 0 && n < (int)len) n += snprintf(buf + n, len - n, "}");
+  return (n > 0 && n < (int)len) ? n : 0;
+}
+
+const char* heartbeatLastRebootCause() {
+  if (!rebootCauseLoaded) {
+    // Read once, then clear so a later unrelated reset is not misattributed
+    rebootCauseLoaded = true;
+    if (rebootCauseMagic == REBOOT_CAUSE_MAGIC) {
+      memcpy(lastRebootCause, rebootCauseName, sizeof(lastRebootCause));
+      lastRebootCause[sizeof(lastRebootCause) - 1] = '\0';
+    }
+    rebootCauseMagic = 0;
+  }
+  return lastRebootCause[0] ? lastRebootCause : nullptr;
+}
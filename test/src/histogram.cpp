@@ -0,0 +1,105 @@
+#include "histogram.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static Histogram* registry[METRICS_MAX_HISTOGRAMS];
+static uint8_t registryCount = 0;
+
+void Histogram::record(uint32_t value) {
+  uint8_t i = 0;
+  while (i < HISTOGRAM_BUCKETS - 1 && value > bucketBound(i)) i++;
+  buckets_[i].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_ += value;
+  if (value > max_) max_ = value;
+}
+
+void Histogram::reset() {
+  for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+  count_.store(0, std::memory_order_relaxed);
+  sum_ = 0;
+  max_ = 0;
+}
+
+uint32_t Histogram::bucketBound(uint8_t i) {
+  return i >= HISTOGRAM_BUCKETS - 1 ? UINT32_MAX : (1UL << i);
+}
+
+uint32_t Histogram::percentile(float p) const {
+  uint32_t total = count();
+  if (total == 0) return 0;
+  uint32_t rank = (uint32_t)(p / 100.0f * total + 0.5f);
+  if (rank == 0) rank = 1;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    seen += bucket(i);
+    if (seen >= rank) return i == HISTOGRAM_BUCKETS - 1 ? max_ : bucketBound(i);
+  }
+  return max_;
+}
+
+bool metricsRegister(Histogram* h) {
+  if (registryCount >= METRICS_MAX_HISTOGRAMS) {
+    printf("metrics registry full (%d); %s not exported\n", METRICS_MAX_HISTOGRAMS, h->name());
+    return false;
+  }
+  registry[registryCount++] = h;
+  return true;
+}
+
+uint8_t metricsCount() { return registryCount; }
+
+Histogram* metricsAt(uint8_t i) { return i < registryCount ? registry[i] : nullptr; }
+
+Histogram* metricsFind(const char* name) {
+  for (uint8_t i = 0; i < registryCount; i++) {
+    if (strcmp(registry[i]->name(), name) == 0) return registry[i];
+  }
+  return nullptr;
+}
+
+// ------------------------------------------------------------------
+// --- Renderers (only non-empty buckets are listed in JSON) ---
+// ------------------------------------------------------------------
+#define APPEND(...)                                         \
+  do {                                                      \
+    int w = snprintf(buf + n, len - n, __VA_ARGS__);        \
+    if (w < 0 || (size_t)w >= len - n) return 0;            \
+    n += w;                                                 \
+  } while (0)
+
+size_t histogramToJson(const Histogram& h, char* buf, size_t len) {
+  size_t n = 0;
+  APPEND("{\"name\":\"%s\",\"count\":%lu,\"sum\":%llu,\"max\":%lu,\"p50\":%lu,\"p99\":%lu,\"buckets\":{",
+         h.name(), (unsigned long)h.count(), (unsigned long long)h.sum(), (unsigned long)h.max(),
+         (unsigned long)h.percentile(50), (unsigned long)h.percentile(99));
+  bool first = true;
+  for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    uint32_t c = h.bucket(i);
+    if (!c) continue;
+    if (i == HISTOGRAM_BUCKETS - 1) {
+      APPEND("%s\"+Inf\":%lu", first ? "" : ",", (unsigned long)c);
+    } else {
+      APPEND("%s\"%lu\":%lu", first ? "" : ",", (unsigned long)Histogram::bucketBound(i), (unsigned long)c);
+    }
+    first = false;
+  }
+  APPEND("}}");
+  return n;
+}
+
+size_t histogramToPrometheus(const Histogram& h, char* buf, size_t len) {
+  size_t n = 0;
+  APPEND("# HELP %s %s\n# TYPE %s histogram\n", h.name(), h.help(), h.name());
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < HISTOGRAM_BUCKETS - 1; i++) {
+    cumulative += h.bucket(i);
+    APPEND("%s_bucket{le=\"%lu\"} %lu\n", h.name(), (unsigned long)Histogram::bucketBound(i),
+           (unsigned long)cumulative);
+  }
+  APPEND("%s_bucket{le=\"+Inf\"} %lu\n%s_sum %llu\n%s_count %lu\n", h.name(),
+         (unsigned long)h.count(), h.name(), (unsigned long long)h.sum(), h.name(),
+         (unsigned long)h.count());
+  return n;
+}
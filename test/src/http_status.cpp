@@ -0,0 +1,155 @@
+#include "http_status.h"
+
+#include <esp_http_server.h>
+#include <esp_timer.h>
+
+#include "histogram.h"
+
+static httpd_handle_t server = nullptr;
+static HttpStatusProviders providers;
+static uint32_t budgetOverruns = 0;
+static Histogram handlerHist("auralink_http_handler_us", "HTTP status handler duration");
+
+// The server task runs handlers one at a time, so a single buffer serves
+// every request.
+static char chunk[HTTP_CHUNK_BYTES];
+
+// ------------------------------------------------------------------
+// --- Helpers ---
+// ------------------------------------------------------------------
+static esp_err_t sendRendered(httpd_req_t* req, const char* type, HttpStatusRenderer render) {
+  int64_t start = esp_timer_get_time();
+  size_t len = render ? render(chunk, sizeof(chunk)) : 0;
+  esp_err_t rc;
+  if (len == 0) {
+    rc = httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "render failed");
+  } else {
+    httpd_resp_set_type(req, type);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    rc = httpd_resp_send(req, chunk, len);
+  }
+  uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+  if (elapsed > HTTP_LATENCY_BUDGET_US) budgetOverruns++;  // Already sent whole; counted only
+  handlerHist.record(elapsed);
+  return rc;
+}
+
+// Streams every registered histogram, one chunk each, until the budget
+// runs out. A truncated response still ends cleanly.
+static esp_err_t streamHistograms(httpd_req_t* req, bool prometheus, int64_t start) {
+  bool first = true;  // Nothing sent yet; skipped histograms must not leave a stray ','
+  for (uint8_t i = 0; i < metricsCount(); i++) {
+    if (esp_timer_get_time() - start > HTTP_LATENCY_BUDGET_US) {
+      budgetOverruns++;
+      break;
+    }
+    const Histogram& h = *metricsAt(i);
+    size_t n = 0;
+    if (!prometheus && !first) chunk[n++] = ',';
+    size_t w = prometheus ? histogramToPrometheus(h, chunk + n, sizeof(chunk) - n)
+                          : histogramToJson(h, chunk + n, sizeof(chunk) - n);
+    if (w == 0) continue;  // Too large for one chunk; skip rather than corrupt
+    if (httpd_resp_send_chunk(req, chunk, n + w) != ESP_OK) return ESP_FAIL;
+    first = false;
+  }
+  return ESP_OK;
+}
+
+// ------------------------------------------------------------------
+// --- URI handlers ---
+// ------------------------------------------------------------------
+static esp_err_t handleReadings(httpd_req_t* req) {
+  return sendRendered(req, "application/json", providers.readingsJson);
+}
+
+static esp_err_t handleHealth(httpd_req_t* req) {
+  return sendRendered(req, "application/json", providers.healthJson);
+}
+
+static esp_err_t handleHistograms(httpd_req_t* req) {
+  int64_t start = esp_timer_get_time();
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  esp_err_t rc = httpd_resp_send_chunk(req, "[", 1);
+  if (rc == ESP_OK) rc = streamHistograms(req, false, start);
+  if (rc == ESP_OK) rc = httpd_resp_send_chunk(req, "]", 1);
+  if (rc == ESP_OK) rc = httpd_resp_send_chunk(req, nullptr, 0);
+  handlerHist.record((uint32_t)(esp_timer_get_time() - start));
+  return rc;
+}
+
+static esp_err_t handleMetrics(httpd_req_t* req) {
+  int64_t start = esp_timer_get_time();
+  httpd_resp_set_type(req, "text/plain; version=0.0.4");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  esp_err_t rc = ESP_OK;
+  size_t len = providers.metricsText ? providers.metricsText(chunk, sizeof(chunk)) : 0;
+  if (len > 0) rc = httpd_resp_send_chunk(req, chunk, len);
+  if (rc == ESP_OK) {
+    len = snprintf(chunk, sizeof(chunk),
+                   "# TYPE auralink_http_budget_overruns_total counter\n"
+                   "auralink_http_budget_overruns_total %lu\n",
+                   (unsigned long)budgetOverruns);
+    rc = httpd_resp_send_chunk(req, chunk, len);
+  }
+  if (rc == ESP_OK) rc = streamHistograms(req, true, start);
+  if (rc == ESP_OK) rc = httpd_resp_send_chunk(req, nullptr, 0);
+  handlerHist.record((uint32_t)(esp_timer_get_time() - start));
+  return rc;
+}
+
+// Not recorded in handlerHist: the download is paced by the client, and
+// its seconds-long transfers would swamp the render timings.
+static esp_err_t handleCapture(httpd_req_t* req) {
+  uint32_t offset = 0;
+  size_t len = providers.captureFile ? providers.captureFile(offset, chunk, sizeof(chunk)) : 0;
+  if (len == 0) return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "no capture");
+  httpd_resp_set_type(req, "application/octet-stream");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  esp_err_t rc = ESP_OK;
+  while (len > 0 && rc == ESP_OK) {
+    rc = httpd_resp_send_chunk(req, chunk, len);
+    offset += len;
+    len = providers.captureFile(offset, chunk, sizeof(chunk));
+  }
+  if (rc == ESP_OK) rc = httpd_resp_send_chunk(req, nullptr, 0);
+  return rc;
+}
+
+// ------------------------------------------------------------------
+// --- Startup ---
+// ------------------------------------------------------------------
+bool httpStatusBegin(const HttpStatusProviders& p) {
+  providers = p;
+  metricsRegister(&handlerHist);
+
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = HTTP_STATUS_PORT;
+  config.max_open_sockets = HTTP_MAX_CLIENTS;
+  config.backlog_conn = 1;
+  config.lru_purge_enable = true;   // New clients evict idle ones instead of queueing
+  config.recv_wait_timeout = 2;     // Seconds; a slow client cannot pin the server
+  config.send_wait_timeout = 2;
+  config.task_priority = 1;         // Below loopTask, and on the other core
+  config.core_id = 0;
+  config.stack_size = 4096;
+  config.max_uri_handlers = 5;
+
+  if (httpd_start(&server, &config) != ESP_OK) {
+    Serial.println("HTTP status server failed to start");
+    return false;
+  }
+
+  static const httpd_uri_t uris[] = {
+    {"/readings", HTTP_GET, handleReadings, nullptr},
+    {"/health", HTTP_GET, handleHealth, nullptr},
+    {"/histograms", HTTP_GET, handleHistograms, nullptr},
+    {"/metrics", HTTP_GET, handleMetrics, nullptr},
+    {"/capture", HTTP_GET, handleCapture, nullptr},
+  };
+  for (const httpd_uri_t& uri : uris) httpd_register_uri_handler(server, &uri);
+  Serial.printf("HTTP status server on port %d\n", HTTP_STATUS_PORT);
+  return true;
+}
+
+uint32_t httpStatusBudgetOverruns() { return budgetOverruns; }
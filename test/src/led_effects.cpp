@@ -0,0 +1,232 @@
+#include "led_effects.h"
+
+#include <driver/ledc.h>
+#include <esp_timer.h>
+
+#define LED_CARRIER_HZ 5000
+#define LED_CARRIER_BITS LEDC_TIMER_10_BIT
+#define LED_CARRIER_MAX ((1 << 10) - 1)
+// Blink waves run the timer itself at the blink rate, clocked from
+// REF_TICK through the 10.8 fixed-point divider (see startBlinkWave)
+#define LED_REF_TICK_HZ 1000000
+#define LED_BLINK_BITS 14          // Preferred duty resolution
+#define LED_DIV_FRAC_BITS 8
+#define LED_DIV_MIN (1UL << LED_DIV_FRAC_BITS)   // Divide by 1.0
+#define LED_DIV_MAX 0x3FFFFUL                    // Divide by ~1024
+#define LED_FX_QUEUE_LEN 16
+#define LED_FX_TASK_STACK 2048
+#define LED_FX_TASK_PRIORITY 2
+
+struct LedSlot {
+  ledc_mode_t mode;
+  ledc_channel_t channel;
+  ledc_timer_t timer;
+  esp_timer_handle_t trainTimer;
+  LedEffect effect;
+  uint32_t wavePeriodUs;  // Blink period actually programmed
+  bool fadingUp;      // BREATHE direction
+  bool trainOn;       // PULSE_TRAIN phase
+};
+
+// Events handed to the helper task. Fades end in ISR context and train
+// gates fire on the esp_timer task; neither may touch LEDC fade state
+// directly, so both just post the LED index here.
+struct LedFxEvent {
+  uint8_t index;
+  uint8_t kind;
+};
+
+static LedSlot slots[LED_EFFECTS_MAX];
+static uint8_t slotCount = 0;
+static QueueHandle_t fxQueue = nullptr;
+static SemaphoreHandle_t fxLock = nullptr;
+
+// ------------------------------------------------------------------
+// --- Helpers: timer and duty configuration ---
+// ------------------------------------------------------------------
+static void configureTimer(LedSlot& s, uint32_t freqHz, ledc_timer_bit_t bits, ledc_clk_cfg_t clk) {
+  ledc_timer_config_t cfg = {};
+  cfg.speed_mode = s.mode;
+  cfg.duty_resolution = bits;
+  cfg.timer_num = s.timer;
+  cfg.freq_hz = freqHz;
+  cfg.clk_cfg = clk;
+  ledc_timer_config(&cfg);
+}
+
+static void setDuty(LedSlot& s, uint32_t duty) {
+  ledc_set_duty(s.mode, s.channel, duty);
+  ledc_update_duty(s.mode, s.channel);
+}
+
+static uint32_t scaleBrightness(uint8_t b) { return (uint32_t)b * LED_CARRIER_MAX / 255; }
+
+// Programs the divider directly rather than through a whole-Hz freq_hz,
+// so any period from a few ms to 65 s comes out exact to 1/256 of a
+// REF_TICK count. The duty resolution is widened for slow waves (14 bits
+// reach ~16.8 s) and narrowed for fast ones, keeping the divider in range.
+// Returns the period actually programmed, which times PULSE_TRAIN gates.
+static uint32_t startBlinkWave(LedSlot& s, uint16_t periodMs) {
+  if (periodMs == 0) periodMs = 1;
+  // divider * 2^bits, in 1/256 ticks
+  uint64_t scaled = ((uint64_t)LED_REF_TICK_HZ / 1000 * periodMs) << LED_DIV_FRAC_BITS;
+  uint32_t bits = LED_BLINK_BITS;
+  while ((scaled >> bits) > LED_DIV_MAX && bits < LEDC_TIMER_20_BIT) bits++;
+  while ((scaled >> bits) < LED_DIV_MIN && bits > LEDC_TIMER_1_BIT) bits--;
+  uint32_t div = (uint32_t)((scaled + (1ULL << (bits - 1))) >> bits);
+  if (div < LED_DIV_MIN) div = LED_DIV_MIN;
+  if (div > LED_DIV_MAX) div = LED_DIV_MAX;
+
+  ledc_timer_set(s.mode, s.timer, div, bits, LEDC_REF_TICK);
+  ledc_timer_rst(s.mode, s.timer);   // Start each wave on a rising edge
+  setDuty(s, 1UL << (bits - 1));     // 50 %
+  s.wavePeriodUs = (uint32_t)(((uint64_t)div << bits) * (1000000 / LED_REF_TICK_HZ) >> LED_DIV_FRAC_BITS);
+  return s.wavePeriodUs;
+}
+
+static void startFade(LedSlot& s) {
+  uint32_t target = s.fadingUp ? scaleBrightness(s.effect.brightness) : 0;
+  uint16_t half = s.effect.periodMs / 2;
+  ledc_set_fade_with_time(s.mode, s.channel, target, half ? half : 1);
+  ledc_fade_start(s.mode, s.channel, LEDC_FADE_NO_WAIT);
+}
+
+// ------------------------------------------------------------------
+// --- Event sources (ISR / esp_timer context) ---
+// ------------------------------------------------------------------
+static bool IRAM_ATTR onFadeEnd(const ledc_cb_param_t* param, void* arg) {
+  BaseType_t woken = pdFALSE;
+  if (param->event == LEDC_FADE_END_EVT) {
+    LedFxEvent ev = {(uint8_t)(uintptr_t)arg, LED_EFFECT_BREATHE};
+    xQueueSendFromISR(fxQueue, &ev, &woken);
+  }
+  return woken == pdTRUE;
+}
+
+static void onTrainGate(void* arg) {
+  LedFxEvent ev = {(uint8_t)(uintptr_t)arg, LED_EFFECT_PULSE_TRAIN};
+  xQueueSend(fxQueue, &ev, 0);
+}
+
+// ------------------------------------------------------------------
+// --- Helper task: the only CPU work between state changes ---
+// ------------------------------------------------------------------
+static void fxTask(void*) {
+  LedFxEvent ev;
+  for (;;) {
+    if (xQueueReceive(fxQueue, &ev, portMAX_DELAY) != pdTRUE) continue;
+    xSemaphoreTake(fxLock, portMAX_DELAY);
+    LedSlot& s = slots[ev.index];
+    // Drop stale events from an effect that has since been replaced
+    if (s.effect.kind == ev.kind) {
+      if (ev.kind == LED_EFFECT_BREATHE) {
+        s.fadingUp = !s.fadingUp;
+        startFade(s);
+      } else {
+        s.trainOn = !s.trainOn;
+        if (s.trainOn) {
+          // Gate on the programmed period so the train holds whole pulses
+          uint32_t periodUs = startBlinkWave(s, s.effect.periodMs);
+          esp_timer_start_once(s.trainTimer, (uint64_t)periodUs * s.effect.pulses);
+        } else {
+          setDuty(s, 0);
+          esp_timer_start_once(s.trainTimer, (uint64_t)s.effect.gapMs * 1000);
+        }
+      }
+    }
+    xSemaphoreGive(fxLock);
+  }
+}
+
+// ------------------------------------------------------------------
+// --- Public API ---
+// ------------------------------------------------------------------
+void ledEffectsBegin(const uint8_t* pins, uint8_t count) {
+  slotCount = count > LED_EFFECTS_MAX ? LED_EFFECTS_MAX : count;
+  fxQueue = xQueueCreate(LED_FX_QUEUE_LEN, sizeof(LedFxEvent));
+  fxLock = xSemaphoreCreateMutex();
+  ledc_fade_func_install(0);
+
+  for (uint8_t i = 0; i < slotCount; i++) {
+    LedSlot& s = slots[i];
+    // One timer per LED so each can run its own blink rate: high-speed
+    // group first, then low-speed.
+    s.mode = i < 4 ? LEDC_HIGH_SPEED_MODE : LEDC_LOW_SPEED_MODE;
+    s.timer = (ledc_timer_t)(i % 4);
+    s.channel = (ledc_channel_t)(i % 4);
+    s.effect = ledOff();
+    s.wavePeriodUs = 0;
+    s.fadingUp = false;
+    s.trainOn = false;
+    configureTimer(s, LED_CARRIER_HZ, LED_CARRIER_BITS, LEDC_AUTO_CLK);
+
+    ledc_channel_config_t ch = {};
+    ch.gpio_num = pins[i];
+    ch.speed_mode = s.mode;
+    ch.channel = s.channel;
+    ch.intr_type = LEDC_INTR_DISABLE;
+    ch.timer_sel = s.timer;
+    ch.duty = 0;
+    ch.hpoint = 0;
+    ledc_channel_config(&ch);
+
+    ledc_cbs_t cbs = {};
+    cbs.fade_cb = onFadeEnd;
+    ledc_cb_register(s.mode, s.channel, &cbs, (void*)(uintptr_t)i);
+
+    esp_timer_create_args_t targs = {};
+    targs.callback = onTrainGate;
+    targs.arg = (void*)(uintptr_t)i;
+    targs.name = "ledTrain";
+    esp_timer_create(&targs, &s.trainTimer);
+  }
+
+  xTaskCreatePinnedToCore(fxTask, "ledFx", LED_FX_TASK_STACK, nullptr,
+                          LED_FX_TASK_PRIORITY, nullptr, 0);
+}
+
+void ledEffectSet(uint8_t index, const LedEffect& effect) {
+  if (index >= slotCount) return;
+  xSemaphoreTake(fxLock, portMAX_DELAY);
+  LedSlot& s = slots[index];
+  if (s.effect == effect) {
+    xSemaphoreGive(fxLock);
+    return;
+  }
+
+  // Tear down whatever the previous effect left running
+  esp_timer_stop(s.trainTimer);
+  if (s.effect.kind == LED_EFFECT_BREATHE) ledc_fade_stop(s.mode, s.channel);
+  bool wasSquareWave = s.effect.kind == LED_EFFECT_BLINK || s.effect.kind == LED_EFFECT_PULSE_TRAIN;
+  s.effect = effect;
+
+  switch (effect.kind) {
+    case LED_EFFECT_SOLID:
+    case LED_EFFECT_OFF:
+      if (wasSquareWave) configureTimer(s, LED_CARRIER_HZ, LED_CARRIER_BITS, LEDC_AUTO_CLK);
+      setDuty(s, effect.kind == LED_EFFECT_SOLID ? scaleBrightness(effect.brightness) : 0);
+      break;
+    case LED_EFFECT_BLINK:
+      startBlinkWave(s, effect.periodMs);
+      break;
+    case LED_EFFECT_BREATHE:
+      if (wasSquareWave) configureTimer(s, LED_CARRIER_HZ, LED_CARRIER_BITS, LEDC_AUTO_CLK);
+      setDuty(s, 0);
+      s.fadingUp = true;
+      startFade(s);
+      break;
+    case LED_EFFECT_PULSE_TRAIN:
+      s.trainOn = true;
+      esp_timer_start_once(s.trainTimer, (uint64_t)startBlinkWave(s, effect.periodMs) * effect.pulses);
+      break;
+  }
+  xSemaphoreGive(fxLock);
+}
+
+LedEffect ledEffectGet(uint8_t index) {
+  if (index >= slotCount) return ledOff();
+  xSemaphoreTake(fxLock, portMAX_DELAY);
+  LedEffect e = slots[index].effect;
+  xSemaphoreGive(fxLock);
+  return e;
+}
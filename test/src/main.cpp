@@ -4,18 +4,109 @@
 #include <LiquidCrystal_I2C.h>
 #include <DHT.h>
 
+#include <Preferences.h>
+#include <esp_task_wdt.h>
+#include <atomic>
+
+#ifdef AURALINK_CAPTURE
+#include "adc_capture.h"
+#endif
+#include "boot_profile.h"
+#include "broker_pool.h"
+#include "default_rules.h"
+#include "downlink_router.h"
+#include "event_bus.h"
+#ifdef AURALINK_FLICKER
+#include "flicker_stage.h"
+#endif
+#include "heartbeat.h"
+#include "histogram.h"
+#include "http_status.h"
+#include "led_effects.h"
+#include "mdns_discovery.h"
+#include "outbound_queue.h"
+#ifdef AURALINK_QEMU
+#include "qemu_net.h"
+#endif
+#include "readings.h"
+#include "payload.h"
+#include "rules.h"
+#include "text_store.h"
+#ifdef AURALINK_REPLAY
+#include "trace_partition.h"
+#endif
+#include "uplink_topics.h"
+#include "warm_state.h"
+#include "wire.h"
+#include "sample_buffer.h"
+#include "sample_clock.h"
+#include "serial_shell.h"
+#include "series_codec.h"
+#ifdef AURALINK_MQTT_TLS
+#include "tls_client.h"
+#endif
+
 // --- Wi-Fi and MQTT Configuration ---
 const char* ssid = "Nyiwg 9A"; // Your Wi-Fi Name
 const char* password = "aaaaa11111"; // Your Wi-Fi Password
-const char* mqttServer = "test.mosquitto.org"; // MQTT Broker Host
-const int mqttPort = 1883;
 const char* mqttClientId = "ESP32Client-AuraLink-V1"; // Unique ID for the client
+const char* mqttProbeClientId = "ESP32Client-AuraLink-V1-probe"; // Used by the health probes
+
+// MQTT brokers in order of preference: index 0 is the primary, the rest are
+// failover targets. The device fails back to the primary once it is healthy.
+#ifdef AURALINK_MQTT_TLS
+// TLS build: local mosquitto from test/broker, signed by the embedded CA
+extern const char mqttCaPem[] asm("_binary_broker_certs_ca_crt_start");
+const BrokerEndpoint mqttBrokers[] = {
+  {AURALINK_TLS_BROKER_HOST, 8883, true},
+};
+#elif defined(AURALINK_QEMU)
+// QEMU build: the host's mosquitto through QEMU user networking
+#ifndef AURALINK_QEMU_BROKER_HOST
+#define AURALINK_QEMU_BROKER_HOST "10.0.2.2"
+#endif
+#ifndef AURALINK_QEMU_BROKER_PORT
+#define AURALINK_QEMU_BROKER_PORT 1883
+#endif
+const BrokerEndpoint mqttBrokers[] = {
+  {AURALINK_QEMU_BROKER_HOST, AURALINK_QEMU_BROKER_PORT},
+};
+#else
+const BrokerEndpoint mqttBrokers[] = {
+  {"test.mosquitto.org", 1883},
+  {"broker.hivemq.com", 1883},
+  {"broker.emqx.io", 1883},
+};
+#endif
+const uint8_t mqttBrokerCount = sizeof(mqttBrokers) / sizeof(mqttBrokers[0]);
+
+// Brokers actually used: a broker discovered over mDNS goes first, then
+// the configured list above as the fallback.
+#ifdef AURALINK_MQTT_TLS
+#define MDNS_MQTT_SERVICE "secure-mqtt"
+#else
+#define MDNS_MQTT_SERVICE "mqtt"
+#endif
+BrokerEndpoint brokerList[BROKER_POOL_MAX];
+uint8_t brokerCount = 0;
+DiscoveredBroker localBroker;
+bool haveLocalBroker = false;
+char localBrokerTlsName[48];
 
 // --- MQTT TOPICS (Must match Python backend) ---
-#define TOPIC_SENSOR_DATA "auralink/sensor/data"
-#define TOPIC_DISPLAY_QUOTE "auralink/display/quote"
-#define TOPIC_DISPLAY_SUMMARY "auralink/display/summary"
-#define TOPIC_URGENCY_LED "auralink/urgency/led"
+// Uplink topics are in uplink_topics.h, shared with the fleet generator;
+// downlink topics are defined with their dispatcher in downlink_router.h
+
+// Samples go out as protobuf; -D AURALINK_UPLINK_JSON keeps the legacy
+// JSON uplink for backends that predate the schema. Downlinks are
+// accepted in both forms either way.
+#ifdef AURALINK_UPLINK_JSON
+#define TOPIC_SAMPLE_UPLINK TOPIC_SENSOR_DATA
+#define SAMPLE_UPLINK_MAX SENSOR_PAYLOAD_MAX
+#else
+#define TOPIC_SAMPLE_UPLINK TOPIC_UPLINK
+#define SAMPLE_UPLINK_MAX WIRE_UPLINK_MAX
+#endif
 
 // --- Hardware Definitions ---
 #define DHTPIN 4
@@ -39,18 +130,235 @@ DHT dht(DHTPIN, DHTTYPE);
 
 // --- Communication Objects ---
 WiFiClient espClient;
+#ifdef AURALINK_MQTT_TLS
+TlsSessionClient tlsClient(espClient);
+PubSubClient client(tlsClient);
+#else
 PubSubClient client(espClient);
+#endif
+// PubSubClient packet buffer (its 256-byte default is too small for the
+// health record). Override with -D MQTT_BUFFER_SIZE=...; every payload
+// below is checked against it at compile time.
+#ifndef MQTT_BUFFER_SIZE
+#define MQTT_BUFFER_SIZE 2048
+#endif
+
+// --- Outbound Queue: every publish goes through it (outbound_queue.h) ---
+#define OUTBOUND_SENDS_PER_LOOP 8
+#define TRIGGER_PAYLOAD_MAX 128
+#define RULES_STATUS_MAX 96
+#define RECOVERY_PAYLOAD_MAX 192
+#define CAPTURE_STATUS_MAX 96
+#define FLICKER_PAYLOAD_MAX 128
+#define BATCH_PAYLOAD_MAX 512
+#define HEALTH_PAYLOAD_MAX (MQTT_BUFFER_SIZE - mqttPublishPacketSize(MQTT_TOPIC_LEN(TOPIC_DEVICE_HEALTH), 0))
+static_assert(mqttPublishPacketSize(MQTT_TOPIC_LEN(TOPIC_SENSOR_DATA), SENSOR_PAYLOAD_MAX) <= MQTT_BUFFER_SIZE,
+              "Sensor payload does not fit MQTT_BUFFER_SIZE");
+static_assert(mqttPublishPacketSize(MQTT_TOPIC_LEN(TOPIC_UPLINK), WIRE_UPLINK_MAX) <= MQTT_BUFFER_SIZE,
+              "Protobuf uplink does not fit MQTT_BUFFER_SIZE");
+static_assert(mqttPublishPacketSize(MQTT_TOPIC_LEN(TOPIC_DEVICE_EVENT), TRIGGER_PAYLOAD_MAX) <= MQTT_BUFFER_SIZE,
+              "Trigger payload does not fit MQTT_BUFFER_SIZE");
+static_assert(mqttPublishPacketSize(MQTT_TOPIC_LEN(TOPIC_RULES_STATUS), RULES_STATUS_MAX) <= MQTT_BUFFER_SIZE,
+              "Rules status does not fit MQTT_BUFFER_SIZE");
+static_assert(mqttPublishPacketSize(MQTT_TOPIC_LEN(TOPIC_DEVICE_RECOVERY), RECOVERY_PAYLOAD_MAX) <= MQTT_BUFFER_SIZE,
+              "Recovery record does not fit MQTT_BUFFER_SIZE");
+static_assert(mqttPublishPacketSize(MQTT_TOPIC_LEN(TOPIC_CAPTURE_STATUS), CAPTURE_STATUS_MAX) <= MQTT_BUFFER_SIZE,
+              "Capture status does not fit MQTT_BUFFER_SIZE");
+static_assert(mqttPublishPacketSize(MQTT_TOPIC_LEN(TOPIC_SENSOR_BATCH), BATCH_PAYLOAD_MAX) <= MQTT_BUFFER_SIZE,
+              "Sample batch does not fit MQTT_BUFFER_SIZE");
+static_assert(mqttPublishPacketSize(MQTT_TOPIC_LEN(TOPIC_SENSOR_FLICKER), FLICKER_PAYLOAD_MAX) <= MQTT_BUFFER_SIZE,
+              "Flicker payload does not fit MQTT_BUFFER_SIZE");
+static_assert(HEALTH_PAYLOAD_MAX >= 512, "MQTT_BUFFER_SIZE too small for the health record");
+static_assert(HEALTH_PAYLOAD_MAX <= OUTBOUND_ARENA_BYTES, "Health record cannot fit the outbound arena");
+static_assert(HEALTH_PAYLOAD_MAX <= HTTP_CHUNK_BYTES, "Health record cannot fit the HTTP render buffer");
+OutboundQueue outbound(MQTT_BUFFER_SIZE);
+
+// --- Broker Failover State ---
+const unsigned long mqttRetryIntervalMs = 2000;   // Min spacing between connect attempts
+const unsigned long failbackHoldMs = 30000;       // Stay on a failover broker at least this long
+std::atomic<int8_t> activeBroker(-1);              // Index into brokerList, -1 when offline
+unsigned long lastMqttAttemptMs = 0;
+unsigned long activeSinceMs = 0;
+unsigned long lastHealthMs = 0;
+
+// --- Broker View: what the HTTP server and the shell may read ---
+// brokerList, localBroker and activeBroker belong to the network task,
+// which rebuilds them at will; other tasks read this copy instead.
+#define BROKER_VIEW_HOST_MAX 64
+struct BrokerView {
+  uint8_t count;
+  int8_t active;
+  char hosts[BROKER_POOL_MAX][BROKER_VIEW_HOST_MAX];
+  bool haveLocal;
+  char localName[sizeof(DiscoveredBroker::name)];
+  uint32_t localRttMs;
+};
+BrokerView brokerView = {0, -1};
+portMUX_TYPE brokerViewMux = portMUX_INITIALIZER_UNLOCKED;
+bool healthDue = false;                            // Publish health on the next pass
+uint32_t brokerFailovers = 0;
+
+// --- Offline Sample Buffer: drained to whichever broker is active ---
+#define SAMPLE_BUFFER_CAPACITY 64
+#define SAMPLES_QUEUED_MAX 8   // Samples allowed in the outbound queue at once
+#define BATCH_MIN_SAMPLES 4    // A backlog this deep drains as compressed batches
+SampleBuffer<SAMPLE_BUFFER_CAPACITY> sampleBuffer;
+
+// Batch compression results, against the single-sample uplinks this
+// build would have sent instead (see replay --batch for the JSON ratio)
+struct BatchStats {
+  uint32_t batches;
+  uint32_t samples;
+  uint32_t bytes;
+  uint32_t singleBytes;
+  uint32_t encodeUs;
+  uint32_t encodeMaxUs;
+};
+BatchStats batchStats = {};
+uint32_t downlinksDecoded = 0;     // Protobuf downlinks, network task only
+uint32_t downlinksRejected = 0;
+uint32_t sampleSeq = 0;
+
+// --- Tasks and Supervision ---
+// Tasks talk only through the event bus (event_bus.h):
+// sensor:  samples on each SAMPLE_INTERVAL_MS tick of the hardware
+//          sampling clock (sample_clock.h), runs the rules; publishes
+//          samples, rule triggers and LED changes
+// network: owns the MQTT client, the offline buffer and all publishing;
+//          subscribes to samples/triggers, publishes downlink as events
+// display: owns the LCD; subscribes to display events
+// leds:    owns the LED effect engine; subscribes to LED events
+// loop() is the supervisor: it checks heartbeats and runs recoveries.
+// Heartbeat timeouts sit well inside the task watchdog timeout, so a
+// targeted subsystem restart is always tried before a reboot.
+#define SAMPLE_INTERVAL_MS 3000      // Default; `config set sample_ms` overrides it
+#define NETWORK_POLL_MS 20
+#define SUPERVISOR_INTERVAL_MS 1000
+#define WDT_TIMEOUT_S 30
+#define SENSOR_STALL_MS 10000
+#define NETWORK_STALL_MS 20000       // Covers a TCP connect plus a full TLS handshake
+#define DISPLAY_STALL_MS 5000
+#define LEDS_STALL_MS 5000
+#define DISPLAY_PAGE_MS 2500         // Default; `config set page_ms` overrides it
+#define I2C_TIMEOUT_MS 100
+
+// --- Boot: WiFi associates, the LCD initialises and the DHT warms up
+// concurrently; nothing in setup() waits on any of them (boot_profile.h)
+#define DHT_WARMUP_MS 1500           // DHT22 needs ~1 s after power-up for a valid read
+#define WIFI_BOOT_TIMEOUT_MS 20000   // No IP by then: show the error and restart
+#define WIFI_FAIL_NOTICE_MS 5000
+
+// --- Replay builds (-D AURALINK_REPLAY): sensors come from a recorded trace
+// in flash instead of the hardware (trace.h); -D AURALINK_TRACE_RECORD
+// prints the TRACE lines such traces are made from.
+#ifndef AURALINK_REPLAY_SPEED
+#define AURALINK_REPLAY_SPEED 1   // Playback speed multiplier; 0 = unpaced
+#endif
+
+// --- Runtime Settings: `config get/set` on the serial shell, kept in NVS.
+// Each is a single aligned word written by the loop task only, so
+// readers on other tasks never see a torn value.
+#define HEALTH_INTERVAL_MS 30000
+struct Setting {
+  const char* name;
+  const char* nvsKey;
+  uint32_t* value;
+  uint32_t min;
+  uint32_t max;
+  void (*apply)(uint32_t value);   // Optional: push the new value to its owner
+};
+uint32_t sampleIntervalMs = SAMPLE_INTERVAL_MS;
+uint32_t healthIntervalMs = HEALTH_INTERVAL_MS;
+uint32_t displayPageMs = DISPLAY_PAGE_MS;
+#ifdef AURALINK_REPLAY
+uint32_t replaySpeed = AURALINK_REPLAY_SPEED;   // `replay speed N`; applies from the next record
+uint32_t replayPlayed = 0;
+uint32_t replayTotal = 0;
+#endif
+
+// --- Serial Shell: polled from loop() (serial_shell.h)
+#define SHELL_POLL_MS 20
+#define SHELL_RX_BUDGET 64   // Bytes taken from the UART per poll
+
+bool networkOnline = false;          // Broker list built and probes running
+
+TaskHandle_t sensorTaskHandle = nullptr;
+TaskHandle_t networkTaskHandle = nullptr;
+TaskHandle_t displayTaskHandle = nullptr;
+TaskHandle_t ledsTaskHandle = nullptr;
+SemaphoreHandle_t rulesLock = nullptr;  // activeRules: evaluated by sensor, replaced by network
+#ifdef AURALINK_FLICKER
+SemaphoreHandle_t adcLock = nullptr;    // ADC1: analogRead by sensor, DMA blocks by the flicker stage
+#endif
+int8_t hbSensor = -1, hbNetwork = -1, hbDisplay = -1, hbLeds = -1;
+int8_t busTelemetry = -1, busDisplay = -1, busLeds = -1;
+
+// --- Latest Sample: copied out under lock by the HTTP status server ---
+SensorSample latestSample = {};
+portMUX_TYPE latestSampleMux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- Display Text: quote and summary, paged across their LCD rows ---
+// Written by the MQTT callback (network task), read by the display task.
+// Slots and their topics are in downlink_router.h
+const char* const textLabels[TEXT_SLOT_COUNT] = {"Quote", "Summary"};
+TextStore displayText[TEXT_SLOT_COUNT];
+uint16_t textPage[TEXT_SLOT_COUNT];    // Display task only
+SemaphoreHandle_t textLock = nullptr;
 
-// --- Non-Blocking Blinking Variables for PIR LED ---
-unsigned long previousMillisPIR = 0;
-const long intervalPIR = 100;
-int ledStatePIR = LOW;
+// --- Histograms (each written by a single task) ---
+Histogram sampleWorkHist("auralink_sample_work_us", "Sensor task time per sample");
+Histogram publishHist("auralink_publish_us", "client.publish() call duration");
+Histogram telemetryBusHist("auralink_bus_telemetry_us", "Event bus latency to the network task");
+Histogram displayBusHist("auralink_bus_display_us", "Event bus latency to the display task");
+Histogram ledsBusHist("auralink_bus_leds_us", "Event bus latency to the LED task");
+
+// --- Local Rules (defaults in default_rules.cpp) ---
+const uint8_t ledPins[RULE_LED_COUNT] = {
+  LED_TEMP_PIN, LED_LIGHT_PIN, LED_NOX_PIN, LED_PIR_PIN, LED_URGENCY_PIN
+};
+
+RuleProgram activeRules;
+RuleState ruleState;
+uint32_t lastAlertMask = 0;
+LedEffect publishedLeds[RULE_LED_COUNT];   // Last effect sent per LED; sensor task only
 
 // --- Helper Functions Declaration ---
-void connectToWiFi();
-void reconnectMQTT();
+bool linkUp();
+IPAddress linkLocalIP();
+bool bringUpNetwork();
+bool restoreWarmState();
+void maintainMQTT();
+size_t encodeSampleUplink(const SensorSample& s, uint8_t* buf, size_t len);
+void drainSampleBuffer();
+bool queueSampleBatch();
+void flushOutbound();
+void publishHealth();
+void buildBrokerList();
+size_t formatHealthJson(char* buf, size_t len);
+void loadStoredRules();
+void updateRules(const byte* payload, unsigned int length);
+#ifdef AURALINK_CAPTURE
+void controlCapture(const byte* payload, unsigned int length);
+#endif
+void applyRuleOutputs(const RuleOutputs& out);
+void publishTrigger(const RuleTriggerEvent& trigger);
+void publishFlicker(const FlickerResult& result);
+void handleDownlink(const byte* payload, unsigned int length);
+void setUrgency(const LedEffect& urgency);
+LedEffect urgencyEffect(auralink_UrgencyLevel level);
 void callback(char* topic, byte* payload, unsigned int length);
 void printLineFmt(uint8_t row, const char* fmt, ...);
+void storeDisplayText(uint8_t slot, TextTopicKind kind, const ChunkHeader& header,
+                      const byte* payload, unsigned int length);
+void paintTextSlot(uint8_t slot, bool advance);
+void readSensors(RawReadings& raw);
+void loadSettings();
+void pollShell();
+void sampleOnce(const RawReadings& raw, uint32_t timestampMs);
+void startSensorTask();
+void startNetworkTask();
+void startDisplayTask();
+void startLedsTask();
 
 // ------------------------------------------------------------------
 // --- Helper: Print Padded LCD Line ---
@@ -72,232 +380,1362 @@ void printLineFmt(uint8_t row, const char* fmt, ...) {
 // ------------------------------------------------------------------
 // --- MQTT Callback: Handles Messages from Backend ---
 // ------------------------------------------------------------------
+// Payloads may be binary and are never NUL-terminated; they go to the
+// parsers as (pointer, length). Dispatch is downlink_router.h, which the
+// native fuzzers (src/native/fuzz/) drive with the same parsers.
 void callback(char* topic, byte* payload, unsigned int length) {
   Serial.print("Message arrived [");
   Serial.print(topic);
   Serial.print("] ");
+  Serial.printf("%u bytes\n", length);
 
-  // Convert payload to String
-  String message = "";
-  for (int i = 0; i < length; i++) {
-    message += (char)payload[i];
-  }
-  Serial.println(message);
-
-  if (strcmp(topic, TOPIC_DISPLAY_QUOTE) == 0) {
-    // Show Quote on the first two lines
-    lcd.clear();
-    printLineFmt(0, "Quote:");
-    // Display the first part of the quote
-    printLineFmt(1, "%s", message.substring(0, 20).c_str()); 
-  } else if (strcmp(topic, TOPIC_DISPLAY_SUMMARY) == 0) {
-    // Show Summary on the last two lines
-    printLineFmt(2, "Summary:");
-    // Display the first part of the summary
-    printLineFmt(3, "%s", message.substring(0, 20).c_str());
-  } else if (strcmp(topic, TOPIC_URGENCY_LED) == 0) {
-    // Control the Urgency LED based on the one-word response
-    if (message.indexOf("HIGH") != -1) {
-      digitalWrite(LED_URGENCY_PIN, HIGH); // Turn on for HIGH urgency
-    } else if (message.indexOf("MEDIUM") != -1) {
-      // Could implement a slow blink for MEDIUM
-    } else {
-      digitalWrite(LED_URGENCY_PIN, LOW); // Turn off for LOW urgency
-    }
+  DownlinkTarget target;
+  switch (downlinkRoute(topic, target)) {
+    case DOWNLINK_ROUTE_PROTOBUF:
+      handleDownlink(payload, length);
+      break;
+    case DOWNLINK_ROUTE_RULES:
+      updateRules(payload, length);
+      break;
+    case DOWNLINK_ROUTE_CAPTURE:
+#ifdef AURALINK_CAPTURE
+      controlCapture(payload, length);
+#endif
+      break;
+    case DOWNLINK_ROUTE_TEXT:
+      // Quote/summary text, whole or chunked, goes straight into its store
+      storeDisplayText(target.textSlot, target.textKind, target.chunk, payload, length);
+      break;
+    case DOWNLINK_ROUTE_URGENCY:
+      // Only events leave the callback; the LCD and LEDs are driven by
+      // their own tasks, so I2C latency never holds up client.loop()
+      setUrgency(urgencyEffect(urgencyFromText(payload, length)));
+      break;
+    case DOWNLINK_ROUTE_NONE:
+      break;
+  }
+}
+
+// Protobuf downlinks (proto/auralink.proto) end up in the same handlers
+// as their plain-topic counterparts; bodies are decoded in place
+void handleDownlink(const byte* payload, unsigned int length) {
+  WireDownlink msg;
+  char err[48];
+  if (!wireDecodeDownlink(payload, length, msg, err, sizeof(err))) {
+    downlinksRejected++;
+    Serial.printf("Downlink rejected: %s\n", err);
+    return;
+  }
+  downlinksDecoded++;
+  switch (msg.kind) {
+    case WIRE_DOWNLINK_QUOTE:
+    case WIRE_DOWNLINK_SUMMARY:
+      storeDisplayText(msg.kind == WIRE_DOWNLINK_QUOTE ? TEXT_SLOT_QUOTE : TEXT_SLOT_SUMMARY,
+                       msg.chunked ? TEXT_TOPIC_CHUNK : TEXT_TOPIC_WHOLE, msg.chunk, msg.data, msg.len);
+      break;
+    case WIRE_DOWNLINK_URGENCY:
+      setUrgency(urgencyEffect(msg.urgency));
+      break;
+    case WIRE_DOWNLINK_RULES:
+      updateRules(msg.data, msg.len);
+      break;
+    case WIRE_DOWNLINK_CAPTURE:
+#ifdef AURALINK_CAPTURE
+      controlCapture(msg.data, msg.len);
+#endif
+      break;
   }
 }
 
+// Solid for HIGH, slow blink for MEDIUM, off for LOW
+LedEffect urgencyEffect(auralink_UrgencyLevel level) {
+  return level == auralink_UrgencyLevel_URGENCY_HIGH     ? ledSolid()
+         : level == auralink_UrgencyLevel_URGENCY_MEDIUM ? ledBlink(1000)
+                                                         : ledOff();
+}
+
+void setUrgency(const LedEffect& urgency) {
+  eventBusLed(RULE_LED_URGENCY, urgency);
+  warmStateSaveUrgency(urgency);
+}
+
 // ------------------------------------------------------------------
-// --- MQTT Connection Logic ---
+// --- Display Text: Streamed into Fixed Stores, Paged by the Display ---
 // ------------------------------------------------------------------
-void reconnectMQTT() {
-  // Loop until we're reconnected
-  while (!client.connected()) {
-    Serial.print("Attempting MQTT connection...");
-    // Attempt to connect
-    if (client.connect(mqttClientId)) {
-      Serial.println("connected");
-      // Subscribe to topics where the backend publishes data
-      client.subscribe(TOPIC_DISPLAY_QUOTE);
-      client.subscribe(TOPIC_DISPLAY_SUMMARY);
-      client.subscribe(TOPIC_URGENCY_LED);
-    } else {
-      Serial.print("failed, rc=");
-      Serial.print(client.state());
-      Serial.println(" trying again in 5 seconds");
-      // Wait 5 seconds before retrying
-      delay(5000);
+void storeDisplayText(uint8_t slot, TextTopicKind kind, const ChunkHeader& header,
+                      const byte* payload, unsigned int length) {
+  bool repaint = true;
+  xSemaphoreTake(textLock, portMAX_DELAY);
+  bool settled = true;
+  if (kind == TEXT_TOPIC_WHOLE) {
+    displayText[slot].set(payload, length);
+  } else {
+    ChunkResult result = displayText[slot].appendChunk(header, payload, length);
+    // Show the first page as soon as it arrives, then again once complete
+    repaint = (result == CHUNK_APPENDED && header.index == 0) || result == CHUNK_COMPLETE;
+    settled = result == CHUNK_COMPLETE;
+  }
+  if (settled) warmStateSaveText(slot, displayText[slot].text());
+  xSemaphoreGive(textLock);
+  if (repaint) eventBusDisplayStore(slot);
+}
+
+// Slot N owns rows 2N (label, page counter) and 2N+1 (one page of text).
+// Runs on the display task only.
+void paintTextSlot(uint8_t slot, bool advance) {
+  char window[21];
+  xSemaphoreTake(textLock, portMAX_DELAY);
+  const TextStore& store = displayText[slot];
+  size_t pages = (store.length() + 19) / 20;
+  bool truncated = store.truncated();
+  if (advance && pages > 1) textPage[slot]++;
+  if (textPage[slot] >= pages) textPage[slot] = 0;
+  snprintf(window, sizeof(window), "%s", store.text() + textPage[slot] * 20);
+  xSemaphoreGive(textLock);
+
+  if (pages == 0 || (advance && pages == 1)) return;  // Nothing new to show
+  if (pages > 1) {
+    printLineFmt(slot * 2, "%s: %u/%u%s", textLabels[slot], textPage[slot] + 1, (unsigned)pages,
+                 truncated ? "+" : "");
+  } else {
+    printLineFmt(slot * 2, "%s:", textLabels[slot]);
+  }
+  printLineFmt(slot * 2 + 1, "%s", window);
+}
+
+// ------------------------------------------------------------------
+// --- Broker View: published by the network task, copied by readers ---
+// ------------------------------------------------------------------
+void publishBrokerView() {
+  BrokerView v = {};
+  v.count = brokerCount;
+  v.active = activeBroker.load();
+  for (uint8_t i = 0; i < brokerCount; i++) {
+    snprintf(v.hosts[i], sizeof(v.hosts[i]), "%s", brokerList[i].host);
+  }
+  v.haveLocal = haveLocalBroker;
+  if (haveLocalBroker) snprintf(v.localName, sizeof(v.localName), "%s", localBroker.name);
+  v.localRttMs = localBroker.rttMs;
+  portENTER_CRITICAL(&brokerViewMux);
+  brokerView = v;
+  portEXIT_CRITICAL(&brokerViewMux);
+}
+
+void setActiveBroker(int8_t index) {
+  activeBroker = index;
+  publishBrokerView();
+}
+
+BrokerView brokerViewSnapshot() {
+  portENTER_CRITICAL(&brokerViewMux);
+  BrokerView v = brokerView;
+  portEXIT_CRITICAL(&brokerViewMux);
+  return v;
+}
+
+// ------------------------------------------------------------------
+// --- MQTT Connection Logic (non-blocking, with broker failover) ---
+// ------------------------------------------------------------------
+void maintainMQTT() {
+  unsigned long now = millis();
+  int8_t preferred = brokerPoolPreferred();
+  int8_t active = activeBroker;
+  if (preferred >= 0) bootMark(BOOT_BROKER_HEALTHY);
+
+  if (client.connected()) {
+    // Fail back once a higher-priority broker has been healthy again
+    if (preferred < 0 || preferred >= active || now - activeSinceMs < failbackHoldMs) {
+      return;
     }
+    Serial.printf("Failing back from %s to %s\n",
+                  brokerList[active].host, brokerList[preferred].host);
+    client.disconnect();
+  } else if (active >= 0) {
+    // Session dropped under us: let the pool know right away
+    Serial.printf("Lost MQTT session on %s\n", brokerList[active].host);
+    brokerPoolReportFailure(active);
+    setActiveBroker(-1);
+    preferred = brokerPoolPreferred();
+  }
+
+  // Only ever dial brokers the probes vouch for, so a dead broker never
+  // stalls the network task on a connect timeout.
+  if (preferred < 0 || now - lastMqttAttemptMs < mqttRetryIntervalMs) return;
+  lastMqttAttemptMs = now;
+
+  BrokerHealth health = brokerPoolHealth(preferred);
+  Serial.printf("Attempting MQTT connection to %s...", brokerList[preferred].host);
+  client.setServer(health.ip, brokerList[preferred].port);
+#ifdef AURALINK_MQTT_TLS
+  tlsClient.setHostname(brokerList[preferred].tlsName ? brokerList[preferred].tlsName
+                                                     : brokerList[preferred].host);
+#endif
+  if (client.connect(mqttClientId)) {
+    Serial.println("connected");
+    if (preferred != 0) brokerFailovers++;
+    setActiveBroker(preferred);
+    activeSinceMs = now;
+    if (preferred == 0 && haveLocalBroker) {
+      // Proven reachable: worth skipping mDNS for after a reset
+      WarmBrokerHint hint = {};
+      snprintf(hint.name, sizeof(hint.name), "%s", localBroker.name);
+      snprintf(hint.host, sizeof(hint.host), "%s", localBroker.host);
+      hint.port = localBroker.port;
+      warmStateSaveLocalBroker(&hint);
+    }
+    // Subscribe to topics where the backend publishes data
+    client.subscribe(TOPIC_DOWNLINK, 1);                // QoS 1: it carries text chunks too
+    client.subscribe(TOPIC_DISPLAY_QUOTE);
+    client.subscribe(TOPIC_DISPLAY_SUMMARY);
+    client.subscribe(TOPIC_DISPLAY_QUOTE_CHUNKS, 1);   // QoS 1: a lost chunk truncates the text
+    client.subscribe(TOPIC_DISPLAY_SUMMARY_CHUNKS, 1);
+    client.subscribe(TOPIC_URGENCY_LED);
+    client.subscribe(TOPIC_RULES_SET);
+#ifdef AURALINK_CAPTURE
+    client.subscribe(TOPIC_CAPTURE_CONTROL);
+#endif
+    bootMark(BOOT_MQTT_CONNECTED);
+    // During boot the first health record waits for the first sample to
+    // go out, so it carries the complete boot profile
+    if (bootReached(BOOT_FIRST_PUBLISH)) publishHealth();
+  } else {
+    Serial.print("failed, rc=");
+    Serial.println(client.state());
+    brokerPoolReportFailure(preferred);
   }
 }
 
 // ------------------------------------------------------------------
-// --- WiFi Connection Logic ---
+// --- Broker List: mDNS-discovered local broker first, then configured ---
 // ------------------------------------------------------------------
-void connectToWiFi() {
-  Serial.println("\nAttempting to connect to WiFi network: " + String(ssid));
-  lcd.clear();
-  printLineFmt(0, "Connecting to WiFi...");
-  WiFi.begin(ssid, password);
-  
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    if (attempts % 5 == 0) {
-      Serial.println();
-      Serial.printf("Attempt %d - WiFi status: %d\n", attempts + 1, WiFi.status());
+void buildBrokerList() {
+  brokerCount = 0;
+  const WarmState& prior = warmStateRestored();
+  if (prior.haveLocalBroker && localBroker.ip.fromString(prior.localBroker.host)) {
+    // Warm start: reuse the broker we were on; the probes still vet it.
+    // The hint is re-saved only once it connects again.
+    snprintf(localBroker.name, sizeof(localBroker.name), "%s", prior.localBroker.name);
+    snprintf(localBroker.host, sizeof(localBroker.host), "%s", prior.localBroker.host);
+    localBroker.port = prior.localBroker.port;
+    localBroker.rttMs = 0;
+    haveLocalBroker = true;
+  } else {
+#ifdef AURALINK_QEMU
+    haveLocalBroker = false;   // No multicast through QEMU user networking
+#else
+    haveLocalBroker = discoverLocalBroker(MDNS_MQTT_SERVICE, localBroker);
+#endif
+  }
+  warmStateSaveLocalBroker(nullptr);
+  if (haveLocalBroker) {
+    // Connect by address; verify the certificate against the .local name
+    snprintf(localBrokerTlsName, sizeof(localBrokerTlsName), "%s.local", localBroker.name);
+    BrokerEndpoint local = {localBroker.host, localBroker.port, mqttBrokers[0].tls,
+                            mqttBrokers[0].tls ? localBrokerTlsName : nullptr};
+    brokerList[brokerCount++] = local;
+    Serial.printf("Preferring local broker %s (%s:%u, %lu ms)\n", localBroker.name,
+                  localBroker.host, localBroker.port, (unsigned long)localBroker.rttMs);
+  } else {
+    Serial.println("No local broker found; using configured brokers");
+  }
+  for (uint8_t i = 0; i < mqttBrokerCount && brokerCount < BROKER_POOL_MAX; i++) {
+    brokerList[brokerCount++] = mqttBrokers[i];
+  }
+  publishBrokerView();
+}
+
+// ------------------------------------------------------------------
+// --- Drain Buffered Samples to the Active Broker ---
+// ------------------------------------------------------------------
+// Samples move to the outbound queue only while connected and only a few
+// at a time; the rest wait in the (much denser) sample buffer, so health
+// and status messages always find room.
+void drainSampleBuffer() {
+  uint8_t payload[SAMPLE_UPLINK_MAX];
+  while (!sampleBuffer.empty() && client.connected() && outbound.size() < SAMPLES_QUEUED_MAX) {
+    if (sampleBuffer.size() >= BATCH_MIN_SAMPLES) {
+      if (!queueSampleBatch()) return;
+      continue;
+    }
+    size_t len = encodeSampleUplink(sampleBuffer.front(), payload, sizeof(payload));
+    if (len == 0) {
+      sampleBuffer.pop(); // Cannot be encoded; never will be
+      continue;
+    }
+    if (!outbound.hasRoom(len)) return;  // Backpressure: keep it buffered
+    outbound.push(TOPIC_SAMPLE_UPLINK, payload, len, OUTBOUND_DROP_NEWEST);
+    Serial.printf("Queued for %s: seq %lu, %u bytes\n", TOPIC_SAMPLE_UPLINK,
+                  (unsigned long)sampleBuffer.front().seq, (unsigned)len);
+    sampleBuffer.pop();
+  }
+}
+
+// One sample in the build's uplink encoding; 0 if it cannot be encoded
+size_t encodeSampleUplink(const SensorSample& s, uint8_t* buf, size_t len) {
+#ifdef AURALINK_UPLINK_JSON
+  return formatSensorPayload(s, (char*)buf, len);
+#else
+  return wireEncodeSample(s, buf, len);
+#endif
+}
+
+// Packs as much of the backlog as fits one BATCH_PAYLOAD_MAX message;
+// false when the outbound queue has no room for it
+bool queueSampleBatch() {
+  uint8_t batch[BATCH_PAYLOAD_MAX];
+  unsigned long t0 = micros();
+  SeriesEncoder encoder;
+  encoder.begin(batch, sizeof(batch));
+  for (size_t i = 0; i < sampleBuffer.size(); i++) {
+    if (!encoder.add(sampleBuffer.at(i))) break;
+  }
+  size_t len = encoder.finish();
+  uint32_t us = micros() - t0;
+  if (len == 0 || !outbound.hasRoom(len)) return false;
+  outbound.push(TOPIC_SENSOR_BATCH, batch, len, OUTBOUND_DROP_NEWEST);
+
+  uint8_t single[SAMPLE_UPLINK_MAX];
+  for (uint16_t i = 0; i < encoder.count(); i++) {
+    batchStats.singleBytes += encodeSampleUplink(sampleBuffer.front(), single, sizeof(single));
+    sampleBuffer.pop();
+  }
+  batchStats.batches++;
+  batchStats.samples += encoder.count();
+  batchStats.bytes += len;
+  batchStats.encodeUs += us;
+  if (us > batchStats.encodeMaxUs) batchStats.encodeMaxUs = us;
+  Serial.printf("Queued batch of %u samples, %u bytes, %lu us\n", encoder.count(), (unsigned)len,
+                (unsigned long)us);
+  return true;
+}
+
+// Sends from the front of the outbound queue until the socket pushes back
+void flushOutbound() {
+  for (uint8_t i = 0; i < OUTBOUND_SENDS_PER_LOOP && client.connected() && !outbound.empty(); i++) {
+    OutboundMessage msg = outbound.front();
+    unsigned long t0 = micros();
+    bool sent = client.publish(msg.topic, msg.payload, msg.len);
+    publishHist.record(micros() - t0);
+    if (!sent) {
+      outbound.sendFailed();  // Kept at the front for the next pass (or the next broker)
+      return;
+    }
+    if (!bootReached(BOOT_FIRST_PUBLISH) && strcmp(msg.topic, TOPIC_SAMPLE_UPLINK) == 0) {
+      bootMark(BOOT_FIRST_PUBLISH);
+      healthDue = true;
     }
-    printLineFmt(1, "Attempt: %d", attempts + 1);
-    attempts++;
+    outbound.popSent();
   }
+}
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\nWiFi connected");
-    Serial.print("IP address: ");
-    Serial.println(WiFi.localIP());
-    printLineFmt(0, "WiFi Connected!");
-    printLineFmt(1, "IP: %s", WiFi.localIP().toString().c_str());
-    delay(1500);
+// ------------------------------------------------------------------
+// --- Health Record (MQTT and HTTP) ---
+// ------------------------------------------------------------------
+size_t formatHealthJson(char* buf, size_t len) {
+  // Runs on the network and HTTP tasks: brokers come from the snapshot
+  BrokerView view = brokerViewSnapshot();
+  int n = snprintf(buf, len,
+                   "{\"broker\":\"%s\",\"local\":\"%s\",\"local_rtt_ms\":%ld,"
+                   "\"failovers\":%lu,\"buffered\":%u,\"dropped\":%lu,\"probes\":[",
+                   view.active >= 0 ? view.hosts[view.active] : "",
+                   view.haveLocal ? view.localName : "",
+                   view.haveLocal ? (long)view.localRttMs : -1L,
+                   (unsigned long)brokerFailovers, (unsigned)sampleBuffer.size(),
+                   (unsigned long)sampleBuffer.dropped());
+  for (uint8_t i = 0; i < view.count && n > 0 && n < (int)len; i++) {
+    BrokerHealth h = brokerPoolHealth(i);
+    n += snprintf(buf + n, len - n, "%s{\"ok\":%d,\"rtt_ms\":%lu,\"ping_ms\":%lu}",
+                  i ? "," : "", h.healthy ? 1 : 0,
+                  (unsigned long)h.connectRttMs, (unsigned long)h.pingRttMs);
+  }
+  if (n > 0 && n < (int)len) n += snprintf(buf + n, len - n, "]");
+  // Per-subsystem stalls, and which one forced the last reboot (if any)
+  if (n > 0 && n < (int)len) {
+    const char* cause = heartbeatLastRebootCause();
+    n += snprintf(buf + n, len - n, ",\"reboot_cause\":\"%s\",\"subsystems\":", cause ? cause : "");
+  }
+  if (n > 0 && n < (int)len) n += heartbeatFormatJson(buf + n, len - n);
+  if (n > 0 && n < (int)len) n += snprintf(buf + n, len - n, ",\"boot\":");
+  if (n > 0 && n < (int)len) n += bootProfileFormatJson(buf + n, len - n);
+  if (n > 0 && n < (int)len) {
+    const OutboundStats& out = outbound.stats();
+    n += snprintf(buf + n, len - n,
+                  ",\"outbound\":{\"queued\":%u,\"sent\":%lu,\"dropped_oldest\":%lu,\"dropped_newest\":%lu,"
+                  "\"coalesced\":%lu,\"retries\":%lu,\"failed\":%lu,\"oversize\":%lu}",
+                  (unsigned)outbound.size(), (unsigned long)out.sent, (unsigned long)out.droppedOldest,
+                  (unsigned long)out.droppedNewest, (unsigned long)out.coalesced, (unsigned long)out.retries,
+                  (unsigned long)out.failed, (unsigned long)out.oversize);
+  }
+  if (n > 0 && n < (int)len) {
+    const BatchStats& b = batchStats;
+    n += snprintf(buf + n, len - n,
+                  ",\"batch\":{\"batches\":%lu,\"samples\":%lu,\"bytes\":%lu,\"single_bytes\":%lu,"
+                  "\"ratio\":%.2f,\"encode_ns_per_sample\":%lu,\"encode_max_us\":%lu}",
+                  (unsigned long)b.batches, (unsigned long)b.samples, (unsigned long)b.bytes,
+                  (unsigned long)b.singleBytes, b.bytes ? (float)b.singleBytes / b.bytes : 0.0f,
+                  (unsigned long)(b.samples ? (uint64_t)b.encodeUs * 1000 / b.samples : 0),
+                  (unsigned long)b.encodeMaxUs);
+  }
+  if (n > 0 && n < (int)len) {
+    n += snprintf(buf + n, len - n, ",\"downlink\":{\"decoded\":%lu,\"rejected\":%lu}",
+                  (unsigned long)downlinksDecoded, (unsigned long)downlinksRejected);
+  }
+#ifndef AURALINK_REPLAY
+  if (n > 0 && n < (int)len) n += snprintf(buf + n, len - n, ",\"clock\":");
+  if (n > 0 && n < (int)len) n += sampleClockFormatJson(buf + n, len - n);
+#endif
+  if (n > 0 && n < (int)len) n += snprintf(buf + n, len - n, ",\"bus\":");
+  if (n > 0 && n < (int)len) n += eventBusFormatJson(buf + n, len - n);
+#ifdef AURALINK_CAPTURE
+  if (n > 0 && n < (int)len) n += snprintf(buf + n, len - n, ",\"capture\":");
+  if (n > 0 && n < (int)len) n += captureFormatJson(buf + n, len - n);
+#endif
+#ifdef AURALINK_MQTT_TLS
+  // Full and resumed handshakes are reported separately
+  const TlsHandshakeStats& tls = tlsClient.stats();
+  if (n > 0 && n < (int)len) {
+    n += snprintf(buf + n, len - n,
+                  ",\"tls\":{\"full\":%lu,\"full_last_ms\":%lu,\"full_avg_ms\":%lu,"
+                  "\"resumed\":%lu,\"resumed_last_ms\":%lu,\"resumed_avg_ms\":%lu,\"failed\":%lu}",
+                  (unsigned long)tls.fullCount, (unsigned long)tls.lastFullMs,
+                  (unsigned long)(tls.fullCount ? tls.totalFullMs / tls.fullCount : 0),
+                  (unsigned long)tls.resumedCount, (unsigned long)tls.lastResumedMs,
+                  (unsigned long)(tls.resumedCount ? tls.totalResumedMs / tls.resumedCount : 0),
+                  (unsigned long)tls.failedCount);
+  }
+#endif
+  if (n > 0 && n < (int)len) n += snprintf(buf + n, len - n, "}");
+  return (n > 0 && n < (int)len) ? n : 0;
+}
+
+void publishHealth() {
+  char buf[HEALTH_PAYLOAD_MAX];
+  size_t len = formatHealthJson(buf, sizeof(buf));
+  if (len > 0) {
+    // Only the newest health record is worth sending
+    outbound.push(TOPIC_DEVICE_HEALTH, (const uint8_t*)buf, len, OUTBOUND_COALESCE);
   } else {
-    Serial.println("\nFailed to connect to WiFi.");
-    printLineFmt(0, "WiFi Failed!");
-    printLineFmt(1, "Check Credentials");
-    delay(5000);
-    ESP.restart(); // Restart if connection fails
+    Serial.println("Health record exceeds HEALTH_PAYLOAD_MAX; not sent");
   }
+  lastHealthMs = millis();
+  healthDue = false;
 }
 
 // ------------------------------------------------------------------
-// --- Setup ---
+// --- HTTP Status Renderers (run on the HTTP server task) ---
 // ------------------------------------------------------------------
-void setup() {
-  Serial.begin(115200);
-  Serial.println("\nAuraLink ESP32 Starting...");
-  dht.begin();
-  Serial.println("DHT sensor initialized");
+SensorSample latestSnapshot() {
+  portENTER_CRITICAL(&latestSampleMux);
+  SensorSample s = latestSample;
+  portEXIT_CRITICAL(&latestSampleMux);
+  return s;
+}
 
-  // Initialize Pins
-  pinMode(LDR_DO, INPUT);
-  pinMode(PIR_PIN, INPUT);
-  pinMode(LED_TEMP_PIN, OUTPUT);
-  pinMode(LED_LIGHT_PIN, OUTPUT);
-  pinMode(LED_NOX_PIN, OUTPUT);
-  pinMode(LED_PIR_PIN, OUTPUT);
-  pinMode(LED_URGENCY_PIN, OUTPUT); // **Setup NEW Urgency LED**
-  Serial.println("All pins initialized");
+size_t renderReadingsJson(char* buf, size_t len) {
+  SensorSample s = latestSnapshot();
+  int n = snprintf(buf, len,
+                   "{\"seq\":%lu,\"age_ms\":%lu,\"temperature\":%.1f,\"humidity\":%.1f,"
+                   "\"light_percent\":%d,\"nox_percent\":%d,\"pir\":%d}",
+                   (unsigned long)s.seq, (unsigned long)(millis() - s.timestampMs),
+                   s.temperature, s.humidity, s.lightPercent, s.noxPercent, s.pir);
+  return (n > 0 && n < (int)len) ? n : 0;
+}
 
-  // Explicit I2C pins for ESP32
-  Wire.begin(I2C_SDA, I2C_SCL);
+size_t renderMetricsText(char* buf, size_t len) {
+  SensorSample s = latestSnapshot();
+  int n = snprintf(buf, len,
+                   "# TYPE auralink_temperature_celsius gauge\nauralink_temperature_celsius %.1f\n"
+                   "# TYPE auralink_humidity_percent gauge\nauralink_humidity_percent %.1f\n"
+                   "# TYPE auralink_light_percent gauge\nauralink_light_percent %d\n"
+                   "# TYPE auralink_nox_percent gauge\nauralink_nox_percent %d\n"
+                   "# TYPE auralink_pir gauge\nauralink_pir %d\n"
+                   "# TYPE auralink_samples_total counter\nauralink_samples_total %lu\n"
+                   "# TYPE auralink_broker_failovers_total counter\nauralink_broker_failovers_total %lu\n"
+                   "# TYPE auralink_samples_buffered gauge\nauralink_samples_buffered %u\n"
+                   "# TYPE auralink_samples_dropped_total counter\nauralink_samples_dropped_total %lu\n"
+                   "# TYPE auralink_mqtt_connected gauge\nauralink_mqtt_connected %d\n"
+                   "# TYPE auralink_free_heap_bytes gauge\nauralink_free_heap_bytes %lu\n",
+                   s.temperature, s.humidity, s.lightPercent, s.noxPercent, s.pir,
+                   (unsigned long)sampleSeq, (unsigned long)brokerFailovers,
+                   (unsigned)sampleBuffer.size(), (unsigned long)sampleBuffer.dropped(),
+                   activeBroker.load() >= 0 ? 1 : 0, (unsigned long)ESP.getFreeHeap());
+  return (n > 0 && n < (int)len) ? n : 0;
+}
 
-  // LCD init
-  lcd.init();
-  lcd.backlight();
-  lcd.clear();
-  lcd.setCursor(0, 0);
-  lcd.print("AuraLink ESP32 Start");
-  delay(800);
+// ------------------------------------------------------------------
+// --- Rules: Load, Update over MQTT, Apply ---
+// ------------------------------------------------------------------
+void loadStoredRules() {
+  char err[64];
+  uint8_t stored[RULES_MAX_CODE + 8];
+  // Each NVS user opens its own handle: the network and loop tasks both
+  // write settings, and a shared Preferences object is not thread-safe
+  Preferences prefs;
+  prefs.begin("auralink", true);
+  size_t len = prefs.getBytes("rules", stored, sizeof(stored));
+  prefs.end();
+  if (len > 0 && rulesLoadBinary(stored, len, activeRules, err, sizeof(err))) {
+    Serial.printf("Loaded %u stored rules\n", activeRules.ruleCount);
+    return;
+  }
+  if (!rulesCompile(defaultRules, strlen(defaultRules), activeRules, err, sizeof(err))) {
+    Serial.printf("Default rules failed to compile: %s\n", err);
+    activeRules.len = 0;
+    activeRules.ruleCount = 0;
+  }
+}
 
-  // Connection Setup
-  connectToWiFi();
-  client.setServer(mqttServer, mqttPort);
-  client.setCallback(callback);
+void updateRules(const byte* payload, unsigned int length) {
+  const size_t magic = sizeof(RULES_BINARY_MAGIC) - 1;
+  static RuleProgram staged;  // Keeps the large buffer off the loop stack
+  char err[64];
+  char status[RULES_STATUS_MAX];
+  bool ok = (length >= magic && memcmp(payload, RULES_BINARY_MAGIC, magic) == 0)
+              ? rulesLoadBinary(payload, length, staged, err, sizeof(err))
+              : rulesCompile((const char*)payload, length, staged, err, sizeof(err));
+
+  if (ok) {
+    xSemaphoreTake(rulesLock, portMAX_DELAY);
+    activeRules = staged;
+    ruleState = RuleState();
+    xSemaphoreGive(rulesLock);
+    uint8_t bin[RULES_MAX_CODE + 8];
+    size_t binLen = rulesSaveBinary(activeRules, bin, sizeof(bin));
+    Preferences prefs;
+    prefs.begin("auralink", false);
+    prefs.putBytes("rules", bin, binLen);
+    prefs.end();
+    snprintf(status, sizeof(status), "ok: %u rules, %u bytes", activeRules.ruleCount, activeRules.len);
+  } else {
+    // Keep running the previous program
+    snprintf(status, sizeof(status), "error: %s", err);
+  }
+  Serial.printf("Rules update %s\n", status);
+  outbound.push(TOPIC_RULES_STATUS, status, OUTBOUND_COALESCE);
+}
+
+// Rule periods are the on (or off) time; LED effects take the full period
+static uint16_t fullPeriod(uint16_t halfMs) {
+  return (uint16_t)min<uint32_t>(halfMs * 2u, UINT16_MAX);
 }
 
+void applyRuleOutputs(const RuleOutputs& out) {
+  // Only changes go on the bus; the LED task runs the patterns
+  for (uint8_t i = 0; i < RULE_LED_COUNT; i++) {
+    const RuleLedCommand& cmd = out.leds[i];
+    LedEffect effect;
+    switch (cmd.mode) {
+      case RULE_LED_OFF:     effect = ledOff(); break;
+      case RULE_LED_ON:      effect = ledSolid(); break;
+      // The compiler caps these at 32767; clamp programs saved before it did
+      case RULE_LED_BLINK:   effect = ledBlink(fullPeriod(cmd.periodMs)); break;
+      case RULE_LED_BREATHE: effect = ledBreathe(cmd.periodMs); break;
+      case RULE_LED_PULSE:   effect = ledPulseTrain(fullPeriod(cmd.periodMs), cmd.count, cmd.gapMs); break;
+      default: continue;  // No rule drove this LED; leave it as is
+    }
+    if (effect == publishedLeds[i]) continue;
+    publishedLeds[i] = effect;
+    eventBusLed(i, effect);
+  }
+
+  uint32_t raised = out.alertMask & ~lastAlertMask;
+  for (uint8_t code = 0; raised; code++, raised >>= 1) {
+    if (raised & 1) Serial.printf("Local alert %u raised\n", code);
+  }
+  lastAlertMask = out.alertMask;
+}
+
+// Runs on the network task, which owns the MQTT client
+void publishTrigger(const RuleTriggerEvent& trigger) {
+  const SensorSample& sample = trigger.sample;
+  char buf[TRIGGER_PAYLOAD_MAX];
+  snprintf(buf, sizeof(buf), "{\"trigger\":%u, \"seq\":%lu, \"temperature\":%.1f, \"nox_percent\":%d}",
+           trigger.code, (unsigned long)sample.seq, sample.temperature, sample.noxPercent);
+  // Queued even while offline; the oldest triggers give way first
+  outbound.push(TOPIC_DEVICE_EVENT, buf, OUTBOUND_DROP_OLDEST);
+  Serial.printf("Rule trigger %u: %s\n", trigger.code, buf);
+}
+
+// Runs on the network task
+void publishFlicker(const FlickerResult& result) {
+  char buf[FLICKER_PAYLOAD_MAX];
+  snprintf(buf, sizeof(buf),
+           "{\"flicker_index\":%.4f, \"percent_flicker\":%.1f, \"dominant_hz\":%.1f, \"ac_rms\":%.1f}",
+           result.flickerIndex, result.percentFlicker, result.dominantHz, result.acRms);
+  outbound.push(TOPIC_SENSOR_FLICKER, buf, OUTBOUND_COALESCE);
+  Serial.printf("Flicker: %s\n", buf);
+}
+
+#ifdef AURALINK_CAPTURE
+// Runs on the network task (from the MQTT callback)
+void controlCapture(const byte* payload, unsigned int length) {
+  CaptureRequest req;
+  char err[64];
+  char status[CAPTURE_STATUS_MAX];
+  if (captureParseCommand((const char*)payload, length, req, err, sizeof(err)) &&
+      captureControl(req, err, sizeof(err))) {
+    if (req.action == CAPTURE_STOP) {
+      snprintf(status, sizeof(status), "ok: stopping");
+    } else {
+      snprintf(status, sizeof(status), "ok: %lu Hz for %lu s", (unsigned long)req.rateHz,
+               (unsigned long)req.seconds);
+    }
+  } else {
+    snprintf(status, sizeof(status), "error: %s", err);
+  }
+  Serial.printf("Capture %s\n", status);
+  outbound.push(TOPIC_CAPTURE_STATUS, status, OUTBOUND_COALESCE);
+}
+#endif
+
 // ------------------------------------------------------------------
-// --- Main Loop ---
+// --- WiFi / Network Bring-up (network task, non-blocking) ---
 // ------------------------------------------------------------------
-void loop() {
-  // Check and maintain MQTT connection
-  if (!client.connected()) {
-    reconnectMQTT();
+// setup() only calls WiFi.begin() (qemuNetBegin() in QEMU builds); the
+// link comes up in the driver while everything else boots. Once there is
+// an IP the broker list is built (mDNS needs the link) and the probes
+// start. Returns true once the network side is up.
+bool linkUp() {
+#ifdef AURALINK_QEMU
+  return qemuNetUp();
+#else
+  return WiFi.status() == WL_CONNECTED;
+#endif
+}
+
+IPAddress linkLocalIP() {
+#ifdef AURALINK_QEMU
+  return qemuNetLocalIP();
+#else
+  return WiFi.localIP();
+#endif
+}
+
+bool bringUpNetwork() {
+  static unsigned long lastNoticeMs = 0;
+  static unsigned long failedAtMs = 0;
+  if (networkOnline) return true;
+
+  unsigned long now = millis();
+  if (!linkUp()) {
+    if (failedAtMs) {
+      // Leave the error on screen for a moment, then start over
+      if (now - failedAtMs >= WIFI_FAIL_NOTICE_MS) ESP.restart();
+    } else if (now >= WIFI_BOOT_TIMEOUT_MS) {
+      Serial.println("\nFailed to connect to WiFi.");
+      eventBusDisplayText(0, "WiFi Failed!");
+      eventBusDisplayText(1, "Check Credentials");
+      failedAtMs = now;
+    } else if (now - lastNoticeMs >= 1000) {
+#ifdef AURALINK_QEMU
+      Serial.println("Ethernet: waiting for DHCP");
+#else
+      Serial.printf("WiFi status: %d\n", WiFi.status());
+#endif
+      eventBusDisplayText(1, "WiFi: joining %lus", now / 1000);
+      lastNoticeMs = now;
+    }
+    return false;
   }
-  client.loop(); // Required to process incoming MQTT messages
 
-  // --- Sensor Readings ---
-  float h = dht.readHumidity();
-  float t = dht.readTemperature();
+  bootMark(BOOT_WIFI_UP);
+#ifndef AURALINK_QEMU
+  warmStateSaveWifi(WiFi.channel(), WiFi.BSSID());
+#endif
+  Serial.print("Network up, IP address: ");
+  Serial.println(linkLocalIP());
+  eventBusDisplayText(1, "IP: %s", linkLocalIP().toString().c_str());
+  buildBrokerList();
+  brokerPoolBegin(brokerList, brokerCount, mqttProbeClientId, linkUp);
+  bootMark(BOOT_BROKERS_LISTED);
+  networkOnline = true;
+  return true;
+}
+
+// ------------------------------------------------------------------
+// --- Cooperative Restarts ---
+// ------------------------------------------------------------------
+// The supervisor never deletes a task or touches its peripheral: a task
+// killed from outside may hold the Wire lock, rulesLock, textLock or the
+// MQTT client, and those would stay held for good. It raises the task's
+// restart flag and wakes it instead. At the top of its loop, where it
+// holds nothing, the task resets its own peripheral and carries on. A
+// task that never gets back there stays silent, and the heartbeat
+// escalates to a reboot.
+volatile bool sensorRestart = false;
+volatile bool networkRestart = false;
+volatile bool displayRestart = false;
+volatile bool ledsRestart = false;
+
+void requestRestart(volatile bool& flag, TaskHandle_t task) {
+  flag = true;
+  if (task) xTaskNotifyGive(task);  // Cuts an event bus wait short
+}
 
-  int ldrAnalog = analogRead(LDR_AO);
-  int ldrPercent = map(ldrAnalog, 4095, 0, 0, 100);
-  ldrPercent = constrain(ldrPercent, 0, 100);
+// Task side: true once per request
+bool restartTaken(volatile bool& flag) {
+  if (!flag) return false;
+  flag = false;
+  return true;
+}
 
-  int ldrDigital = digitalRead(LDR_DO);
-  int noxRaw = analogRead(NOX_PIN);
-  int noxPercent = map(noxRaw, 0, 4095, 0, 100);
-  noxPercent = constrain(noxPercent, 0, 100);
+// Clocks out a slave that is holding SDA low, then re-inits the bus.
+// Display task only: it is the sole user of the bus.
+void recoverI2CBus() {
+  Wire.end();
+  pinMode(I2C_SDA, INPUT_PULLUP);
+  pinMode(I2C_SCL, OUTPUT_OPEN_DRAIN);
+  for (uint8_t i = 0; i < 9 && digitalRead(I2C_SDA) == LOW; i++) {
+    digitalWrite(I2C_SCL, LOW);
+    delayMicroseconds(5);
+    digitalWrite(I2C_SCL, HIGH);
+    delayMicroseconds(5);
+  }
+  Wire.begin(I2C_SDA, I2C_SCL);
+  Wire.setTimeOut(I2C_TIMEOUT_MS);
+}
 
-  int pirState = digitalRead(PIR_PIN);
+// Network task only: drops the session; maintainMQTT() redials
+void resetNetworkSession() {
+  espClient.stop();
+  setActiveBroker(-1);
+#ifndef AURALINK_QEMU
+  if (WiFi.status() != WL_CONNECTED) WiFi.reconnect();
+#endif
+}
 
+// ------------------------------------------------------------------
+// --- Sensor Task: one sample, rules, LEDs ---
+// ------------------------------------------------------------------
+void readSensors(RawReadings& raw) {
+  raw.humidity = dht.readHumidity();
+  raw.temperature = dht.readTemperature();
+  raw.ldrDigital = digitalRead(LDR_DO);
+#ifdef AURALINK_CAPTURE
+  // ADC1 belongs to the capture while it runs; use its latest values
+  if (!captureLatest(raw.ldrAnalog, raw.noxRaw))
+#endif
+  {
+#ifdef AURALINK_FLICKER
+    xSemaphoreTake(adcLock, portMAX_DELAY);   // At most one flicker block (~0.5 s)
+#endif
+    raw.ldrAnalog = analogRead(LDR_AO);
+    raw.noxRaw = analogRead(NOX_PIN);
+#ifdef AURALINK_FLICKER
+    xSemaphoreGive(adcLock);
+#endif
+  }
+  raw.pir = digitalRead(PIR_PIN);
+#ifdef AURALINK_TRACE_RECORD
+  // %.9g round-trips a float exactly, so replays match the recording
+  Serial.printf("TRACE,%lu,%.9g,%.9g,%u,%u,%u,%u\n", (unsigned long)millis(), raw.temperature, raw.humidity,
+                raw.ldrAnalog, raw.noxRaw, raw.ldrDigital, raw.pir);
+#endif
+}
+
+void sampleOnce(const RawReadings& raw, uint32_t timestampMs) {
   // --- DHT Error Check ---
-  if (isnan(h) || isnan(t)) {
+  if (!readingsValid(raw)) {
     Serial.println("DHT22 read error");
-    printLineFmt(0, "DHT22 Error");
-    printLineFmt(1, "Check wiring");
-    delay(1000);
+    eventBusDisplayText(0, "DHT22 Error");
+    eventBusDisplayText(1, "Check wiring");
     return;
   }
+  bootMark(BOOT_FIRST_SAMPLE);
+
+  Event event;
+  event.type = EVENT_SAMPLE;
+  SensorSample& sample = event.sample;
+  sample = readingsToSample(raw, sampleSeq++, timestampMs);
 
   // --- Serial Output ---
   Serial.printf("Temp: %.1f C | Hum: %.1f %% | Light: %d%% | NOx: %d%% | PIR: %d\n",
-                t, h, ldrPercent, noxPercent, pirState);
+                sample.temperature, sample.humidity, sample.lightPercent, sample.noxPercent, sample.pir);
+
+  portENTER_CRITICAL(&latestSampleMux);
+  latestSample = sample;
+  portEXIT_CRITICAL(&latestSampleMux);
+  warmStateSaveSample(sample, sampleSeq);
 
   // =========================================================
-  // --- Publish Sensor Data to Backend ---
+  // --- Local Rules: LEDs, Alerts, Publish Triggers ---
   // =========================================================
-  // Create JSON payload
-  char jsonBuffer[256];
-  snprintf(jsonBuffer, sizeof(jsonBuffer), 
-           "{\"temperature\":%.1f, \"humidity\":%.1f, \"light_percent\":%d, \"nox_percent\":%d}",
-           t, h, ldrPercent, noxPercent);
-  
-  // Publish the data
-  client.publish(TOPIC_SENSOR_DATA, jsonBuffer);
-  Serial.printf("Published to %s: %s\n", TOPIC_SENSOR_DATA, jsonBuffer);
+  RuleInputs inputs;
+  sampleToRuleInputs(sample, inputs);
+  RuleOutputs outputs;
+  xSemaphoreTake(rulesLock, portMAX_DELAY);
+  rulesEvaluate(activeRules, inputs, ruleState, outputs);
+  xSemaphoreGive(rulesLock);
+  applyRuleOutputs(outputs);
 
   // =========================================================
-  // --- Local LED Logic (UNCHANGED) ---
+  // --- Hand the Sample and Triggers to Telemetry ---
   // =========================================================
-  
-  // NEW LED Logic 1: NOx / Air Quality (LED_NOX_PIN)
-  if (noxPercent <= 30) {
-    digitalWrite(LED_NOX_PIN, LOW);
-  } else if (noxPercent > 60) {
-    digitalWrite(LED_NOX_PIN, HIGH);
+  eventBusPublish(event);
+  for (uint8_t code = 0; code < 32; code++) {
+    if (!(outputs.publishMask & (1UL << code))) continue;
+    Event trigger;
+    trigger.type = EVENT_RULE_TRIGGER;
+    trigger.trigger.code = code;
+    trigger.trigger.sample = sample;
+    eventBusPublish(trigger);
+  }
+}
+
+#ifdef AURALINK_REPLAY
+// Sleeps until `due`, in slices short enough to keep the heartbeat alive
+void replayWaitUntil(TickType_t due) {
+  for (;;) {
+    esp_task_wdt_reset();
+    heartbeatBeat(hbSensor);
+    if (restartTaken(sensorRestart)) Serial.println("Sensor task restarted");  // Nothing to re-init
+    int32_t remaining = (int32_t)(due - xTaskGetTickCount());
+    if (remaining <= 0) return;
+    vTaskDelay(min((TickType_t)remaining, (TickType_t)pdMS_TO_TICKS(SUPERVISOR_INTERVAL_MS)));
+  }
+}
+
+// Plays the trace partition instead of reading the sensors. Numbering
+// restarts at 0 and timestamps come from the trace, so every run (and the
+// native replay tool) produces the same output stream.
+void sensorTask(void*) {
+  esp_task_wdt_add(nullptr);
+  TraceReader trace;
+  bool ok = tracePartitionBegin(trace);
+  if (ok) {
+    replayTotal = trace.count();
+    Serial.printf("Replay: %lu records at %lux\n", (unsigned long)trace.count(), (unsigned long)replaySpeed);
   } else {
-    // Caution: BLINK (Blocking delay is less impactful due to long main delay)
-    digitalWrite(LED_NOX_PIN, HIGH);
-    delay(100); 
-    digitalWrite(LED_NOX_PIN, LOW);
-    delay(100); 
-  }
-
-  // NEW LED Logic 2: PIR Motion (LED_PIR_PIN) - Non-Blocking
-  if (pirState == HIGH) {
-    unsigned long currentMillis = millis();
-    if (currentMillis - previousMillisPIR >= intervalPIR) {
-      previousMillisPIR = currentMillis;
-      ledStatePIR = !ledStatePIR;
-      digitalWrite(LED_PIR_PIN, ledStatePIR);
+    Serial.println("Replay: no valid trace in the 'trace' partition");
+    eventBusDisplayText(0, "Replay: no trace");
+  }
+  sampleSeq = 0;
+  uint32_t speed = replaySpeed;
+  uint32_t baseOffsetMs = 0, lastOffsetMs = 0;
+  TickType_t start = xTaskGetTickCount();
+  TraceRecord rec;
+  while (ok && trace.next(rec)) {
+    if (replaySpeed != speed) {
+      // Pace from the last played record at the new speed
+      speed = replaySpeed;
+      start = xTaskGetTickCount();
+      baseOffsetMs = lastOffsetMs;
     }
+    TickType_t due = speed ? start + pdMS_TO_TICKS((rec.offsetMs - baseOffsetMs) / speed)
+                           : xTaskGetTickCount() + 1;
+    replayWaitUntil(due);
+    unsigned long t0 = micros();
+    sampleOnce(rec.readings, rec.offsetMs);
+    sampleWorkHist.record(micros() - t0);
+    lastOffsetMs = rec.offsetMs;
+    replayPlayed++;
+  }
+  if (ok) Serial.println("Replay: done");
+  for (;;) replayWaitUntil(xTaskGetTickCount() + pdMS_TO_TICKS(SUPERVISOR_INTERVAL_MS));
+}
+#else
+void sensorTask(void*) {
+  esp_task_wdt_add(nullptr);
+  // First tick only once the DHT22 has warmed up; the rest of boot goes
+  // on. After a sensor recovery the clock keeps its original schedule.
+  sampleClockStart(millis() < DHT_WARMUP_MS ? DHT_WARMUP_MS - millis() : 0);
+  for (;;) {
+    esp_task_wdt_reset();
+    heartbeatBeat(hbSensor);
+    if (restartTaken(sensorRestart)) {
+      dht.begin();
+      Serial.println("Sensor task restarted");
+    }
+    SampleTick tick;
+    if (!sampleClockWait(tick, pdMS_TO_TICKS(SUPERVISOR_INTERVAL_MS))) continue;
+    unsigned long t0 = micros();
+    RawReadings raw;
+    readSensors(raw);
+    // Stamped in the timer callback, not when the reads finished
+    sampleOnce(raw, (uint32_t)(tick.captureUs / 1000));
+    sampleWorkHist.record(micros() - t0);
+  }
+}
+#endif
+
+// ------------------------------------------------------------------
+// --- Network Task: MQTT session, offline buffer, publishing ---
+// ------------------------------------------------------------------
+void networkTask(void*) {
+  esp_task_wdt_add(nullptr);
+  for (;;) {
+    esp_task_wdt_reset();
+    heartbeatBeat(hbNetwork);
+    if (restartTaken(networkRestart)) {
+      resetNetworkSession();
+      Serial.println("Network task restarted");
+    }
+
+    // Check and maintain MQTT connection (never blocks on a dead broker)
+    if (bringUpNetwork()) {
+      maintainMQTT();
+      client.loop(); // Required to process incoming MQTT messages
+    }
+
+    // Queue new samples, then drain the backlog oldest-first to whichever
+    // broker is active. While offline the buffer keeps the newest history.
+    Event event;
+    while (eventBusReceive(busTelemetry, event, 0)) {
+      if (event.type == EVENT_SAMPLE) {
+        sampleBuffer.push(event.sample);
+      } else if (event.type == EVENT_RULE_TRIGGER) {
+        publishTrigger(event.trigger);
+      } else if (event.type == EVENT_FLICKER) {
+        publishFlicker(event.flicker);
+      }
+    }
+    drainSampleBuffer();
+
+    if (client.connected() && (healthDue || millis() - lastHealthMs >= healthIntervalMs)) {
+      publishHealth();
+    }
+    flushOutbound();
+    vTaskDelay(pdMS_TO_TICKS(NETWORK_POLL_MS));
+  }
+}
+
+// ------------------------------------------------------------------
+// --- Display Task: sole owner of the LCD ---
+// ------------------------------------------------------------------
+void initLcd() {
+  lcd.init();
+  lcd.backlight();
+  lcd.clear();
+  lcd.setCursor(0, 0);
+  lcd.print("AuraLink ESP32 Start");
+}
+
+void displayTask(void*) {
+  esp_task_wdt_add(nullptr);
+  // lcd.init() takes a while (HD44780 power-up delays); it runs here,
+  // overlapped with WiFi association and the DHT warm-up
+  initLcd();
+  bootMark(BOOT_LCD_READY);
+  for (uint8_t slot = 0; slot < TEXT_SLOT_COUNT; slot++) paintTextSlot(slot, false);
+
+  TickType_t nextPage = xTaskGetTickCount() + pdMS_TO_TICKS(displayPageMs);
+  Event event;
+  for (;;) {
+    esp_task_wdt_reset();
+    heartbeatBeat(hbDisplay);
+    if (restartTaken(displayRestart)) {
+      recoverI2CBus();
+      initLcd();
+      // Repaint whatever text is current
+      for (uint8_t slot = 0; slot < TEXT_SLOT_COUNT; slot++) paintTextSlot(slot, false);
+      nextPage = xTaskGetTickCount() + pdMS_TO_TICKS(displayPageMs);
+      Serial.println("Display task restarted");
+    }
+    int32_t untilPage = (int32_t)(nextPage - xTaskGetTickCount());
+    TickType_t wait = untilPage <= 0 ? 0 : min((TickType_t)untilPage, (TickType_t)pdMS_TO_TICKS(SUPERVISOR_INTERVAL_MS));
+    if (eventBusReceive(busDisplay, event, wait)) {
+      if (event.type == EVENT_DISPLAY_CLEAR) {
+        lcd.clear();
+      } else if (event.type == EVENT_DISPLAY_STORE) {
+        textPage[event.store.slot] = 0;
+        paintTextSlot(event.store.slot, false);
+      } else {
+        printLineFmt(event.display.row, "%s", event.display.text);
+      }
+      continue;
+    }
+    if ((int32_t)(nextPage - xTaskGetTickCount()) > 0) continue;
+    nextPage = xTaskGetTickCount() + pdMS_TO_TICKS(displayPageMs);
+    for (uint8_t slot = 0; slot < TEXT_SLOT_COUNT; slot++) paintTextSlot(slot, true);
+  }
+}
+
+// ------------------------------------------------------------------
+// --- LED Task: sole owner of the LED effect engine ---
+// ------------------------------------------------------------------
+void ledsTask(void*) {
+  esp_task_wdt_add(nullptr);
+  Event event;
+  for (;;) {
+    esp_task_wdt_reset();
+    heartbeatBeat(hbLeds);
+    if (restartTaken(ledsRestart)) Serial.println("LED task restarted");  // Effects live in the engine
+    if (!eventBusReceive(busLeds, event, pdMS_TO_TICKS(SUPERVISOR_INTERVAL_MS))) continue;
+    ledEffectSet(event.led.index, event.led.effect);
+  }
+}
+
+void startSensorTask() {
+  xTaskCreatePinnedToCore(sensorTask, "sensor", 4096, nullptr, 2, &sensorTaskHandle, 1);
+}
+
+void startNetworkTask() {
+  xTaskCreatePinnedToCore(networkTask, "network", 8192, nullptr, 1, &networkTaskHandle, 0);
+}
+
+void startDisplayTask() {
+  xTaskCreatePinnedToCore(displayTask, "display", 3072, nullptr, 1, &displayTaskHandle, 1);
+}
+
+void startLedsTask() {
+  xTaskCreatePinnedToCore(ledsTask, "leds", 2048, nullptr, 1, &ledsTaskHandle, 1);
+}
+
+// ------------------------------------------------------------------
+// --- Targeted Subsystem Recovery (called by the supervisor) ---
+// ------------------------------------------------------------------
+void recoverSensor() { requestRestart(sensorRestart, sensorTaskHandle); }
+void recoverNetwork() { requestRestart(networkRestart, networkTaskHandle); }
+void recoverDisplay() { requestRestart(displayRestart, displayTaskHandle); }
+void recoverLeds() { requestRestart(ledsRestart, ledsTaskHandle); }
+
+// ------------------------------------------------------------------
+// --- Warm Start: restore what survived the reset (warm_state.h) ---
+// ------------------------------------------------------------------
+// Runs in setup() before any task starts. Queues a recovery record that
+// goes out first once MQTT connects, on every boot including power-on:
+// "warm":false tells the backend the display came up blank, so it
+// republishes its summary and urgency. Returns true on a warm start.
+bool restoreWarmState() {
+  bool warm = warmStateBegin();
+  esp_reset_reason_t reason = esp_reset_reason();
+  const WarmState& prior = warmStateRestored();
+
+  if (warm) {
+    sampleSeq = prior.sampleSeq;
+    if (prior.haveSample) latestSample = prior.lastSample;
+    for (uint8_t slot = 0; slot < TEXT_SLOT_COUNT; slot++) {
+      // The display task paints these as soon as the LCD is up
+      displayText[slot].set((const uint8_t*)prior.text[slot], strlen(prior.text[slot]));
+    }
+    Serial.printf("Warm start #%lu after %s reset; resuming at seq %lu\n",
+                  (unsigned long)prior.bootCount, resetReasonName(reason), (unsigned long)sampleSeq);
+  }
+
+  char buf[RECOVERY_PAYLOAD_MAX];
+  char lastTemp[12] = "null";
+  if (prior.haveSample) snprintf(lastTemp, sizeof(lastTemp), "%.1f", prior.lastSample.temperature);
+  snprintf(buf, sizeof(buf),
+           "{\"reset_reason\":\"%s\",\"warm\":%s,\"boot_count\":%lu,\"next_seq\":%lu,"
+           "\"last_temperature\":%s,\"wifi_hint\":%s,\"broker_hint\":%s}",
+           resetReasonName(reason), warm ? "true" : "false", (unsigned long)(warm ? prior.bootCount : 0),
+           (unsigned long)sampleSeq, lastTemp,
+           prior.wifiChannel ? "true" : "false", prior.haveLocalBroker ? "true" : "false");
+  outbound.push(TOPIC_DEVICE_RECOVERY, buf, OUTBOUND_DROP_OLDEST);
+  return warm;
+}
+
+// ------------------------------------------------------------------
+// --- Serial Shell: diagnostics and settings for field techs ---
+// ------------------------------------------------------------------
+// Commands run on the loop task and only read state owned by other
+// tasks (the same way the HTTP renderers do), so a slow terminal holds
+// up nothing but the shell itself.
+#ifndef AURALINK_REPLAY
+void applySampleInterval(uint32_t ms) { sampleClockSetPeriod(ms); }
+#endif
+
+const Setting settings[] = {
+#ifndef AURALINK_REPLAY
+  {"sample_ms", "cfg_sample", &sampleIntervalMs, 2000, 3600000, applySampleInterval},   // DHT22: >= 2 s
+#endif
+  {"health_ms", "cfg_health", &healthIntervalMs, 5000, 3600000, nullptr},
+  {"page_ms", "cfg_page", &displayPageMs, 500, 60000, nullptr},
+};
+const size_t settingCount = sizeof(settings) / sizeof(settings[0]);
+
+void loadSettings() {
+  Preferences prefs;
+  prefs.begin("auralink", true);
+  for (size_t i = 0; i < settingCount; i++) {
+    const Setting& s = settings[i];
+    uint32_t v = prefs.getUInt(s.nvsKey, *s.value);
+    if (v >= s.min && v <= s.max) *s.value = v;
+  }
+  prefs.end();
+}
+
+void shellWrite(const char* data, size_t len) { Serial.write((const uint8_t*)data, len); }
+
+void pollShell() {
+  int avail = Serial.available();
+  if (avail <= 0) return;
+  char buf[SHELL_RX_BUDGET];
+  size_t n = Serial.read((uint8_t*)buf, min((size_t)avail, sizeof(buf)));
+  shellFeed(buf, n);
+}
+
+void cmdStats(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "json") == 0) {
+    static char buf[HEALTH_PAYLOAD_MAX];   // Loop task only
+    size_t len = formatHealthJson(buf, sizeof(buf));
+    shellWrite(buf, len);
+    shellPrintf("\r\n");
+    return;
+  }
+  const OutboundStats& out = outbound.stats();
+  shellPrintf("uptime %lu s, heap %lu free (min %lu)\r\n", millis() / 1000,
+              (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap());
+  shellPrintf("samples %lu, buffered %u, dropped %lu\r\n", (unsigned long)sampleSeq,
+              (unsigned)sampleBuffer.size(), (unsigned long)sampleBuffer.dropped());
+  shellPrintf("outbound %u queued, %lu sent, %lu+%lu dropped, %lu coalesced, %lu retries\r\n",
+              (unsigned)outbound.size(), (unsigned long)out.sent, (unsigned long)out.droppedOldest,
+              (unsigned long)out.droppedNewest, (unsigned long)out.coalesced, (unsigned long)out.retries);
+  shellPrintf("batches %lu (%lu samples, %lu bytes)\r\n", (unsigned long)batchStats.batches,
+              (unsigned long)batchStats.samples, (unsigned long)batchStats.bytes);
+  shellPrintf("downlinks %lu decoded, %lu rejected\r\n", (unsigned long)downlinksDecoded,
+              (unsigned long)downlinksRejected);
+#ifndef AURALINK_REPLAY
+  SampleClockStats clock = sampleClockStats();
+  shellPrintf("clock %lu ms, %lu ticks, %lu missed, jitter max %lu us, %lu over budget\r\n",
+              (unsigned long)sampleClockPeriodMs(), (unsigned long)clock.ticks, (unsigned long)clock.missed,
+              (unsigned long)clock.maxJitterUs, (unsigned long)clock.overBudget);
+#endif
+}
+
+void cmdHist(int argc, char** argv) {
+  if (argc < 2) {
+    shellPrintf("%-28s %8s %8s %8s %8s\r\n", "name", "count", "p50", "p99", "max");
+    for (uint8_t i = 0; i < metricsCount(); i++) {
+      const Histogram* h = metricsAt(i);
+      shellPrintf("%-28s %8lu %8lu %8lu %8lu\r\n", h->name(), (unsigned long)h->count(),
+                  (unsigned long)h->percentile(50), (unsigned long)h->percentile(99), (unsigned long)h->max());
+    }
+    return;
+  }
+  const Histogram* h = metricsFind(argv[1]);
+  if (!h) {
+    shellPrintf("no histogram '%s'\r\n", argv[1]);
+    return;
+  }
+  shellPrintf("%s: %s\r\n", h->name(), h->help());
+  shellPrintf("count %lu, mean %lu, max %lu\r\n", (unsigned long)h->count(),
+              (unsigned long)(h->count() ? h->sum() / h->count() : 0), (unsigned long)h->max());
+  for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    if (!h->bucket(i)) continue;
+    if (i == HISTOGRAM_BUCKETS - 1) {
+      shellPrintf("  %10s %10lu\r\n", "+Inf", (unsigned long)h->bucket(i));
+    } else {
+      shellPrintf("  <=%8lu %10lu\r\n", (unsigned long)Histogram::bucketBound(i), (unsigned long)h->bucket(i));
+    }
+  }
+}
+
+void cmdConfig(int argc, char** argv) {
+  bool set = argc >= 4 && strcmp(argv[1], "set") == 0;
+  if (!set && !(argc <= 3 && (argc == 1 || strcmp(argv[1], "get") == 0))) {
+    shellPrintf("usage: config get [key] | config set <key> <value>\r\n");
+    return;
+  }
+  const char* key = argc >= 3 ? argv[2] : nullptr;
+  bool found = false;
+  for (size_t i = 0; i < settingCount; i++) {
+    const Setting& s = settings[i];
+    if (key && strcmp(key, s.name) != 0) continue;
+    found = true;
+    if (set) {
+      char* end;
+      unsigned long v = strtoul(argv[3], &end, 10);
+      if (*end || v < s.min || v > s.max) {
+        shellPrintf("%s must be %lu..%lu\r\n", s.name, (unsigned long)s.min, (unsigned long)s.max);
+        return;
+      }
+      *s.value = v;
+      if (s.apply) s.apply(v);
+      Preferences prefs;
+      prefs.begin("auralink", false);
+      prefs.putUInt(s.nvsKey, v);
+      prefs.end();
+    }
+    shellPrintf("%s = %lu\r\n", s.name, (unsigned long)*s.value);
+  }
+  if (!found) shellPrintf("no setting '%s'\r\n", key);
+}
+
+void cmdSensors(int, char**) {
+  SensorSample s = latestSnapshot();
+  shellPrintf("seq %lu, %lu ms ago\r\n", (unsigned long)s.seq, (unsigned long)(millis() - s.timestampMs));
+  shellPrintf("temperature %.1f C, humidity %.1f %%\r\n", s.temperature, s.humidity);
+  shellPrintf("light %u %%, nox %u %%, pir %u\r\n", s.lightPercent, s.noxPercent, s.pir);
+  shellPrintf("rules %u loaded, alerts 0x%08lx\r\n", activeRules.ruleCount, (unsigned long)lastAlertMask);
+}
+
+void cmdNet(int, char**) {
+#ifdef AURALINK_QEMU
+  shellPrintf("ethernet %s, ip %s\r\n", linkUp() ? "up" : "down", linkLocalIP().toString().c_str());
+#else
+  shellPrintf("wifi %s, ip %s, rssi %d dBm, channel %d\r\n",
+              WiFi.status() == WL_CONNECTED ? "up" : "down", WiFi.localIP().toString().c_str(),
+              WiFi.RSSI(), WiFi.channel());
+#endif
+  BrokerView view = brokerViewSnapshot();
+  shellPrintf("mqtt %s via %s, %lu failovers\r\n", view.active >= 0 ? "connected" : "offline",
+              view.active >= 0 ? view.hosts[view.active] : "-", (unsigned long)brokerFailovers);
+  if (view.haveLocal) shellPrintf("local broker %s, rtt %lu ms\r\n", view.localName, (unsigned long)view.localRttMs);
+  for (uint8_t i = 0; i < view.count; i++) {
+    BrokerHealth h = brokerPoolHealth(i);
+    shellPrintf("  [%u] %-24s %s connect %lu ms, ping %lu ms\r\n", i, view.hosts[i],
+                h.healthy ? "ok  " : "down", (unsigned long)h.connectRttMs, (unsigned long)h.pingRttMs);
+  }
+}
+
+void cmdReplay(int argc, char** argv) {
+#ifdef AURALINK_REPLAY
+  if (argc == 3 && strcmp(argv[1], "speed") == 0) {
+    char* end;
+    unsigned long v = strtoul(argv[2], &end, 10);
+    if (*end || v > 1000) {
+      shellPrintf("speed must be 0 (unpaced) .. 1000\r\n");
+      return;
+    }
+    replaySpeed = v;
+  } else if (argc != 1) {
+    shellPrintf("usage: replay [speed <N>]\r\n");
+    return;
+  }
+  shellPrintf("replay %lu/%lu records at %lux\r\n", (unsigned long)replayPlayed,
+              (unsigned long)replayTotal, (unsigned long)replaySpeed);
+#else
+  (void)argc;
+  (void)argv;
+  shellPrintf("not a replay build (-D AURALINK_REPLAY)\r\n");
+#endif
+}
+
+const ShellCommand shellCommands[] = {
+  {"stats", "[json] - counters, or the full health record", cmdStats},
+  {"hist", "[name] - histogram summary, or one histogram's buckets", cmdHist},
+  {"config", "get [key] | set <key> <value> - runtime settings (saved to NVS)", cmdConfig},
+  {"sensors", "- latest sample and rule alerts", cmdSensors},
+  {"net", "- WiFi, active broker and probe results", cmdNet},
+  {"replay", "[speed <N>] - trace playback progress and speed", cmdReplay},
+};
+
+// ------------------------------------------------------------------
+// --- Setup ---
+// ------------------------------------------------------------------
+void setup() {
+  Serial.begin(115200);
+  Serial.println("\nAuraLink ESP32 Starting...");
+  // Start associating first: it is the slowest part of boot and runs
+  // in the WiFi driver while the rest of setup() proceeds
+  bool warm = restoreWarmState();
+  const WarmState& prior = warmStateRestored();
+#ifdef AURALINK_QEMU
+  Serial.println("Starting emulated Ethernet (OpenETH)");
+  if (!qemuNetBegin()) Serial.println("OpenETH init failed");
+#else
+  Serial.println("Connecting to WiFi network: " + String(ssid));
+  WiFi.mode(WIFI_STA);
+  if (warm && prior.wifiChannel) {
+    // Skip the scan: go straight to the last AP. The hint is cleared until
+    // it works again, so a moved AP costs at most one extra boot.
+    warmStateSaveWifi(0, nullptr);
+    WiFi.begin(ssid, password, prior.wifiChannel, prior.wifiBssid);
   } else {
-    digitalWrite(LED_PIR_PIN, LOW);
-    ledStatePIR = LOW;
-  }
-  
-  // Original LED Logic: Temperature Alert (LED_TEMP_PIN)
-  if (t > 30 || t < 20) {
-    digitalWrite(LED_TEMP_PIN, HIGH);
-    delay(150);
-    digitalWrite(LED_TEMP_PIN, LOW);
-    delay(150);
-  } else {
-    digitalWrite(LED_TEMP_PIN, HIGH);
+    WiFi.begin(ssid, password);
   }
+#endif
 
-  // Original LED Logic: Light Level Indication (LED_LIGHT_PIN)
-  digitalWrite(LED_LIGHT_PIN, (ldrPercent > 50) ? LOW : HIGH);
+  const char* stalled = heartbeatLastRebootCause();
+  if (stalled) Serial.printf("Last reboot forced by stalled subsystem '%s'\n", stalled);
 
-  // IMPORTANT: Set a long delay for data publishing and WDT management
-  delay(3000); 
-}
\ No newline at end of file
+  // Task watchdog: every subsystem task subscribes itself; loop() too
+  esp_task_wdt_init(WDT_TIMEOUT_S, true);
+  esp_task_wdt_add(nullptr);
+  rulesLock = xSemaphoreCreateMutex();
+#ifdef AURALINK_FLICKER
+  adcLock = xSemaphoreCreateMutex();
+#endif
+  textLock = xSemaphoreCreateMutex();
+  dht.begin();
+  Serial.println("DHT sensor initialized");
+
+  // Initialize Pins (LED pins are owned by the LEDC effect engine)
+  pinMode(LDR_DO, INPUT);
+  pinMode(PIR_PIN, INPUT);
+  ledEffectsBegin(ledPins, RULE_LED_COUNT);
+  if (warm && prior.haveUrgency) ledEffectSet(RULE_LED_URGENCY, prior.urgency);
+  Serial.println("All pins initialized");
+
+  loadStoredRules();
+
+  // Explicit I2C pins for ESP32; bounded so a stuck slave cannot hang a task forever.
+  // The LCD itself is initialised by the display task.
+  Wire.begin(I2C_SDA, I2C_SCL);
+  Wire.setTimeOut(I2C_TIMEOUT_MS);
+
+  // MQTT client setup (the broker list is built once WiFi is up)
+#ifdef AURALINK_MQTT_TLS
+  if (!tlsClient.begin(mqttCaPem)) {
+    Serial.println("TLS init failed");
+  }
+#endif
+  client.setCallback(callback);
+  if (!client.setBufferSize(MQTT_BUFFER_SIZE)) {
+    // Allocation failed; PubSubClient keeps its old buffer, so size to that
+    Serial.printf("MQTT buffer of %u bytes unavailable\n", MQTT_BUFFER_SIZE);
+    outbound.setMaxPacket(client.getBufferSize());
+  }
+  client.setSocketTimeout(2); // Bound CONNACK waits; the probes already vetted the broker
+
+  // Local diagnostics: curl http://<device-ip>/metrics
+  metricsRegister(&sampleWorkHist);
+  metricsRegister(&publishHist);
+  metricsRegister(&telemetryBusHist);
+  metricsRegister(&displayBusHist);
+  metricsRegister(&ledsBusHist);
+  loadSettings();
+#ifndef AURALINK_REPLAY
+  sampleClockBegin(sampleIntervalMs);
+#endif
+#ifdef AURALINK_CAPTURE
+  captureBegin();
+  HttpStatusProviders httpProviders = {renderReadingsJson, formatHealthJson, renderMetricsText, captureReadFile};
+#else
+  HttpStatusProviders httpProviders = {renderReadingsJson, formatHealthJson, renderMetricsText, nullptr};
+#endif
+  httpStatusBegin(httpProviders);
+
+  // Bus subscriptions exist before any task can publish
+  busTelemetry = eventBusSubscribe("telemetry",
+                                   EVENT_MASK(EVENT_SAMPLE) | EVENT_MASK(EVENT_RULE_TRIGGER) |
+                                       EVENT_MASK(EVENT_FLICKER),
+                                   &telemetryBusHist);
+  busDisplay = eventBusSubscribe("display",
+                                 EVENT_MASK(EVENT_DISPLAY_TEXT) | EVENT_MASK(EVENT_DISPLAY_CLEAR) |
+                                     EVENT_MASK(EVENT_DISPLAY_STORE),
+                                 &displayBusHist);
+  busLeds = eventBusSubscribe("leds", EVENT_MASK(EVENT_LED), &ledsBusHist);
+
+  // Subsystem tasks, each with a heartbeat and a targeted recovery
+  hbSensor = heartbeatRegister("sensor", SENSOR_STALL_MS, recoverSensor);
+  hbNetwork = heartbeatRegister("network", NETWORK_STALL_MS, recoverNetwork);
+  hbDisplay = heartbeatRegister("display", DISPLAY_STALL_MS, recoverDisplay);
+  hbLeds = heartbeatRegister("leds", LEDS_STALL_MS, recoverLeds);
+  esp_task_wdt_reset();
+  startLedsTask();
+  startDisplayTask();
+  startNetworkTask();
+  startSensorTask();
+#ifdef AURALINK_FLICKER
+  flickerBegin(adcLock);
+#endif
+  bootMark(BOOT_SETUP_DONE);
+  shellBegin(shellCommands, sizeof(shellCommands) / sizeof(shellCommands[0]), shellWrite);
+}
+
+// ------------------------------------------------------------------
+// --- Main Loop: Subsystem Supervisor and Serial Shell ---
+// ------------------------------------------------------------------
+unsigned long lastSuperviseMs = 0;
+
+void loop() {
+  esp_task_wdt_reset();
+  if (millis() - lastSuperviseMs >= SUPERVISOR_INTERVAL_MS) {
+    lastSuperviseMs = millis();
+    heartbeatSupervise();
+  }
+  pollShell();
+  delay(SHELL_POLL_MS);
+}
@@ -0,0 +1,56 @@
+#include "mdns_discovery.h"
+
+#include <ESPmDNS.h>
+#include <WiFi.h>
+
+// ------------------------------------------------------------------
+// --- Helper: best-of-N TCP connect RTT, or UINT32_MAX if unreachable ---
+// ------------------------------------------------------------------
+static uint32_t measureRtt(IPAddress ip, uint16_t port, uint32_t deadlineMs) {
+  uint32_t best = UINT32_MAX;
+  for (uint8_t i = 0; i < MDNS_RTT_SAMPLES && (int32_t)(deadlineMs - millis()) > 0; i++) {
+    WiFiClient c;
+    uint32_t t0 = millis();
+    if (c.connect(ip, port, MDNS_CONNECT_TIMEOUT_MS)) {
+      uint32_t rtt = millis() - t0;
+      if (rtt < best) best = rtt;
+    }
+    c.stop();
+  }
+  return best;
+}
+
+bool discoverLocalBroker(const char* service, DiscoveredBroker& out) {
+  static bool started = false;
+  if (!started) started = MDNS.begin(MDNS_DEVICE_HOSTNAME);
+  if (!started) {
+    Serial.println("mDNS failed to start");
+    return false;
+  }
+
+  int found = MDNS.queryService(service, "tcp");
+  Serial.printf("mDNS: %d _%s._tcp responder(s)\n", found, service);
+
+  bool have = false;
+  uint32_t deadline = millis() + MDNS_RTT_BUDGET_MS;
+  for (int i = 0; i < found && i < MDNS_MAX_CANDIDATES; i++) {
+    if ((int32_t)(deadline - millis()) <= 0) {
+      Serial.printf("mDNS: RTT budget spent; %d responder(s) not measured\n", found - i);
+      break;
+    }
+    IPAddress ip = MDNS.IP(i);
+    uint16_t port = MDNS.port(i);
+    uint32_t rtt = measureRtt(ip, port, deadline);
+    Serial.printf("  %s (%s:%u) rtt=%ld ms\n", MDNS.hostname(i).c_str(),
+                  ip.toString().c_str(), port, rtt == UINT32_MAX ? -1L : (long)rtt);
+    if (rtt == UINT32_MAX || (have && rtt >= out.rttMs)) continue;
+
+    have = true;
+    out.ip = ip;
+    out.port = port;
+    out.rttMs = rtt;
+    snprintf(out.name, sizeof(out.name), "%s", MDNS.hostname(i).c_str());
+    snprintf(out.host, sizeof(out.host), "%s", ip.toString().c_str());
+  }
+  return have;
+}
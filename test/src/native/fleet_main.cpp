@@ -0,0 +1,809 @@
+// ------------------------------------------------------------------
+// --- Native Virtual-Device Fleet ---
+// ------------------------------------------------------------------
+// Simulates many AuraLink devices against a broker and the backend
+// behind it. Each device has its own client ID, its own sensor waveform
+// and a fixed publish period. Its uplinks are built by the firmware's
+// own encoders: wireEncodeSample, or formatSensorPayload with --json.
+// Everything runs on one thread over non-blocking sockets, with a
+// minimal MQTT 3.1.1 client (QoS 0, keep-alive off).
+//
+//   fleet [--host H] [--port P] [--devices N] [--period-ms MS] [--duration S]
+//         [--connect-rate N] [--match quote|summary|urgency|any] [--json]
+//         [--subscribe] [--timeout-ms MS] [--seed N] [--report out.json]
+//
+// An observer connection subscribes to the uplink topic and to the
+// downlink topics. It measures two latencies:
+//   broker delivery  uplink publish -> the same uplink delivered back.
+//                    Sequence numbers are unique per device (device index
+//                    in the high 16 bits), so the pairing is exact.
+//   backend response uplink publish -> the backend's --match downlink.
+//                    The backend answers every device on one shared topic
+//                    and names no device, so responses are paired with
+//                    uplinks in the order they were sent. The distribution
+//                    holds as long as the backend answers every reading.
+//                    Readings it drops end up as timeouts.
+// Throughput is reported as uplinks sent and as messages the broker
+// delivered, both per second. --subscribe makes every device subscribe to
+// the downlink topics as the firmware does, so the broker's fan-out of
+// each response to the whole fleet is part of the load.
+//
+// POSIX hosts only. Raise `ulimit -n` above the device count.
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <math.h>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <pb_decode.h>
+
+#include "downlink_router.h"
+#include "payload.h"
+#include "uplink_topics.h"
+#include "wire.h"
+
+#define FLEET_MAX_DEVICES 65535
+#define FLEET_SEQ_BITS 16
+#define OUTBUF_LIMIT 65536          // Per connection; publishes beyond it are skipped
+#define RECONNECT_DELAY_MS 1000
+
+typedef std::chrono::steady_clock Clock;
+
+static double msSince(Clock::time_point t, Clock::time_point now) {
+  return std::chrono::duration<double, std::milli>(now - t).count();
+}
+
+// --- Options ---
+struct Options {
+  const char* host = "127.0.0.1";
+  const char* port = "1883";
+  unsigned devices = 100;
+  unsigned periodMs = 3000;
+  unsigned durationS = 60;
+  unsigned connectRate = 500;       // New connections per second
+  unsigned timeoutMs = 30000;
+  unsigned seed = 1;
+  const char* match = "quote";
+  const char* report = nullptr;
+  bool json = false;
+  bool subscribe = false;
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+static void onSignal(int) { stopRequested = 1; }
+
+// ------------------------------------------------------------------
+// --- Per-device sensor waveform ---
+// ------------------------------------------------------------------
+// Slow sinusoids around a per-device baseline plus a little noise. Each
+// device gets its own phase and period, so the fleet never moves in
+// lockstep and buckets of similar readings form the way they would in
+// a real building.
+static uint32_t splitmix(uint64_t& x) {
+  uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+struct Waveform {
+  float tempBase, tempAmp, humBase, humAmp, lightBase, lightAmp, noxBase, noxAmp;
+  float periodS, phase;
+  uint64_t rng;
+
+  void init(unsigned seed, unsigned index) {
+    rng = ((uint64_t)seed << 32) | index;
+    tempBase = 18.0f + uniform() * 10.0f;
+    tempAmp = 0.5f + uniform() * 3.5f;
+    humBase = 35.0f + uniform() * 30.0f;
+    humAmp = 2.0f + uniform() * 10.0f;
+    lightBase = 20.0f + uniform() * 60.0f;
+    lightAmp = uniform() * 20.0f;
+    noxBase = 10.0f + uniform() * 50.0f;
+    noxAmp = uniform() * 25.0f;
+    periodS = 60.0f + uniform() * 540.0f;
+    phase = uniform() * 6.2831853f;
+  }
+
+  float uniform() { return splitmix(rng) / 4294967296.0f; }
+
+  static uint8_t percent(float v) { return (uint8_t)(v < 0 ? 0 : v > 100 ? 100 : lroundf(v)); }
+
+  SensorSample sample(float tS, uint32_t seq, uint32_t timestampMs) {
+    float w = 6.2831853f * tS / periodS + phase;
+    SensorSample s;
+    s.seq = seq;
+    s.timestampMs = timestampMs;
+    s.temperature = tempBase + tempAmp * sinf(w) + (uniform() - 0.5f) * 0.2f;
+    s.humidity = humBase + humAmp * cosf(0.5f * w) + (uniform() - 0.5f) * 0.5f;
+    s.lightPercent = percent(lightBase + lightAmp * sinf(w / 3));
+    s.noxPercent = percent(noxBase + noxAmp * sinf(w / 5) + (uniform() - 0.5f) * 2);
+    s.pir = uniform() < 0.05f;
+    return s;
+  }
+};
+
+// ------------------------------------------------------------------
+// --- Minimal MQTT 3.1.1 over a non-blocking socket ---
+// ------------------------------------------------------------------
+enum ConnState : uint8_t { CONN_IDLE, CONN_CONNECTING, CONN_WAIT_CONNACK, CONN_READY };
+
+struct Conn {
+  int fd = -1;
+  ConnState state = CONN_IDLE;
+  std::string out;
+  size_t outPos = 0;
+  std::vector<uint8_t> in;
+  Clock::time_point started;
+
+  size_t pending() const { return out.size() - outPos; }
+};
+
+static void putLength(std::string& p, size_t len) {
+  do {
+    uint8_t b = len % 128;
+    len /= 128;
+    p += (char)(len ? b | 0x80 : b);
+  } while (len);
+}
+
+static void putString(std::string& p, const char* s, size_t len) {
+  p += (char)(len >> 8);
+  p += (char)(len & 0xFF);
+  p.append(s, len);
+}
+
+static void queueConnect(Conn& c, const char* clientId) {
+  std::string body;
+  putString(body, "MQTT", 4);
+  body += (char)4;     // Protocol level 3.1.1
+  body += (char)0x02;  // Clean session
+  body += (char)0;     // Keep-alive 0: the broker never times us out
+  body += (char)0;
+  putString(body, clientId, strlen(clientId));
+  c.out += (char)0x10;
+  putLength(c.out, body.size());
+  c.out += body;
+}
+
+static void queueSubscribe(Conn& c, const char* const* topics, size_t count) {
+  std::string body;
+  body += (char)0;
+  body += (char)1;  // Packet id
+  for (size_t i = 0; i < count; i++) {
+    putString(body, topics[i], strlen(topics[i]));
+    body += (char)0;  // QoS 0
+  }
+  c.out += (char)0x82;
+  putLength(c.out, body.size());
+  c.out += body;
+}
+
+static void queuePublish(Conn& c, const char* topic, const uint8_t* payload, size_t len) {
+  size_t topicLen = strlen(topic);
+  c.out += (char)0x30;
+  putLength(c.out, 2 + topicLen + len);
+  putString(c.out, topic, topicLen);
+  c.out.append((const char*)payload, len);
+}
+
+static void closeConn(Conn& c) {
+  if (c.fd >= 0) close(c.fd);
+  c.fd = -1;
+  c.state = CONN_IDLE;
+  c.out.clear();
+  c.outPos = 0;
+  c.in.clear();
+}
+
+static bool openConn(Conn& c, const addrinfo* addr) {
+  c.fd = socket(addr->ai_family, SOCK_STREAM, 0);
+  if (c.fd < 0) return false;
+  fcntl(c.fd, F_SETFL, fcntl(c.fd, F_GETFL) | O_NONBLOCK);
+  int one = 1;
+  setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  c.started = Clock::now();
+  if (connect(c.fd, addr->ai_addr, addr->ai_addrlen) != 0 && errno != EINPROGRESS) {
+    closeConn(c);
+    return false;
+  }
+  c.state = CONN_CONNECTING;
+  return true;
+}
+
+// False when the connection failed
+static bool flushConn(Conn& c) {
+  while (c.pending()) {
+    ssize_t n = send(c.fd, c.out.data() + c.outPos, c.pending(), MSG_NOSIGNAL);
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+    c.outPos += (size_t)n;
+  }
+  c.out.clear();
+  c.outPos = 0;
+  return true;
+}
+
+// Reads what is available and hands every complete packet to onPacket
+// (first header byte, body). False on EOF, error or a malformed stream.
+template <typename F>
+static bool readConn(Conn& c, F onPacket) {
+  uint8_t buf[4096];
+  for (;;) {
+    ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+    if (n == 0) return false;
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      return false;
+    }
+    c.in.insert(c.in.end(), buf, buf + n);
+  }
+  size_t pos = 0;
+  while (c.in.size() - pos >= 2) {
+    size_t len = 0, shift = 0, i = pos + 1;
+    bool complete = false;
+    while (i < c.in.size() && i - pos <= 4) {
+      len |= (size_t)(c.in[i] & 0x7F) << shift;
+      shift += 7;
+      if (!(c.in[i++] & 0x80)) {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete) {
+      if (i - pos > 4) return false;
+      break;
+    }
+    if (c.in.size() - i < len) break;
+    onPacket(c.in[pos], &c.in[i], len);
+    pos = i + len;
+  }
+  c.in.erase(c.in.begin(), c.in.begin() + pos);
+  return true;
+}
+
+// ------------------------------------------------------------------
+// --- Measurements ---
+// ------------------------------------------------------------------
+struct Latencies {
+  std::vector<float> ms;
+
+  void add(double v) { ms.push_back((float)v); }
+
+  double percentile(double p) {
+    if (ms.empty()) return 0;
+    size_t k = std::min(ms.size() - 1, (size_t)ceil(p / 100.0 * ms.size()) - (p > 0 ? 1 : 0));
+    std::nth_element(ms.begin(), ms.begin() + k, ms.end());
+    return ms[k];
+  }
+
+  double max() const { return ms.empty() ? 0 : *std::max_element(ms.begin(), ms.end()); }
+};
+
+struct Stats {
+  unsigned connected = 0, connectFailures = 0, disconnects = 0;
+  uint64_t uplinks = 0, uplinkBytes = 0, skipped = 0;
+  uint64_t delivered = 0, deliveredBytes = 0, responses = 0, otherDownlinks = 0, timeouts = 0;
+  uint64_t fanoutMessages = 0, fanoutBytes = 0;
+  Latencies connect, delivery, response;
+};
+
+struct Device {
+  Conn conn;
+  char clientId[32];
+  Waveform wave;
+  uint16_t count = 0;
+  Clock::time_point retryAt;
+};
+
+// ------------------------------------------------------------------
+// --- Fleet ---
+// ------------------------------------------------------------------
+class Fleet {
+ public:
+  Fleet(const Options& opt, const addrinfo* addr) : opt_(opt), addr_(addr), devices_(opt.devices) {
+    for (unsigned i = 0; i < opt.devices; i++) {
+      snprintf(devices_[i].clientId, sizeof(devices_[i].clientId), "auralink-sim-%05u", i);
+      devices_[i].wave.init(opt.seed, i);
+      connectQueue_.push_back(i);
+    }
+    matchKind_ = strcmp(opt.match, "summary") == 0   ? WIRE_DOWNLINK_SUMMARY
+                 : strcmp(opt.match, "urgency") == 0 ? WIRE_DOWNLINK_URGENCY
+                                                     : WIRE_DOWNLINK_QUOTE;
+    matchAny_ = strcmp(opt.match, "any") == 0;
+  }
+
+  int run();
+
+ private:
+  void launchConnections(Clock::time_point now);
+  void schedulePublishes(Clock::time_point now);
+  void publish(unsigned i, Clock::time_point now);
+  void onDeviceReady(unsigned i, Clock::time_point now);
+  void onObserverPacket(uint8_t header, const uint8_t* body, size_t len, Clock::time_point now);
+  void onDownlink(bool matches, Clock::time_point now);
+  void expireResponses(Clock::time_point now);
+  bool service(Conn& c, short revents, int index, Clock::time_point now);
+  void dropDevice(unsigned i, Clock::time_point now);
+  void progress(Clock::time_point now);
+  void printReport(double elapsedS);
+  void writeReport(double elapsedS);
+
+  const Options& opt_;
+  const addrinfo* addr_;
+  std::vector<Device> devices_;
+  std::deque<unsigned> connectQueue_;
+  double tokens_ = 0;
+  Clock::time_point refilled_;
+  Conn observer_;
+  bool observerReady_ = false;
+  WireDownlinkKind matchKind_;
+  bool matchAny_;
+
+  // Next publish per device: (due, index), earliest first
+  typedef std::pair<Clock::time_point, unsigned> Due;
+  std::priority_queue<Due, std::vector<Due>, std::greater<Due>> due_;
+  std::unordered_map<uint32_t, Clock::time_point> inFlight_;  // seq -> sent, until delivered
+  std::deque<Clock::time_point> awaiting_;                     // Sent, not yet answered by the backend
+
+  Stats stats_;
+  Stats last_;  // For per-second rates
+  Clock::time_point start_, lastProgress_;
+};
+
+void Fleet::launchConnections(Clock::time_point now) {
+  // Token bucket: at most connectRate new connections per second
+  tokens_ = std::min<double>(opt_.connectRate, tokens_ + msSince(refilled_, now) * opt_.connectRate / 1000.0);
+  refilled_ = now;
+  size_t n = connectQueue_.size();
+  while (n-- && tokens_ >= 1) {
+    unsigned i = connectQueue_.front();
+    connectQueue_.pop_front();
+    Device& d = devices_[i];
+    if (now < d.retryAt) {
+      connectQueue_.push_back(i);
+      continue;
+    }
+    tokens_ -= 1;
+    if (!openConn(d.conn, addr_)) {
+      stats_.connectFailures++;
+      d.retryAt = now + std::chrono::milliseconds(RECONNECT_DELAY_MS);
+      connectQueue_.push_back(i);
+      continue;
+    }
+    queueConnect(d.conn, d.clientId);
+  }
+}
+
+void Fleet::onDeviceReady(unsigned i, Clock::time_point now) {
+  Device& d = devices_[i];
+  d.conn.state = CONN_READY;
+  stats_.connected++;
+  stats_.connect.add(msSince(d.conn.started, now));
+  if (opt_.subscribe) {
+    static const char* const topics[] = {TOPIC_DOWNLINK, TOPIC_DISPLAY_QUOTE, TOPIC_DISPLAY_SUMMARY,
+                                         TOPIC_URGENCY_LED};
+    queueSubscribe(d.conn, topics, 4);
+  }
+  // Spread first publishes over one period so the load is even
+  uint32_t offset = splitmix(d.wave.rng) % opt_.periodMs;
+  due_.push(Due(now + std::chrono::milliseconds(offset), i));
+}
+
+void Fleet::publish(unsigned i, Clock::time_point now) {
+  Device& d = devices_[i];
+  if (d.conn.pending() > OUTBUF_LIMIT) {
+    stats_.skipped++;
+    return;
+  }
+  uint32_t seq = ((uint32_t)i << FLEET_SEQ_BITS) | d.count++;
+  float tS = (float)(msSince(start_, now) / 1000.0);
+  SensorSample s = d.wave.sample(tS, seq, (uint32_t)msSince(start_, now));
+
+  uint8_t buf[SENSOR_PAYLOAD_MAX > WIRE_UPLINK_MAX ? SENSOR_PAYLOAD_MAX : WIRE_UPLINK_MAX];
+  size_t len = opt_.json ? formatSensorPayload(s, (char*)buf, sizeof(buf)) : wireEncodeSample(s, buf, sizeof(buf));
+  if (len == 0) {
+    stats_.skipped++;
+    return;
+  }
+  queuePublish(d.conn, opt_.json ? TOPIC_SENSOR_DATA : TOPIC_UPLINK, buf, len);
+  stats_.uplinks++;
+  stats_.uplinkBytes += len;
+  inFlight_[seq] = now;
+  awaiting_.push_back(now);
+}
+
+void Fleet::schedulePublishes(Clock::time_point now) {
+  while (!due_.empty() && due_.top().first <= now) {
+    Due next = due_.top();
+    due_.pop();
+    Device& d = devices_[next.second];
+    if (d.conn.state != CONN_READY) continue;  // Rescheduled when it reconnects
+    publish(next.second, now);
+    due_.push(Due(next.first + std::chrono::milliseconds(opt_.periodMs), next.second));
+  }
+}
+
+static bool parseSeq(const uint8_t* payload, size_t len, bool json, uint32_t& seq) {
+  if (json) {
+    std::string text((const char*)payload, len);
+    size_t at = text.find("\"seq\":");
+    if (at == std::string::npos) return false;
+    seq = (uint32_t)strtoul(text.c_str() + at + 6, nullptr, 10);
+    return true;
+  }
+  auralink_Uplink msg = auralink_Uplink_init_zero;
+  pb_istream_t stream = pb_istream_from_buffer(payload, len);
+  if (!pb_decode(&stream, auralink_Uplink_fields, &msg) || !msg.has_reading) return false;
+  seq = msg.reading.seq;
+  return true;
+}
+
+void Fleet::onDownlink(bool matches, Clock::time_point now) {
+  if (!matches) {
+    stats_.otherDownlinks++;
+    return;
+  }
+  stats_.responses++;
+  if (awaiting_.empty()) return;  // Answer to a reading from before this run
+  stats_.response.add(msSince(awaiting_.front(), now));
+  awaiting_.pop_front();
+}
+
+void Fleet::onObserverPacket(uint8_t header, const uint8_t* body, size_t len, Clock::time_point now) {
+  if ((header & 0xF0) == 0x20) {
+    if (len < 2 || body[1] != 0) {
+      fprintf(stderr, "observer: broker refused the connection (%d)\n", len >= 2 ? body[1] : -1);
+      stopRequested = 1;
+      return;
+    }
+    static const char* const pb[] = {TOPIC_UPLINK, TOPIC_DOWNLINK, TOPIC_DISPLAY_QUOTE, TOPIC_DISPLAY_SUMMARY,
+                                     TOPIC_URGENCY_LED};
+    static const char* const json[] = {TOPIC_SENSOR_DATA, TOPIC_DOWNLINK, TOPIC_DISPLAY_QUOTE,
+                                       TOPIC_DISPLAY_SUMMARY, TOPIC_URGENCY_LED};
+    queueSubscribe(observer_, opt_.json ? json : pb, 5);
+    return;
+  }
+  if ((header & 0xF0) == 0x90) {
+    observerReady_ = true;
+    return;
+  }
+  if ((header & 0xF0) != 0x30 || len < 2) return;
+
+  // QoS 0 publish: topic, payload (no packet id)
+  size_t topicLen = ((size_t)body[0] << 8) | body[1];
+  if (2 + topicLen > len) return;
+  std::string topic((const char*)body + 2, topicLen);
+  const uint8_t* payload = body + 2 + topicLen;
+  size_t payloadLen = len - 2 - topicLen;
+
+  if (topic == (opt_.json ? TOPIC_SENSOR_DATA : TOPIC_UPLINK)) {
+    stats_.delivered++;
+    stats_.deliveredBytes += len;
+    uint32_t seq;
+    if (!parseSeq(payload, payloadLen, opt_.json, seq)) return;
+    auto it = inFlight_.find(seq);
+    if (it == inFlight_.end()) return;
+    stats_.delivery.add(msSince(it->second, now));
+    inFlight_.erase(it);
+  } else if (topic == TOPIC_DOWNLINK) {
+    WireDownlink msg;
+    char err[48];
+    if (!wireDecodeDownlink(payload, payloadLen, msg, err, sizeof(err))) {
+      stats_.otherDownlinks++;
+      return;
+    }
+    // Chunked texts answer once, on their last piece
+    if (msg.chunked && msg.chunk.index + 1 != msg.chunk.count) return;
+    onDownlink(matchAny_ || msg.kind == matchKind_, now);
+  } else {
+    // Text downlinks (backend AURALINK_DOWNLINK_FORMAT=text)
+    WireDownlinkKind kind = topic == TOPIC_DISPLAY_QUOTE     ? WIRE_DOWNLINK_QUOTE
+                            : topic == TOPIC_DISPLAY_SUMMARY ? WIRE_DOWNLINK_SUMMARY
+                                                             : WIRE_DOWNLINK_URGENCY;
+    onDownlink(matchAny_ || kind == matchKind_, now);
+  }
+}
+
+void Fleet::expireResponses(Clock::time_point now) {
+  while (!awaiting_.empty() && msSince(awaiting_.front(), now) > opt_.timeoutMs) {
+    awaiting_.pop_front();
+    stats_.timeouts++;
+  }
+}
+
+void Fleet::dropDevice(unsigned i, Clock::time_point now) {
+  Device& d = devices_[i];
+  if (d.conn.state == CONN_READY) {
+    stats_.disconnects++;
+    stats_.connected--;
+  } else {
+    stats_.connectFailures++;
+  }
+  closeConn(d.conn);
+  d.retryAt = now + std::chrono::milliseconds(RECONNECT_DELAY_MS);
+  connectQueue_.push_back(i);
+}
+
+// Handles poll events for one connection; index -1 is the observer.
+// False when the connection has to be dropped.
+bool Fleet::service(Conn& c, short revents, int index, Clock::time_point now) {
+  if (revents & (POLLERR | POLLNVAL)) return false;
+  if (c.state == CONN_CONNECTING && (revents & (POLLOUT | POLLHUP))) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err) return false;
+    c.state = CONN_WAIT_CONNACK;
+  }
+  if (revents & (POLLIN | POLLHUP)) {
+    bool ok = readConn(c, [&](uint8_t header, const uint8_t* body, size_t len) {
+      if (index < 0) {
+        onObserverPacket(header, body, len, now);
+      } else if ((header & 0xF0) == 0x20 && c.state == CONN_WAIT_CONNACK) {
+        if (len >= 2 && body[1] == 0) onDeviceReady((unsigned)index, now);
+      } else if ((header & 0xF0) == 0x30) {
+        stats_.fanoutMessages++;
+        stats_.fanoutBytes += len;
+      }
+    });
+    if (!ok) return false;
+  }
+  return c.state == CONN_CONNECTING || flushConn(c);
+}
+
+void Fleet::progress(Clock::time_point now) {
+  // Uplinks the observer never saw (dropped by the broker or the observer)
+  for (auto it = inFlight_.begin(); it != inFlight_.end();) {
+    it = msSince(it->second, now) > opt_.timeoutMs ? inFlight_.erase(it) : std::next(it);
+  }
+  double s = msSince(lastProgress_, now) / 1000.0;
+  fprintf(stderr, "%6.0fs  connected %u/%u  uplinks %.0f/s  delivered %.0f/s  responses %.0f/s  awaiting %zu\n",
+          msSince(start_, now) / 1000.0, stats_.connected, opt_.devices, (stats_.uplinks - last_.uplinks) / s,
+          (stats_.delivered - last_.delivered) / s, (stats_.responses - last_.responses) / s, awaiting_.size());
+  last_.uplinks = stats_.uplinks;
+  last_.delivered = stats_.delivered;
+  last_.responses = stats_.responses;
+  lastProgress_ = now;
+}
+
+int Fleet::run() {
+  start_ = lastProgress_ = refilled_ = Clock::now();
+  if (!openConn(observer_, addr_)) {
+    perror("observer");
+    return 1;
+  }
+  queueConnect(observer_, "auralink-sim-observer");
+
+  // Devices start once the observer is subscribed, so no uplink goes unseen
+  auto stopAt = Clock::time_point::max();
+  Clock::time_point drainUntil = Clock::time_point::max();
+  std::vector<pollfd> fds;
+  std::vector<int> owners;
+  while (true) {
+    auto now = Clock::now();
+    if (observerReady_ && stopAt == Clock::time_point::max()) {
+      start_ = now;
+      stopAt = now + std::chrono::seconds(opt_.durationS);
+    }
+    bool publishing = observerReady_ && now < stopAt && !stopRequested;
+    if (publishing) {
+      launchConnections(now);
+      schedulePublishes(now);
+    } else if (drainUntil == Clock::time_point::max() && (now >= stopAt || stopRequested)) {
+      drainUntil = now + std::chrono::milliseconds(stopRequested ? 0 : opt_.timeoutMs);
+    }
+    expireResponses(now);
+    if (now >= drainUntil || (drainUntil != Clock::time_point::max() && awaiting_.empty())) break;
+    if (msSince(lastProgress_, now) >= 1000) progress(now);
+
+    fds.clear();
+    owners.clear();
+    auto watch = [&](const Conn& c, int owner) {
+      if (c.fd < 0) return;
+      short events = POLLIN;
+      if (c.state == CONN_CONNECTING || c.pending()) events |= POLLOUT;
+      fds.push_back(pollfd{c.fd, events, 0});
+      owners.push_back(owner);
+    };
+    watch(observer_, -1);
+    for (unsigned i = 0; i < devices_.size(); i++) watch(devices_[i].conn, (int)i);
+
+    int timeout = 100;
+    if (publishing && !due_.empty()) {
+      double wait = msSince(now, due_.top().first);
+      timeout = (int)std::max(0.0, std::min(wait, 100.0));
+    }
+    if (!connectQueue_.empty() && publishing) timeout = std::min(timeout, 10);
+    if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) {
+      perror("poll");
+      return 1;
+    }
+    now = Clock::now();
+    for (size_t k = 0; k < fds.size(); k++) {
+      if (!fds[k].revents) continue;
+      if (owners[k] < 0) {
+        if (!service(observer_, fds[k].revents, -1, now)) {
+          fprintf(stderr, "observer: connection to the broker lost\n");
+          return 1;
+        }
+      } else if (!service(devices_[owners[k]].conn, fds[k].revents, owners[k], now)) {
+        dropDevice((unsigned)owners[k], now);
+      }
+    }
+    // Flush what the handlers queued (publishes, subscriptions)
+    for (unsigned i = 0; i < devices_.size(); i++) {
+      Conn& c = devices_[i].conn;
+      if (c.state != CONN_CONNECTING && c.fd >= 0 && c.pending() && !flushConn(c)) dropDevice(i, now);
+    }
+    if (observer_.pending() && !flushConn(observer_)) {
+      fprintf(stderr, "observer: connection to the broker lost\n");
+      return 1;
+    }
+  }
+
+  double elapsedS = std::min(msSince(start_, Clock::now()), opt_.durationS * 1000.0) / 1000.0;
+  for (Device& d : devices_) {
+    if (d.conn.state == CONN_READY) send(d.conn.fd, "\xE0\x00", 2, MSG_NOSIGNAL);  // DISCONNECT
+    closeConn(d.conn);
+  }
+  closeConn(observer_);
+  printReport(elapsedS);
+  if (opt_.report) writeReport(elapsedS);
+  return stats_.uplinks ? 0 : 1;
+}
+
+void Fleet::printReport(double elapsedS) {
+  double s = elapsedS > 0 ? elapsedS : 1;
+  printf("devices    %u/%u connected, %u connect failures, %u disconnects\n", stats_.connected, opt_.devices,
+         stats_.connectFailures, stats_.disconnects);
+  printf("connect    p50 %.1f  p90 %.1f  p99 %.1f  max %.1f ms\n", stats_.connect.percentile(50),
+         stats_.connect.percentile(90), stats_.connect.percentile(99), stats_.connect.max());
+  printf("uplinks    %llu sent in %.1f s: %.1f msg/s, %.1f KB/s (%s), %llu skipped on backpressure\n",
+         (unsigned long long)stats_.uplinks, elapsedS, stats_.uplinks / s, stats_.uplinkBytes / s / 1024,
+         opt_.json ? "json" : "protobuf", (unsigned long long)stats_.skipped);
+  printf("broker     %llu delivered: %.1f msg/s, %.1f KB/s\n", (unsigned long long)stats_.delivered,
+         stats_.delivered / s, stats_.deliveredBytes / s / 1024);
+  printf("delivery   p50 %.2f  p90 %.2f  p99 %.2f  max %.2f ms\n", stats_.delivery.percentile(50),
+         stats_.delivery.percentile(90), stats_.delivery.percentile(99), stats_.delivery.max());
+  printf("backend    %llu %s responses, %llu other downlinks, %llu timed out (> %u ms)\n",
+         (unsigned long long)stats_.responses, opt_.match, (unsigned long long)stats_.otherDownlinks,
+         (unsigned long long)stats_.timeouts, opt_.timeoutMs);
+  printf("response   p50 %.1f  p90 %.1f  p99 %.1f  max %.1f ms\n", stats_.response.percentile(50),
+         stats_.response.percentile(90), stats_.response.percentile(99), stats_.response.max());
+  if (opt_.subscribe) {
+    printf("fan-out    %llu downlinks to devices: %.1f msg/s, %.1f KB/s\n", (unsigned long long)stats_.fanoutMessages,
+           stats_.fanoutMessages / s, stats_.fanoutBytes / s / 1024);
+  }
+}
+
+void Fleet::writeReport(double elapsedS) {
+  FILE* f = fopen(opt_.report, "w");
+  if (!f) {
+    perror(opt_.report);
+    return;
+  }
+  double s = elapsedS > 0 ? elapsedS : 1;
+  auto latency = [&](const char* name, Latencies& l, const char* tail) {
+    fprintf(f, "  \"%s\": {\"n\": %zu, \"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f}%s\n",
+            name, l.ms.size(), l.percentile(50), l.percentile(90), l.percentile(99), l.max(), tail);
+  };
+  fprintf(f, "{\n  \"devices\": %u, \"period_ms\": %u, \"duration_s\": %.1f, \"format\": \"%s\", \"match\": \"%s\",\n",
+          opt_.devices, opt_.periodMs, elapsedS, opt_.json ? "json" : "protobuf", opt_.match);
+  fprintf(f, "  \"connected\": %u, \"connect_failures\": %u, \"disconnects\": %u,\n", stats_.connected,
+          stats_.connectFailures, stats_.disconnects);
+  fprintf(f, "  \"uplinks\": %llu, \"uplinks_per_s\": %.2f, \"uplink_bytes_per_s\": %.1f, \"skipped\": %llu,\n",
+          (unsigned long long)stats_.uplinks, stats_.uplinks / s, stats_.uplinkBytes / s,
+          (unsigned long long)stats_.skipped);
+  fprintf(f, "  \"delivered\": %llu, \"delivered_per_s\": %.2f, \"delivered_bytes_per_s\": %.1f,\n",
+          (unsigned long long)stats_.delivered, stats_.delivered / s, stats_.deliveredBytes / s);
+  fprintf(f, "  \"responses\": %llu, \"other_downlinks\": %llu, \"timeouts\": %llu, \"fanout_per_s\": %.2f,\n",
+          (unsigned long long)stats_.responses, (unsigned long long)stats_.otherDownlinks,
+          (unsigned long long)stats_.timeouts, stats_.fanoutMessages / s);
+  latency("connect", stats_.connect, ",");
+  latency("delivery", stats_.delivery, ",");
+  latency("response", stats_.response, "");
+  fprintf(f, "}\n");
+  fclose(f);
+}
+
+// ------------------------------------------------------------------
+// --- Entry point ---
+// ------------------------------------------------------------------
+static void usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s [--host H] [--port P] [--devices N] [--period-ms MS] [--duration S]\n"
+          "          [--connect-rate N] [--match quote|summary|urgency|any] [--json] [--subscribe]\n"
+          "          [--timeout-ms MS] [--seed N] [--report out.json]\n",
+          argv0);
+}
+
+int main(int argc, char** argv) {
+  Options opt;
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (strcmp(a, "--host") == 0 && hasValue) {
+      opt.host = argv[++i];
+    } else if (strcmp(a, "--port") == 0 && hasValue) {
+      opt.port = argv[++i];
+    } else if (strcmp(a, "--devices") == 0 && hasValue) {
+      opt.devices = (unsigned)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(a, "--period-ms") == 0 && hasValue) {
+      opt.periodMs = (unsigned)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(a, "--duration") == 0 && hasValue) {
+      opt.durationS = (unsigned)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(a, "--connect-rate") == 0 && hasValue) {
+      opt.connectRate = (unsigned)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(a, "--timeout-ms") == 0 && hasValue) {
+      opt.timeoutMs = (unsigned)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(a, "--seed") == 0 && hasValue) {
+      opt.seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(a, "--match") == 0 && hasValue) {
+      opt.match = argv[++i];
+    } else if (strcmp(a, "--report") == 0 && hasValue) {
+      opt.report = argv[++i];
+    } else if (strcmp(a, "--json") == 0) {
+      opt.json = true;
+    } else if (strcmp(a, "--subscribe") == 0) {
+      opt.subscribe = true;
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  static const char* const kinds[] = {"quote", "summary", "urgency", "any"};
+  bool knownMatch = false;
+  for (const char* k : kinds) knownMatch |= strcmp(opt.match, k) == 0;
+  if (!knownMatch || opt.devices == 0 || opt.devices > FLEET_MAX_DEVICES || opt.periodMs == 0 ||
+      opt.connectRate == 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  // One descriptor per device plus the observer
+  rlimit lim;
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < opt.devices + 16) {
+    lim.rlim_cur = std::min<rlim_t>(lim.rlim_max, opt.devices + 16);
+    setrlimit(RLIMIT_NOFILE, &lim);
+    if (lim.rlim_cur < opt.devices + 16) {
+      fprintf(stderr, "open file limit %llu is below %u devices; raise ulimit -n\n",
+              (unsigned long long)lim.rlim_cur, opt.devices);
+      return 1;
+    }
+  }
+
+  addrinfo hints = addrinfo();
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addr = nullptr;
+  int rc = getaddrinfo(opt.host, opt.port, &hints, &addr);
+  if (rc != 0) {
+    fprintf(stderr, "%s: %s\n", opt.host, gai_strerror(rc));
+    return 1;
+  }
+  signal(SIGINT, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  fprintf(stderr, "fleet: %u devices every %u ms for %u s against %s:%s\n", opt.devices, opt.periodMs, opt.durationS,
+          opt.host, opt.port);
+  Fleet fleet(opt, addr);
+  int result = fleet.run();
+  freeaddrinfo(addr);
+  return result;
+}
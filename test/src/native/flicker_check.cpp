@@ -0,0 +1,105 @@
+// ------------------------------------------------------------------
+// --- Native Flicker Reference Check ---
+// ------------------------------------------------------------------
+// Runs the scalar flicker pipeline (flicker.h) against signals with known
+// answers, and its FFT against a direct DFT. The firmware's ESP-DSP path
+// shares every stage but the window multiply and the FFT, so a pass here
+// plus matching on-target output for the same block pins both down.
+//
+//   flicker_check            exits non-zero on the first failure
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "flicker.h"
+#include "readings.h"
+
+#define N 1024
+#define RATE_HZ 2000.0f
+
+static uint16_t raw[N];
+static float cplx[2 * N];
+static float window[N];
+static int failures = 0;
+
+static void check(const char* name, bool ok, const char* fmt, double a, double b) {
+  printf("%-34s %s  ", name, ok ? "ok  " : "FAIL");
+  printf(fmt, a, b);
+  printf("\n");
+  if (!ok) failures++;
+}
+
+// Light level -> raw LDR count (the sensor reads low when bright)
+static uint16_t toRaw(double light) {
+  long v = lround(ADC_FULL_SCALE - light);
+  return (uint16_t)(v < 0 ? 0 : v > ADC_FULL_SCALE ? ADC_FULL_SCALE : v);
+}
+
+static FlickerResult analyze() {
+  FlickerResult r;
+  flickerAnalyzeScalar(raw, N, RATE_HZ, cplx, window, r);
+  return r;
+}
+
+static void sineFlicker(double hz, double depth) {
+  for (int i = 0; i < N; i++) raw[i] = toRaw(2000 * (1 + depth * sin(2 * M_PI * hz * i / RATE_HZ)));
+  FlickerResult r = analyze();
+  char name[48];
+  snprintf(name, sizeof(name), "sine %.0f Hz depth %.2f: freq", hz, depth);
+  check(name, fabs(r.dominantHz - hz) < 1.0, "%.2f Hz (want %.2f)", r.dominantHz, hz);
+  // Flicker index of a sine is depth / pi; percent flicker is depth * 100
+  snprintf(name, sizeof(name), "sine %.0f Hz depth %.2f: index", hz, depth);
+  check(name, fabs(r.flickerIndex - depth / M_PI) < 0.01, "%.4f (want %.4f)", r.flickerIndex, depth / M_PI);
+  snprintf(name, sizeof(name), "sine %.0f Hz depth %.2f: percent", hz, depth);
+  check(name, fabs(r.percentFlicker - depth * 100) < 1.0, "%.2f (want %.2f)", r.percentFlicker, depth * 100);
+}
+
+static void rectifiedMains(double mainsHz) {
+  // Incandescent-like: light follows |sin| of the mains, flicker at 2x
+  for (int i = 0; i < N; i++) raw[i] = toRaw(1500 + 1000 * fabs(sin(2 * M_PI * mainsHz * i / RATE_HZ)));
+  FlickerResult r = analyze();
+  char name[48];
+  snprintf(name, sizeof(name), "rectified %.0f Hz mains", mainsHz);
+  check(name, fabs(r.dominantHz - 2 * mainsHz) < 1.0, "%.2f Hz (want %.2f)", r.dominantHz, 2 * mainsHz);
+}
+
+static void steadyLight() {
+  srand(1);
+  for (int i = 0; i < N; i++) raw[i] = toRaw(2500 + (rand() % 3) - 1);
+  FlickerResult r = analyze();
+  check("steady light + 1 LSB noise", r.dominantHz == 0 && r.flickerIndex < 0.001, "%.2f Hz, index %.5f",
+        r.dominantHz, r.flickerIndex);
+}
+
+static void fftAgainstDft() {
+  static float ref[2 * N];
+  srand(2);
+  for (int i = 0; i < 2 * N; i++) cplx[i] = ref[i] = (float)(rand() % 2001 - 1000);
+  flickerFftScalar(cplx, N);
+  double worst = 0, scale = 0;
+  for (int k = 0; k < N; k++) {
+    double re = 0, im = 0;
+    for (int t = 0; t < N; t++) {
+      double a = -2 * M_PI * (double)k * t / N;
+      re += ref[2 * t] * cos(a) - ref[2 * t + 1] * sin(a);
+      im += ref[2 * t] * sin(a) + ref[2 * t + 1] * cos(a);
+    }
+    worst = fmax(worst, hypot(cplx[2 * k] - re, cplx[2 * k + 1] - im));
+    scale = fmax(scale, hypot(re, im));
+  }
+  check("fft vs direct dft", worst / scale < 1e-4, "rel err %.2e (limit %.0e)", worst / scale, 1e-4);
+}
+
+int main() {
+  flickerHannWindow(window, N);
+  fftAgainstDft();
+  sineFlicker(100, 0.3);
+  sineFlicker(120, 0.05);
+  sineFlicker(437, 0.8);
+  rectifiedMains(50);
+  rectifiedMains(60);
+  steadyLight();
+  printf("%s\n", failures ? "FAILED" : "all passed");
+  return failures ? 1 : 0;
+}
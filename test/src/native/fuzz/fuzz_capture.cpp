@@ -0,0 +1,11 @@
+// ------------------------------------------------------------------
+// --- Fuzz: capture commands ---
+// ------------------------------------------------------------------
+// captureParseCommand on auralink/device/capture payloads; accepted
+// requests must be in range.
+
+#include "fuzz_support.h"
+
+FUZZ_TARGET("capture") {
+  fuzzApplyCapture(data, size);
+}
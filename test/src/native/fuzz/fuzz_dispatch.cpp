@@ -0,0 +1,38 @@
+// ------------------------------------------------------------------
+// --- Fuzz: topic dispatcher ---
+// ------------------------------------------------------------------
+// Whole MQTT messages through downlinkRoute and on to every parser, the
+// way callback() handles them. The topic is not restricted to ones the
+// device subscribes to. Input: one or more records of
+//   topic | NUL | u16 LE payload length | payload
+// (a record without the NUL is all topic; lengths are clamped to what is
+// left). tools/fuzz_corpus.py writes recorded traffic in this format.
+
+#include <string.h>
+
+#include "fuzz_support.h"
+
+FUZZ_TARGET("dispatch") {
+  TextStore stores[TEXT_SLOT_COUNT];
+  size_t pos = 0;
+  while (pos < size) {
+    const uint8_t* end = (const uint8_t*)memchr(data + pos, '\0', size - pos);
+    size_t topicLen = end ? (size_t)(end - (data + pos)) : size - pos;
+    char topic[DOWNLINK_TOPIC_MAX];
+    size_t copy = topicLen < DOWNLINK_TOPIC_MAX ? topicLen : DOWNLINK_TOPIC_MAX - 1;
+    memcpy(topic, data + pos, copy);
+    topic[copy] = '\0';
+    pos += topicLen + (end ? 1 : 0);
+
+    size_t len = 0;
+    if (size - pos >= 2) {
+      len = data[pos] | (data[pos + 1] << 8);
+      pos += 2;
+    }
+    if (len > size - pos) len = size - pos;
+    // Over-long topics are classified on their prefix only, which can
+    // never match a downlink topic exactly; the firmware sees them whole
+    if (topicLen < DOWNLINK_TOPIC_MAX) fuzzDispatch(stores, topic, data + pos, len);
+    pos += len;
+  }
+}
@@ -0,0 +1,13 @@
+// ------------------------------------------------------------------
+// --- Fuzz: rules programs ---
+// ------------------------------------------------------------------
+// Rule text (rulesCompile) or, behind RULES_BINARY_MAGIC, a compiled
+// program (rulesLoadBinary). This is what arrives on auralink/rules/set
+// and in protobuf rules downlinks. Accepted programs are saved, reloaded
+// and evaluated.
+
+#include "fuzz_support.h"
+
+FUZZ_TARGET("rules") {
+  fuzzApplyRules(data, size);
+}
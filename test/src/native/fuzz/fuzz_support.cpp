@@ -0,0 +1,247 @@
+#include "fuzz_support.h"
+
+#include <chrono>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <vector>
+
+#include "histogram.h"
+#include "rules.h"
+#include "wire.h"
+
+// ------------------------------------------------------------------
+// --- Per-input execution time ---
+// ------------------------------------------------------------------
+static Histogram execTime("fuzz_exec_us", "Execution time per input");
+static const char* targetName = "fuzz";
+static uint32_t slowUs = 0;
+static bool slowAbort = true;
+static uint32_t runs = 0;
+static uint32_t slowestUs = 0;
+static uint32_t slowestHash = 0;
+static size_t slowestSize = 0;
+
+static uint32_t fnv1a(const uint8_t* data, size_t size) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < size; i++) h = (h ^ data[i]) * 16777619u;
+  return h;
+}
+
+static void printTimes() {
+  fprintf(stderr, "%s: %u inputs, exec time p50 <= %u us, p99 <= %u us, max %u us (input %08x, %zu bytes)\n",
+          targetName, (unsigned)execTime.count(), (unsigned)execTime.percentile(50),
+          (unsigned)execTime.percentile(99), (unsigned)slowestUs, (unsigned)slowestHash, slowestSize);
+}
+
+static void saveSlow(const uint8_t* data, size_t size, uint32_t us, uint32_t hash) {
+  const char* dir = getenv("AURALINK_FUZZ_ARTIFACTS");
+  char path[512];
+  snprintf(path, sizeof(path), "%s/slow-%s-%08x", dir && *dir ? dir : ".", targetName, (unsigned)hash);
+  FILE* f = fopen(path, "wb");
+  if (f) {
+    fwrite(data, 1, size, f);
+    fclose(f);
+  }
+  fprintf(stderr, "%s: SLOW INPUT %u us > %u us budget (%zu bytes), saved to %s\n", targetName, (unsigned)us,
+          (unsigned)slowUs, size, f ? path : "(unwritable)");
+}
+
+void fuzzTimed(const char* target, FuzzBody body, const uint8_t* data, size_t size) {
+  if (slowUs == 0) {
+    targetName = target;
+    const char* budget = getenv("AURALINK_FUZZ_SLOW_US");
+    slowUs = budget && *budget ? (uint32_t)strtoul(budget, nullptr, 10) : FUZZ_SLOW_US_DEFAULT;
+    const char* abortEnv = getenv("AURALINK_FUZZ_SLOW_ABORT");
+    slowAbort = !(abortEnv && strcmp(abortEnv, "0") == 0);
+    atexit(printTimes);
+  }
+  auto start = std::chrono::steady_clock::now();
+  body(data, size);
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  uint32_t elapsed = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+
+  if (++runs <= FUZZ_WARMUP_RUNS) return;
+  execTime.record(elapsed);
+  if (elapsed > slowestUs || execTime.count() == 1) {
+    slowestUs = elapsed;
+    slowestHash = fnv1a(data, size);
+    slowestSize = size;
+  }
+  if (elapsed > slowUs) {
+    saveSlow(data, size, elapsed, fnv1a(data, size));
+    if (slowAbort) abort();
+  }
+}
+
+// ------------------------------------------------------------------
+// --- Firmware handler equivalents ---
+// ------------------------------------------------------------------
+bool fuzzApplyRules(const uint8_t* data, size_t len) {
+  const size_t magic = sizeof(RULES_BINARY_MAGIC) - 1;
+  static RuleProgram staged;
+  char err[64];
+  bool ok = (len >= magic && memcmp(data, RULES_BINARY_MAGIC, magic) == 0)
+                ? rulesLoadBinary(data, len, staged, err, sizeof(err))
+                : rulesCompile((const char*)data, len, staged, err, sizeof(err));
+  if (!ok) {
+    FUZZ_CHECK(memchr(err, '\0', sizeof(err)) != nullptr);
+    return false;
+  }
+  FUZZ_CHECK(staged.len <= RULES_MAX_CODE && staged.ruleCount <= RULES_MAX_RULES);
+
+  // What gets persisted must load back to the same program
+  uint8_t bin[RULES_MAX_CODE + 8];
+  size_t binLen = rulesSaveBinary(staged, bin, sizeof(bin));
+  FUZZ_CHECK(binLen > 0);
+  static RuleProgram reloaded;
+  FUZZ_CHECK(rulesLoadBinary(bin, binLen, reloaded, err, sizeof(err)));
+  FUZZ_CHECK(reloaded.len == staged.len && reloaded.ruleCount == staged.ruleCount &&
+             memcmp(reloaded.code, staged.code, staged.len) == 0);
+
+  // An accepted program must evaluate in bounds for any reading
+  static const float probes[][RULE_VAR_COUNT] = {
+      {22.5f, 45.0f, 50.0f, 30.0f, 0.0f}, {-40.0f, 0.0f, 0.0f, 0.0f, 1.0f}, {80.0f, 100.0f, 100.0f, 100.0f, 1.0f}};
+  RuleState state = RuleState();
+  for (const float* values : probes) {
+    RuleInputs in;
+    memcpy(in.values, values, sizeof(in.values));
+    RuleOutputs out;
+    rulesEvaluate(staged, in, state, out);
+    for (uint8_t i = 0; i < RULE_LED_COUNT; i++) FUZZ_CHECK(out.leds[i].mode <= RULE_LED_PULSE);
+  }
+  return true;
+}
+
+void fuzzApplyText(TextStore& store, TextTopicKind kind, const ChunkHeader& header, const uint8_t* data, size_t len) {
+  if (kind == TEXT_TOPIC_WHOLE) {
+    store.set(data, len);
+  } else {
+    store.appendChunk(header, data, len);
+  }
+  // Bounded, terminated, and only characters the LCD can show
+  FUZZ_CHECK(store.length() <= TEXT_STORE_CAPACITY);
+  FUZZ_CHECK(strlen(store.text()) == store.length());
+  for (size_t i = 0; i < store.length(); i++) {
+    FUZZ_CHECK(store.text()[i] >= 0x20 && store.text()[i] < 0x7F);
+  }
+}
+
+bool fuzzApplyCapture(const uint8_t* data, size_t len) {
+  CaptureRequest req;
+  char err[64];
+  if (!captureParseCommand((const char*)data, len, req, err, sizeof(err))) return false;
+  FUZZ_CHECK(req.action == CAPTURE_START || req.action == CAPTURE_STOP);
+  if (req.action == CAPTURE_START) {
+    FUZZ_CHECK(req.rateHz > 0 && req.rateHz <= CAPTURE_MAX_RATE_HZ);
+    FUZZ_CHECK(req.seconds > 0 && req.seconds <= CAPTURE_MAX_SECS);
+    if (req.sink != CAPTURE_SINK_FILE) FUZZ_CHECK(memchr(req.host, '\0', sizeof(req.host)) && req.port > 0);
+  }
+  return true;
+}
+
+bool fuzzApplyDownlink(TextStore* stores, const uint8_t* data, size_t len) {
+  WireDownlink msg;
+  char err[48];
+  if (!wireDecodeDownlink(data, len, msg, err, sizeof(err))) {
+    FUZZ_CHECK(memchr(err, '\0', sizeof(err)) != nullptr);
+    return false;
+  }
+  // Spans must stay inside the payload they were decoded from
+  FUZZ_CHECK(msg.len == 0 || (msg.data >= data && msg.data + msg.len <= data + len));
+  switch (msg.kind) {
+    case WIRE_DOWNLINK_QUOTE:
+    case WIRE_DOWNLINK_SUMMARY:
+      fuzzApplyText(stores[msg.kind == WIRE_DOWNLINK_QUOTE ? TEXT_SLOT_QUOTE : TEXT_SLOT_SUMMARY],
+                    msg.chunked ? TEXT_TOPIC_CHUNK : TEXT_TOPIC_WHOLE, msg.chunk, msg.data, msg.len);
+      break;
+    case WIRE_DOWNLINK_URGENCY:
+      FUZZ_CHECK(msg.urgency <= auralink_UrgencyLevel_URGENCY_HIGH);
+      break;
+    case WIRE_DOWNLINK_RULES:
+      fuzzApplyRules(msg.data, msg.len);
+      break;
+    case WIRE_DOWNLINK_CAPTURE:
+      fuzzApplyCapture(msg.data, msg.len);
+      break;
+  }
+  return true;
+}
+
+void fuzzDispatch(TextStore* stores, const char* topic, const uint8_t* payload, size_t len) {
+  DownlinkTarget target;
+  switch (downlinkRoute(topic, target)) {
+    case DOWNLINK_ROUTE_PROTOBUF:
+      fuzzApplyDownlink(stores, payload, len);
+      break;
+    case DOWNLINK_ROUTE_RULES:
+      fuzzApplyRules(payload, len);
+      break;
+    case DOWNLINK_ROUTE_CAPTURE:
+      fuzzApplyCapture(payload, len);
+      break;
+    case DOWNLINK_ROUTE_TEXT:
+      FUZZ_CHECK(target.textSlot < TEXT_SLOT_COUNT);
+      FUZZ_CHECK(target.textKind == TEXT_TOPIC_WHOLE ||
+                 (target.chunk.count > 0 && target.chunk.index < target.chunk.count));
+      fuzzApplyText(stores[target.textSlot], target.textKind, target.chunk, payload, len);
+      break;
+    case DOWNLINK_ROUTE_URGENCY:
+      FUZZ_CHECK(urgencyFromText(payload, len) <= auralink_UrgencyLevel_URGENCY_HIGH);
+      break;
+    case DOWNLINK_ROUTE_NONE:
+      break;
+  }
+}
+
+// ------------------------------------------------------------------
+// --- Standalone replay (no libFuzzer) ---
+// ------------------------------------------------------------------
+#ifdef AURALINK_FUZZ_STANDALONE
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static bool replayFile(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  // A copy of exactly the input size, so ASan catches reads past the end
+  std::vector<uint8_t> exact(data);
+  LLVMFuzzerTestOneInput(exact.empty() ? nullptr : exact.data(), exact.size());
+  return true;
+}
+
+int main(int argc, char** argv) {
+  unsigned files = 0;
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] == '-') continue;  // libFuzzer flags, so the same command line works
+    struct stat st;
+    if (stat(argv[i], &st) != 0) {
+      perror(argv[i]);
+      return 1;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+      files += replayFile(argv[i]);
+      continue;
+    }
+    DIR* dir = opendir(argv[i]);
+    while (dirent* e = dir ? readdir(dir) : nullptr) {
+      if (e->d_name[0] == '.') continue;
+      char path[1024];
+      snprintf(path, sizeof(path), "%s/%s", argv[i], e->d_name);
+      files += replayFile(path);
+    }
+    if (dir) closedir(dir);
+  }
+  fprintf(stderr, "replayed %u inputs\n", files);
+  return 0;
+}
+#endif
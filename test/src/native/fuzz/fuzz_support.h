@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "capture_codec.h"
+#include "downlink_router.h"
+#include "text_store.h"
+
+// ------------------------------------------------------------------
+// --- Fuzz Harness Support ---
+// ------------------------------------------------------------------
+// Each harness defines its body with FUZZ_TARGET. Every input is timed,
+// and the distribution is printed when the run ends. An input slower
+// than AURALINK_FUZZ_SLOW_US (default FUZZ_SLOW_US_DEFAULT) is written
+// to $AURALINK_FUZZ_ARTIFACTS/slow-<target>-<fnv1a> and aborts the run,
+// so libFuzzer reports it like a crash. AURALINK_FUZZ_SLOW_ABORT=0 only
+// records it. The budget is far above anything the parsers should need.
+// A slow input means a path that would stall the network task on
+// target.
+//
+// Built with -D AURALINK_FUZZ_STANDALONE (no libFuzzer, e.g. gcc), the
+// harness gets a main() that replays the files and directories given on
+// the command line. That is enough to run the seed corpus and saved
+// crashes as a regression check.
+//
+// The fuzzApply* helpers run a payload through the same parsers and
+// state changes as the firmware handlers. They check each parser's
+// postconditions and trap when one does not hold.
+
+#define FUZZ_SLOW_US_DEFAULT 20000
+#define FUZZ_WARMUP_RUNS 4   // First calls pay for page faults and lazy init
+
+#define FUZZ_CHECK(cond) \
+  do {                   \
+    if (!(cond)) __builtin_trap(); \
+  } while (0)
+
+typedef void (*FuzzBody)(const uint8_t* data, size_t size);
+
+void fuzzTimed(const char* target, FuzzBody body, const uint8_t* data, size_t size);
+
+#define FUZZ_TARGET(name)                                                      \
+  static void fuzzBody(const uint8_t* data, size_t size);                      \
+  extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {    \
+    fuzzTimed(name, fuzzBody, data, size);                                     \
+    return 0;                                                                  \
+  }                                                                            \
+  static void fuzzBody(const uint8_t* data, size_t size)
+
+// --- Firmware handler equivalents ---
+// updateRules(): binary when it starts with RULES_BINARY_MAGIC, else text
+bool fuzzApplyRules(const uint8_t* data, size_t len);
+// storeDisplayText()
+void fuzzApplyText(TextStore& store, TextTopicKind kind, const ChunkHeader& header, const uint8_t* data, size_t len);
+// controlCapture() up to the point it would start the capture
+bool fuzzApplyCapture(const uint8_t* data, size_t len);
+// handleDownlink()
+bool fuzzApplyDownlink(TextStore* stores, const uint8_t* data, size_t len);
+// callback(): topic must be NUL-terminated
+void fuzzDispatch(TextStore* stores, const char* topic, const uint8_t* payload, size_t len);
@@ -0,0 +1,42 @@
+// ------------------------------------------------------------------
+// --- Fuzz: display text topics and chunk reassembly ---
+// ------------------------------------------------------------------
+// A sequence of text messages into one pair of stores, so the chunk
+// state machine sees interleaved, repeated and out-of-order pieces.
+// Input: records of
+//   u8 topic length | topic | u16 LE payload length | payload
+// (lengths are clamped to what is left). Topics are classified by
+// parseTextTopic against both text topics, as the dispatcher does.
+
+#include <string.h>
+
+#include "fuzz_support.h"
+
+FUZZ_TARGET("text") {
+  TextStore stores[TEXT_SLOT_COUNT];
+  size_t pos = 0;
+  while (pos < size) {
+    size_t topicLen = data[pos++];
+    if (topicLen > size - pos) topicLen = size - pos;
+    if (topicLen >= DOWNLINK_TOPIC_MAX) topicLen = DOWNLINK_TOPIC_MAX - 1;
+    char topic[DOWNLINK_TOPIC_MAX];
+    memcpy(topic, data + pos, topicLen);
+    topic[topicLen] = '\0';
+    pos += topicLen;
+
+    size_t len = 0;
+    if (size - pos >= 2) {
+      len = data[pos] | (data[pos + 1] << 8);
+      pos += 2;
+    }
+    if (len > size - pos) len = size - pos;
+    for (uint8_t slot = 0; slot < TEXT_SLOT_COUNT; slot++) {
+      ChunkHeader header;
+      TextTopicKind kind = parseTextTopic(topic, textTopics[slot], header);
+      if (kind == TEXT_TOPIC_NONE) continue;
+      FUZZ_CHECK(kind == TEXT_TOPIC_WHOLE || (header.count > 0 && header.index < header.count));
+      fuzzApplyText(stores[slot], kind, header, data + pos, len);
+    }
+    pos += len;
+  }
+}
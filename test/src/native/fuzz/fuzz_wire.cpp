@@ -0,0 +1,12 @@
+// ------------------------------------------------------------------
+// --- Fuzz: protobuf downlinks ---
+// ------------------------------------------------------------------
+// wireDecodeDownlink on auralink/pb/downlink payloads, then the decoded
+// body through its text, rules or capture parser as handleDownlink does.
+
+#include "fuzz_support.h"
+
+FUZZ_TARGET("wire") {
+  TextStore stores[TEXT_SLOT_COUNT];
+  fuzzApplyDownlink(stores, data, size);
+}
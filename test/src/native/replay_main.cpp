@@ -0,0 +1,168 @@
+// ------------------------------------------------------------------
+// --- Native Trace Replay ---
+// ------------------------------------------------------------------
+// Plays a sensor trace through the same readings -> sample -> rules path
+// as the firmware's replay build and prints the resulting stream: one
+// line per sample with the uplink payload, the alert/publish masks and
+// the LED commands. The stream is a pure function of the trace and the
+// rules, so two runs (or two builds) can be compared with diff; the
+// FNV-1a hash on stderr is a quick check of the same thing.
+//
+//   replay <trace.bin> [--speed N] [--rules rules.txt] [--batch BYTES]
+//
+// --speed 1 paces records at their recorded offsets, N > 1 plays N times
+// faster, and 0 (the default) runs unpaced. --batch also packs the
+// samples into series_codec.h batches of at most BYTES and reports the
+// compression ratio against the JSON payloads and the encode cost.
+
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include "default_rules.h"
+#include "payload.h"
+#include "readings.h"
+#include "rules.h"
+#include "series_codec.h"
+#include "trace.h"
+
+static bool fileRead(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+  FILE* f = (FILE*)ctx;
+  return fseek(f, (long)offset, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+}
+
+static uint32_t fnv1a(uint32_t h, const char* s, size_t len) {
+  for (size_t i = 0; i < len; i++) h = (h ^ (uint8_t)s[i]) * 16777619u;
+  return h;
+}
+
+// Packs `samples` into batches of at most `maxBytes`, as the firmware
+// drains its backlog, and reports size and encode cost on stderr
+static void benchmarkBatches(const std::vector<SensorSample>& samples, size_t maxBytes, size_t jsonBytes) {
+  std::vector<uint8_t> buf(maxBytes);
+  size_t bytes = 0, batches = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < samples.size();) {
+    SeriesEncoder encoder;
+    encoder.begin(buf.data(), buf.size());
+    while (i < samples.size() && encoder.add(samples[i])) i++;
+    size_t len = encoder.finish();
+    if (len == 0) {
+      fprintf(stderr, "batch: %zu bytes cannot hold a single sample\n", maxBytes);
+      return;
+    }
+    bytes += len;
+    batches++;
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "batch: %zu samples in %zu batches, %zu bytes vs %zu JSON (%.2fx), %.0f ns/sample\n",
+          samples.size(), batches, bytes, jsonBytes, bytes ? (double)jsonBytes / bytes : 0.0,
+          samples.empty() ? 0.0 : ns / samples.size());
+}
+
+static bool loadRules(const char* path, RuleProgram& prog) {
+  char err[96];
+  if (!path) {
+    if (rulesCompile(defaultRules, strlen(defaultRules), prog, err, sizeof(err))) return true;
+    fprintf(stderr, "default rules: %s\n", err);
+    return false;
+  }
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  static char text[4096];
+  size_t len = fread(text, 1, sizeof(text), f);
+  fclose(f);
+  bool ok = len >= 4 && memcmp(text, RULES_BINARY_MAGIC, 4) == 0
+                ? rulesLoadBinary((const uint8_t*)text, len, prog, err, sizeof(err))
+                : rulesCompile(text, len, prog, err, sizeof(err));
+  if (!ok) fprintf(stderr, "%s: %s\n", path, err);
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  const char* tracePath = nullptr;
+  const char* rulesPath = nullptr;
+  unsigned speed = 0;
+  size_t batchBytes = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+      speed = (unsigned)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+      rulesPath = argv[++i];
+    } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+      batchBytes = strtoul(argv[++i], nullptr, 10);
+    } else if (!tracePath && argv[i][0] != '-') {
+      tracePath = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s <trace.bin> [--speed N] [--rules file] [--batch BYTES]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (!tracePath) {
+    fprintf(stderr, "usage: %s <trace.bin> [--speed N] [--rules file] [--batch BYTES]\n", argv[0]);
+    return 2;
+  }
+
+  RuleProgram rules;
+  if (!loadRules(rulesPath, rules)) return 1;
+  RuleState state = RuleState();
+
+  FILE* f = fopen(tracePath, "rb");
+  if (!f) {
+    perror(tracePath);
+    return 1;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  TraceReader trace;
+  if (size < 0 || !trace.begin(fileRead, f, (uint32_t)size)) {
+    fprintf(stderr, "%s: not a valid trace\n", tracePath);
+    fclose(f);
+    return 1;
+  }
+
+  // Mirrors sampleOnce(): failed DHT reads are skipped without using a
+  // sequence number, and numbering starts at 0
+  auto start = std::chrono::steady_clock::now();
+  uint32_t seq = 0;
+  uint32_t hash = 2166136261u;
+  std::vector<SensorSample> samples;
+  size_t jsonBytes = 0;
+  TraceRecord rec;
+  while (trace.next(rec)) {
+    if (speed) std::this_thread::sleep_until(start + std::chrono::milliseconds(rec.offsetMs / speed));
+    if (!readingsValid(rec.readings)) continue;
+
+    SensorSample sample = readingsToSample(rec.readings, seq++, rec.offsetMs);
+    RuleInputs inputs;
+    sampleToRuleInputs(sample, inputs);
+    RuleOutputs outputs;
+    rulesEvaluate(rules, inputs, state, outputs);
+
+    char line[SENSOR_PAYLOAD_MAX + 160];
+    size_t n = formatSensorPayload(sample, line, SENSOR_PAYLOAD_MAX);
+    if (batchBytes) {
+      samples.push_back(sample);
+      jsonBytes += n;
+    }
+    n += snprintf(line + n, sizeof(line) - n, " alert=%08x publish=%08x", (unsigned)outputs.alertMask,
+                  (unsigned)outputs.publishMask);
+    for (uint8_t i = 0; i < RULE_LED_COUNT; i++) {
+      const RuleLedCommand& c = outputs.leds[i];
+      n += snprintf(line + n, sizeof(line) - n, " %s=%u/%u/%u/%u", rulesLedName(i), c.mode, c.periodMs, c.count,
+                    c.gapMs);
+    }
+    puts(line);
+    hash = fnv1a(hash, line, n);
+  }
+  fclose(f);
+  fprintf(stderr, "replayed %u of %u records, fnv1a %08x\n", (unsigned)seq, (unsigned)trace.count(), (unsigned)hash);
+  if (batchBytes) benchmarkBatches(samples, batchBytes, jsonBytes);
+  return 0;
+}
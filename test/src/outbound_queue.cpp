@@ -0,0 +1,132 @@
+#include "outbound_queue.h"
+
+#include <string.h>
+
+// Arena layout follows entry order: payloads are placed after the newest
+// one, wrapping to offset 0 when the tail end is too short. Superseded
+// (dead) entries keep their bytes until they reach the front. Empty
+// payloads still take one byte so every entry has a distinct offset.
+static inline size_t span(size_t len) { return len ? len : 1; }
+
+bool OutboundQueue::allocate(size_t len, uint16_t& offset) const {
+  len = span(len);
+  if (len > OUTBOUND_ARENA_BYTES) return false;
+  if (count_ == 0) {
+    offset = 0;
+    return true;
+  }
+  if (count_ == OUTBOUND_MAX_ENTRIES) return false;
+  const Entry& oldest = at(0);
+  const Entry& newest = at(count_ - 1);
+  size_t start = newest.offset + span(newest.len);
+  if (newest.offset < oldest.offset) {
+    // Already wrapped: the only gap is up to the oldest payload
+    if (oldest.offset - start < len) return false;
+    offset = start;
+    return true;
+  }
+  if (OUTBOUND_ARENA_BYTES - start >= len) {
+    offset = start;
+    return true;
+  }
+  if (oldest.offset >= len) {
+    offset = 0;
+    return true;
+  }
+  return false;
+}
+
+bool OutboundQueue::hasRoom(size_t len) const {
+  uint16_t offset;
+  return allocate(len, offset);
+}
+
+size_t OutboundQueue::bytesUsed() const {
+  size_t used = 0;
+  for (size_t i = 0; i < count_; i++) used += at(i).len;
+  return used;
+}
+
+void OutboundQueue::popFront() {
+  if (count_ == 0) return;
+  if (at(0).live) live_--;
+  head_ = (head_ + 1) % OUTBOUND_MAX_ENTRIES;
+  count_--;
+}
+
+void OutboundQueue::skipDead() {
+  while (count_ > 0 && !at(0).live) popFront();
+}
+
+bool OutboundQueue::push(const char* topic, const uint8_t* payload, size_t len, OutboundPolicy policy) {
+  if (mqttPublishPacketSize(strlen(topic), len) > maxPacket_ || len > OUTBOUND_ARENA_BYTES) {
+    stats_.oversize++;
+    return false;
+  }
+
+  if (policy == OUTBOUND_COALESCE) {
+    for (size_t i = 0; i < count_; i++) {
+      Entry& e = at(i);
+      if (!e.live || strcmp(e.topic, topic) != 0) continue;
+      e.live = false;
+      live_--;
+      stats_.coalesced++;
+    }
+    skipDead();
+  }
+
+  uint16_t offset;
+  while (!allocate(len, offset)) {
+    if (policy == OUTBOUND_DROP_NEWEST) {
+      stats_.droppedNewest++;
+      return false;
+    }
+    // Evict the oldest message (dead entries go for free)
+    if (at(0).live) stats_.droppedOldest++;
+    popFront();
+    skipDead();
+  }
+
+  Entry& e = at(count_);
+  e.topic = topic;
+  e.offset = offset;
+  e.len = len;
+  e.retries = 0;
+  e.live = true;
+  memcpy(arena_ + offset, payload, len);
+  count_++;
+  live_++;
+  stats_.enqueued++;
+  return true;
+}
+
+bool OutboundQueue::push(const char* topic, const char* payload, OutboundPolicy policy) {
+  return push(topic, (const uint8_t*)payload, strlen(payload), policy);
+}
+
+OutboundMessage OutboundQueue::front() {
+  skipDead();
+  const Entry& e = at(0);
+  return OutboundMessage{e.topic, arena_ + e.offset, e.len};
+}
+
+void OutboundQueue::popSent() {
+  skipDead();
+  if (count_ == 0) return;
+  stats_.sent++;
+  popFront();
+  skipDead();
+}
+
+void OutboundQueue::sendFailed() {
+  skipDead();
+  if (count_ == 0) return;
+  Entry& e = at(0);
+  if (++e.retries < OUTBOUND_MAX_RETRIES) {
+    stats_.retries++;
+    return;
+  }
+  stats_.failed++;
+  popFront();
+  skipDead();
+}
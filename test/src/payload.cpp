@@ -0,0 +1,12 @@
+#include "payload.h"
+
+#include <stdio.h>
+
+size_t formatSensorPayload(const SensorSample& s, char* buf, size_t len) {
+  int n = snprintf(buf, len,
+                   "{\"temperature\":%.1f, \"humidity\":%.1f, \"light_percent\":%d, \"nox_percent\":%d, \"seq\":%lu}",
+                   s.temperature, s.humidity, s.lightPercent, s.noxPercent,
+                   (unsigned long)s.seq);
+  if (n < 0 || (size_t)n >= len) return 0;
+  return (size_t)n;
+}
@@ -0,0 +1,52 @@
+#ifdef AURALINK_QEMU
+
+#include "qemu_net.h"
+
+#include <esp_eth.h>
+#include <esp_event.h>
+#include <esp_netif.h>
+#include <sdkconfig.h>
+
+#ifndef CONFIG_ETH_USE_OPENETH
+#error "AURALINK_QEMU needs CONFIG_ETH_USE_OPENETH (sdkconfig.defaults, esp32-qemu env)"
+#endif
+
+static esp_eth_handle_t eth = nullptr;
+static volatile bool gotIp = false;
+static volatile uint32_t localIp = 0;
+
+static void onGotIp(void*, esp_event_base_t, int32_t, void* data) {
+  const ip_event_got_ip_t* event = (const ip_event_got_ip_t*)data;
+  localIp = event->ip_info.ip.addr;
+  gotIp = true;
+}
+
+static void onLost(void*, esp_event_base_t, int32_t, void*) { gotIp = false; }
+
+bool qemuNetBegin() {
+  esp_netif_init();
+  esp_err_t err = esp_event_loop_create_default();
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return false;  // Already created is fine
+
+  esp_netif_config_t netifConfig = ESP_NETIF_DEFAULT_ETH();
+  esp_netif_t* netif = esp_netif_new(&netifConfig);
+
+  eth_mac_config_t macConfig = ETH_MAC_DEFAULT_CONFIG();
+  eth_phy_config_t phyConfig = ETH_PHY_DEFAULT_CONFIG();
+  phyConfig.autonego_timeout_ms = 100;   // The emulated PHY links up at once
+  esp_eth_mac_t* mac = esp_eth_mac_new_openeth(&macConfig);
+  esp_eth_phy_t* phy = esp_eth_phy_new_dp83848(&phyConfig);
+  esp_eth_config_t ethConfig = ETH_DEFAULT_CONFIG(mac, phy);
+  if (!netif || !mac || !phy || esp_eth_driver_install(&ethConfig, &eth) != ESP_OK) return false;
+
+  esp_event_handler_register(IP_EVENT, IP_EVENT_ETH_GOT_IP, onGotIp, nullptr);
+  esp_event_handler_register(ETH_EVENT, ETHERNET_EVENT_DISCONNECTED, onLost, nullptr);
+  esp_netif_attach(netif, esp_eth_new_netif_glue(eth));
+  return esp_eth_start(eth) == ESP_OK;
+}
+
+bool qemuNetUp() { return gotIp; }
+
+IPAddress qemuNetLocalIP() { return IPAddress(localIp); }
+
+#endif  // AURALINK_QEMU
@@ -0,0 +1,37 @@
+#include "readings.h"
+
+#include <math.h>
+
+bool readingsValid(const RawReadings& r) {
+  return !isnan(r.temperature) && !isnan(r.humidity);
+}
+
+long mapRange(long x, long inMin, long inMax, long outMin, long outMax) {
+  long run = inMax - inMin;
+  if (run == 0) return outMin;
+  return (x - inMin) * (outMax - outMin) / run + outMin;
+}
+
+static uint8_t percent(long v) {
+  return v < 0 ? 0 : (v > 100 ? 100 : (uint8_t)v);
+}
+
+SensorSample readingsToSample(const RawReadings& r, uint32_t seq, uint32_t timestampMs) {
+  SensorSample s;
+  s.seq = seq;
+  s.timestampMs = timestampMs;
+  s.temperature = r.temperature;
+  s.humidity = r.humidity;
+  s.lightPercent = percent(mapRange(r.ldrAnalog, ADC_FULL_SCALE, 0, 0, 100));
+  s.noxPercent = percent(mapRange(r.noxRaw, 0, ADC_FULL_SCALE, 0, 100));
+  s.pir = r.pir;
+  return s;
+}
+
+void sampleToRuleInputs(const SensorSample& s, RuleInputs& inputs) {
+  inputs.values[RULE_VAR_TEMP] = s.temperature;
+  inputs.values[RULE_VAR_HUM] = s.humidity;
+  inputs.values[RULE_VAR_LIGHT] = s.lightPercent;
+  inputs.values[RULE_VAR_NOX] = s.noxPercent;
+  inputs.values[RULE_VAR_PIR] = s.pir;
+}
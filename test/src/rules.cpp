@@ -0,0 +1,439 @@
+#include "rules.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ------------------------------------------------------------------
+// --- Bytecode ---
+// ------------------------------------------------------------------
+// Operands are inline and little-endian. Every rule ends in exactly one
+// action op, which pops the rule's condition.
+enum : uint8_t {
+  OP_LOAD = 1,   // var:u8                 push input
+  OP_CONST,      // value:f32              push constant
+  OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE,
+  OP_AND, OP_OR, OP_NOT,
+  OP_LED,        // led:u8 mode:u8 ms:u16 count:u8 gap:u16  pop cond
+  OP_ALERT,      // code:u8                pop cond
+  OP_PUBLISH     // code:u8                pop cond
+};
+
+static const char* const varNames[RULE_VAR_COUNT] = {"temp", "hum", "light", "nox", "pir"};
+static const char* const ledNames[RULE_LED_COUNT] = {"temp", "light", "nox", "pir", "urgency"};
+static const char* const modeNames[] = {"", "off", "on", "blink", "breathe", "pulse"};
+
+const char* rulesLedName(uint8_t led) { return led < RULE_LED_COUNT ? ledNames[led] : "?"; }
+
+// Returns the operand size of an opcode, or -1 if it is not valid
+static int operandBytes(uint8_t op) {
+  switch (op) {
+    case OP_LOAD: return 1;
+    case OP_CONST: return 4;
+    case OP_LT: case OP_LE: case OP_GT: case OP_GE: case OP_EQ: case OP_NE:
+    case OP_AND: case OP_OR: case OP_NOT: return 0;
+    case OP_LED: return 7;
+    case OP_ALERT: case OP_PUBLISH: return 1;
+    default: return -1;
+  }
+}
+
+// Stack effect of an opcode (pushes minus pops)
+static int stackEffect(uint8_t op) {
+  switch (op) {
+    case OP_LOAD: case OP_CONST: return 1;
+    case OP_NOT: return 0;
+    default: return -1;
+  }
+}
+
+// ------------------------------------------------------------------
+// --- Verifier: shared by the compiler and the binary loader ---
+// ------------------------------------------------------------------
+static bool verify(const uint8_t* code, size_t len, uint8_t& ruleCount, char* err, size_t errLen) {
+  int depth = 0;
+  ruleCount = 0;
+  size_t pc = 0;
+  while (pc < len) {
+    uint8_t op = code[pc];
+    int operands = operandBytes(op);
+    if (operands < 0 || pc + 1 + operands > len) {
+      snprintf(err, errLen, "bad opcode at %u", (unsigned)pc);
+      return false;
+    }
+    const uint8_t* arg = code + pc + 1;
+    if (op == OP_LOAD && arg[0] >= RULE_VAR_COUNT) {
+      snprintf(err, errLen, "bad variable at %u", (unsigned)pc);
+      return false;
+    }
+    if (op == OP_LED && (arg[0] >= RULE_LED_COUNT || arg[1] < RULE_LED_OFF || arg[1] > RULE_LED_PULSE)) {
+      snprintf(err, errLen, "bad led action at %u", (unsigned)pc);
+      return false;
+    }
+    if ((op == OP_ALERT || op == OP_PUBLISH) && arg[0] > 31) {
+      snprintf(err, errLen, "bad code at %u", (unsigned)pc);
+      return false;
+    }
+    int pops = (op == OP_LOAD || op == OP_CONST) ? 0 : (op == OP_NOT || op >= OP_LED) ? 1 : 2;
+    if (depth < pops) {
+      snprintf(err, errLen, "stack underflow at %u", (unsigned)pc);
+      return false;
+    }
+    depth += stackEffect(op);
+    if (depth > RULES_STACK_MAX) {
+      snprintf(err, errLen, "expression too deep at %u", (unsigned)pc);
+      return false;
+    }
+    if (op >= OP_LED) {
+      if (depth != 0) {
+        snprintf(err, errLen, "unbalanced rule at %u", (unsigned)pc);
+        return false;
+      }
+      if (++ruleCount > RULES_MAX_RULES) {
+        snprintf(err, errLen, "too many rules");
+        return false;
+      }
+    }
+    pc += 1 + operands;
+  }
+  if (depth != 0) {
+    snprintf(err, errLen, "trailing expression");
+    return false;
+  }
+  return true;
+}
+
+// ------------------------------------------------------------------
+// --- Compiler: recursive descent over one line at a time ---
+// ------------------------------------------------------------------
+//   rule   := expr '->' action
+//   expr   := and ('||' and)*
+//   and    := unary ('&&' unary)*
+//   unary  := '!' unary | cmp
+//   cmp    := atom (relop atom)?
+//   atom   := number | variable | '(' expr ')'
+namespace {
+
+struct Compiler {
+  const char* p;
+  uint8_t* code;
+  size_t len;
+  size_t cap;
+  int nesting;
+  const char* error;
+
+  void skipSpace() {
+    while (*p == ' ' || *p == '\t') p++;
+  }
+
+  bool accept(const char* tok) {
+    skipSpace();
+    size_t n = strlen(tok);
+    if (strncmp(p, tok, n) != 0) return false;
+    p += n;
+    return true;
+  }
+
+  // Reads an identifier into buf; returns its length
+  size_t word(char* buf, size_t bufLen) {
+    skipSpace();
+    size_t n = 0;
+    while (isalpha((unsigned char)*p) && n + 1 < bufLen) buf[n++] = *p++;
+    buf[n] = '\0';
+    return n;
+  }
+
+  void emit(uint8_t b) {
+    if (len < cap) code[len] = b;
+    len++;
+  }
+
+  void emitFloat(float f) {
+    uint8_t raw[4];
+    memcpy(raw, &f, sizeof(raw));
+    for (uint8_t b : raw) emit(b);
+  }
+
+  bool fail(const char* msg) {
+    if (!error) error = msg;
+    return false;
+  }
+
+  bool atom() {
+    skipSpace();
+    if (*p == '(') {
+      p++;
+      if (++nesting > RULES_STACK_MAX) return fail("too many parentheses");
+      if (!expr()) return false;
+      nesting--;
+      return accept(")") || fail("expected ')'");
+    }
+    if (isdigit((unsigned char)*p) || *p == '-' || *p == '.') {
+      char* end;
+      float v = strtof(p, &end);
+      if (end == p) return fail("bad number");
+      p = end;
+      emit(OP_CONST);
+      emitFloat(v);
+      return true;
+    }
+    char name[8];
+    if (word(name, sizeof(name)) == 0) return fail("expected value");
+    for (uint8_t i = 0; i < RULE_VAR_COUNT; i++) {
+      if (strcmp(name, varNames[i]) == 0) {
+        emit(OP_LOAD);
+        emit(i);
+        return true;
+      }
+    }
+    return fail("unknown variable");
+  }
+
+  bool cmp() {
+    if (!atom()) return false;
+    // Longest operators first so "<=" is not read as "<"
+    static const struct { const char* tok; uint8_t op; } relops[] = {
+      {"<=", OP_LE}, {">=", OP_GE}, {"==", OP_EQ}, {"!=", OP_NE}, {"<", OP_LT}, {">", OP_GT},
+    };
+    skipSpace();
+    if (p[0] == '-' && p[1] == '>') return true;  // Start of the action
+    for (const auto& r : relops) {
+      if (accept(r.tok)) {
+        if (!atom()) return false;
+        emit(r.op);
+        return true;
+      }
+    }
+    return true;
+  }
+
+  bool unary() {
+    skipSpace();
+    if (p[0] == '!' && p[1] != '=') {
+      p++;
+      if (++nesting > RULES_STACK_MAX) return fail("expression too deep");
+      if (!unary()) return false;
+      nesting--;
+      emit(OP_NOT);
+      return true;
+    }
+    return cmp();
+  }
+
+  bool andExpr() {
+    if (!unary()) return false;
+    while (accept("&&")) {
+      if (!unary()) return false;
+      emit(OP_AND);
+    }
+    return true;
+  }
+
+  bool expr() {
+    if (!andExpr()) return false;
+    while (accept("||")) {
+      if (!andExpr()) return false;
+      emit(OP_OR);
+    }
+    return true;
+  }
+
+  bool number(long lo, long hi, long& out) {
+    skipSpace();
+    char* end;
+    out = strtol(p, &end, 10);
+    if (end == p || out < lo || out > hi) return false;
+    p = end;
+    return true;
+  }
+
+  bool action() {
+    char verb[8];
+    word(verb, sizeof(verb));
+    long v;
+    if (strcmp(verb, "led") == 0) {
+      char led[8], mode[8];
+      word(led, sizeof(led));
+      word(mode, sizeof(mode));
+      int ledIdx = -1, modeIdx = -1;
+      for (int i = 0; i < RULE_LED_COUNT; i++) if (strcmp(led, ledNames[i]) == 0) ledIdx = i;
+      for (int i = RULE_LED_OFF; i <= RULE_LED_PULSE; i++) if (strcmp(mode, modeNames[i]) == 0) modeIdx = i;
+      if (ledIdx < 0) return fail("unknown led");
+      if (modeIdx < 0) return fail("unknown led mode");
+      long ms = 0, count = 0, gap = 0;
+      // Blink and pulse periods are half the LED effect's 16-bit full period
+      long maxMs = modeIdx == RULE_LED_BREATHE ? 65535 : 32767;
+      if (modeIdx >= RULE_LED_BLINK && !number(1, maxMs, ms)) return fail("expected period in ms");
+      if (modeIdx == RULE_LED_PULSE && (!number(1, 255, count) || !number(0, 65535, gap))) {
+        return fail("expected pulse count and gap");
+      }
+      emit(OP_LED);
+      emit((uint8_t)ledIdx);
+      emit((uint8_t)modeIdx);
+      emit((uint8_t)(ms & 0xFF));
+      emit((uint8_t)(ms >> 8));
+      emit((uint8_t)count);
+      emit((uint8_t)(gap & 0xFF));
+      emit((uint8_t)(gap >> 8));
+    } else if (strcmp(verb, "alert") == 0 || strcmp(verb, "publish") == 0) {
+      if (!number(0, 31, v)) return fail("expected code 0-31");
+      emit(verb[0] == 'a' ? OP_ALERT : OP_PUBLISH);
+      emit((uint8_t)v);
+    } else {
+      return fail("unknown action");
+    }
+    skipSpace();
+    return *p == '\0' || *p == '#' || fail("unexpected text after action");
+  }
+
+  bool rule() {
+    if (!expr()) return false;
+    if (!accept("->")) return fail("expected '->'");
+    return action();
+  }
+};
+
+}  // namespace
+
+bool rulesCompile(const char* text, size_t len, RuleProgram& out, char* err, size_t errLen) {
+  uint8_t code[RULES_MAX_CODE];
+  Compiler c = {nullptr, code, 0, sizeof(code), 0, nullptr};
+  char line[RULES_MAX_LINE];
+  size_t pos = 0;
+  unsigned lineNo = 0;
+
+  while (pos < len) {
+    size_t start = pos;
+    while (pos < len && text[pos] != '\n' && text[pos] != ';') pos++;
+    size_t n = pos - start;
+    pos++;  // Skip the separator
+    lineNo++;
+    if (n >= sizeof(line)) {
+      snprintf(err, errLen, "line %u: too long", lineNo);
+      return false;
+    }
+    memcpy(line, text + start, n);
+    line[n] = '\0';
+    if (n && line[n - 1] == '\r') line[n - 1] = '\0';
+
+    c.p = line;
+    c.skipSpace();
+    if (*c.p == '\0' || *c.p == '#') continue;
+    c.nesting = 0;
+    if (!c.rule()) {
+      snprintf(err, errLen, "line %u: %s", lineNo, c.error);
+      return false;
+    }
+    if (c.len > c.cap) {
+      snprintf(err, errLen, "line %u: program too large", lineNo);
+      return false;
+    }
+  }
+
+  uint8_t ruleCount;
+  if (!verify(code, c.len, ruleCount, err, errLen)) return false;
+  memcpy(out.code, code, c.len);
+  out.len = (uint16_t)c.len;
+  out.ruleCount = ruleCount;
+  return true;
+}
+
+bool rulesLoadBinary(const uint8_t* data, size_t len, RuleProgram& out, char* err, size_t errLen) {
+  const size_t header = sizeof(RULES_BINARY_MAGIC) - 1 + 2;
+  if (len < header || memcmp(data, RULES_BINARY_MAGIC, header - 2) != 0) {
+    snprintf(err, errLen, "bad header");
+    return false;
+  }
+  size_t codeLen = data[header - 2] | (data[header - 1] << 8);
+  if (codeLen > RULES_MAX_CODE || codeLen != len - header) {
+    snprintf(err, errLen, "bad length");
+    return false;
+  }
+  uint8_t ruleCount;
+  if (!verify(data + header, codeLen, ruleCount, err, errLen)) return false;
+  memcpy(out.code, data + header, codeLen);
+  out.len = (uint16_t)codeLen;
+  out.ruleCount = ruleCount;
+  return true;
+}
+
+size_t rulesSaveBinary(const RuleProgram& prog, uint8_t* buf, size_t len) {
+  const size_t magic = sizeof(RULES_BINARY_MAGIC) - 1;
+  if (len < magic + 2 + prog.len) return 0;
+  memcpy(buf, RULES_BINARY_MAGIC, magic);
+  buf[magic] = prog.len & 0xFF;
+  buf[magic + 1] = prog.len >> 8;
+  memcpy(buf + magic + 2, prog.code, prog.len);
+  return magic + 2 + prog.len;
+}
+
+// ------------------------------------------------------------------
+// --- Evaluator: one straight-line pass, no allocation ---
+// ------------------------------------------------------------------
+void rulesEvaluate(const RuleProgram& prog, const RuleInputs& in, RuleState& state, RuleOutputs& out) {
+  float stack[RULES_STACK_MAX];
+  int sp = 0;
+  uint8_t rule = 0;
+  uint32_t results = 0;
+  memset(&out, 0, sizeof(out));
+
+  const uint8_t* code = prog.code;
+  size_t pc = 0;
+  while (pc < prog.len) {
+    uint8_t op = code[pc++];
+    switch (op) {
+      case OP_LOAD:
+        stack[sp++] = in.values[code[pc++]];
+        break;
+      case OP_CONST: {
+        float v;
+        memcpy(&v, code + pc, sizeof(v));
+        pc += sizeof(v);
+        stack[sp++] = v;
+        break;
+      }
+      case OP_NOT:
+        stack[sp - 1] = stack[sp - 1] == 0.0f ? 1.0f : 0.0f;
+        break;
+      case OP_LED: case OP_ALERT: case OP_PUBLISH: {
+        bool cond = stack[--sp] != 0.0f;
+        uint32_t bit = 1UL << rule++;
+        if (cond) results |= bit;
+        if (op == OP_LED) {
+          if (cond) {
+            RuleLedCommand& led = out.leds[code[pc]];
+            led.mode = code[pc + 1];
+            led.periodMs = code[pc + 2] | (code[pc + 3] << 8);
+            led.count = code[pc + 4];
+            led.gapMs = code[pc + 5] | (code[pc + 6] << 8);
+          }
+          pc += 7;
+        } else {
+          uint32_t codeBit = 1UL << code[pc++];
+          if (op == OP_ALERT && cond) out.alertMask |= codeBit;
+          if (op == OP_PUBLISH && cond && !(state.lastResults & bit)) out.publishMask |= codeBit;
+        }
+        break;
+      }
+      default: {
+        float b = stack[--sp];
+        float a = stack[sp - 1];
+        bool r;
+        switch (op) {
+          case OP_LT: r = a < b; break;
+          case OP_LE: r = a <= b; break;
+          case OP_GT: r = a > b; break;
+          case OP_GE: r = a >= b; break;
+          case OP_EQ: r = a == b; break;
+          case OP_NE: r = a != b; break;
+          case OP_AND: r = a != 0.0f && b != 0.0f; break;
+          default: r = a != 0.0f || b != 0.0f; break;  // OP_OR
+        }
+        stack[sp - 1] = r ? 1.0f : 0.0f;
+        break;
+      }
+    }
+  }
+  state.lastResults = results;
+}
@@ -0,0 +1,102 @@
+#include "sample_clock.h"
+
+#include <esp_timer.h>
+#include <freertos/queue.h>
+
+static esp_timer_handle_t timer = nullptr;
+static QueueHandle_t ticks = nullptr;
+static uint64_t periodUs = 0;
+static bool started = false;
+static bool periodic = false;
+static volatile uint32_t pendingPeriodMs = 0;   // From sampleClockSetPeriod, applied by onTick
+
+// Written by the timer callback only
+static uint32_t tickIndex = 0;
+static int64_t lastCaptureUs = 0;
+static SampleClockStats stats = {};
+
+static Histogram jitterHist("auralink_sample_jitter_us", "Sample tick spacing error vs the period");
+static Histogram handoffHist("auralink_sample_handoff_us", "Sample tick to sensor task pickup");
+
+// Runs on the esp_timer task; keep it short and non-blocking
+static void onTick(void*) {
+  int64_t now = esp_timer_get_time();
+  if (lastCaptureUs != 0) {
+    int64_t spacing = now - lastCaptureUs;
+    uint32_t jitter = (uint32_t)(spacing > (int64_t)periodUs ? spacing - periodUs : periodUs - spacing);
+    jitterHist.record(jitter);
+    if (jitter > stats.maxJitterUs) stats.maxJitterUs = jitter;
+    if (jitter > SAMPLE_CLOCK_JITTER_BUDGET_US) stats.overBudget++;
+  }
+  lastCaptureUs = now;
+  uint32_t newPeriodMs = pendingPeriodMs;
+  if (newPeriodMs) {
+    // The new spacing counts from this tick
+    pendingPeriodMs = 0;
+    periodUs = (uint64_t)newPeriodMs * 1000;
+    if (periodic) esp_timer_stop(timer);
+    periodic = false;
+  }
+  if (!periodic) {
+    // The first tick came from the one-shot start delay; a fired one-shot
+    // may be re-armed from its own callback
+    periodic = true;
+    esp_timer_start_periodic(timer, periodUs);
+  }
+  SampleTick tick = {tickIndex++, now};
+  stats.ticks++;
+  if (xQueueSend(ticks, &tick, 0) != pdTRUE) stats.missed++;
+}
+
+bool sampleClockBegin(uint32_t periodMs) {
+  periodUs = (uint64_t)periodMs * 1000;
+  ticks = xQueueCreate(SAMPLE_CLOCK_QUEUE_DEPTH, sizeof(SampleTick));
+  esp_timer_create_args_t args = {};
+  args.callback = onTick;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "sample";
+  if (!ticks || esp_timer_create(&args, &timer) != ESP_OK) return false;
+  metricsRegister(&jitterHist);
+  metricsRegister(&handoffHist);
+  return true;
+}
+
+void sampleClockStart(uint32_t delayMs) {
+  if (started || !timer) return;
+  started = true;
+  esp_timer_start_once(timer, delayMs ? (uint64_t)delayMs * 1000 : 1);
+}
+
+bool sampleClockWait(SampleTick& tick, TickType_t wait) {
+  if (xQueueReceive(ticks, &tick, wait) != pdTRUE) return false;
+  handoffHist.record((uint32_t)(esp_timer_get_time() - tick.captureUs));
+  return true;
+}
+
+SampleClockStats sampleClockStats() { return stats; }
+
+void sampleClockSetPeriod(uint32_t periodMs) {
+  if (!periodMs) return;
+  if (started) {
+    pendingPeriodMs = periodMs;
+  } else {
+    periodUs = (uint64_t)periodMs * 1000;
+  }
+}
+
+uint32_t sampleClockPeriodMs() {
+  uint32_t pending = pendingPeriodMs;
+  return pending ? pending : (uint32_t)(periodUs / 1000);
+}
+
+size_t sampleClockFormatJson(char* buf, size_t len) {
+  SampleClockStats s = stats;
+  int n = snprintf(buf, len,
+                   "{\"period_ms\":%lu,\"ticks\":%lu,\"missed\":%lu,\"jitter_max_us\":%lu,"
+                   "\"jitter_p99_us\":%lu,\"over_budget\":%lu,\"handoff_p99_us\":%lu}",
+                   (unsigned long)(periodUs / 1000), (unsigned long)s.ticks, (unsigned long)s.missed,
+                   (unsigned long)s.maxJitterUs, (unsigned long)jitterHist.percentile(99),
+                   (unsigned long)s.overBudget, (unsigned long)handoffHist.percentile(99));
+  if (n < 0 || (size_t)n >= len) return 0;
+  return (size_t)n;
+}
@@ -0,0 +1,150 @@
+#include "serial_shell.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static const ShellCommand* commands = nullptr;
+static size_t commandCount = 0;
+static ShellWrite output = nullptr;
+static LineEditor editor;
+
+static void writeStr(ShellWrite w, const char* s) {
+  if (w) w(s, strlen(s));
+}
+
+void LineEditor::reset() {
+  len_ = 0;
+  line_[0] = '\0';
+  escape_ = 0;
+  lastWasCr_ = false;
+  ready_ = false;
+}
+
+void LineEditor::erase(size_t count, ShellWrite echo) {
+  for (size_t i = 0; i < count; i++) writeStr(echo, "\b \b");
+}
+
+LineEditor::Result LineEditor::feed(char c, ShellWrite echo) {
+  if (ready_) {
+    len_ = 0;
+    line_[0] = '\0';
+    ready_ = false;
+  }
+  bool afterCr = lastWasCr_;
+  lastWasCr_ = false;
+
+  if (escape_ == 1) {
+    escape_ = c == '[' ? 2 : 0;
+    return LINE_PENDING;
+  }
+  if (escape_ == 2) {
+    escape_ = 0;
+    if (c == 'A' && history_[0]) {   // Up: recall the previous line
+      erase(len_, echo);
+      len_ = strlen(history_);
+      memcpy(line_, history_, len_ + 1);
+      writeStr(echo, line_);
+    }
+    return LINE_PENDING;
+  }
+
+  switch (c) {
+    case '\x1b':
+      escape_ = 1;
+      return LINE_PENDING;
+    case '\n':
+      if (afterCr) return LINE_PENDING;
+      // fall through
+    case '\r':
+      lastWasCr_ = c == '\r';
+      writeStr(echo, "\r\n");
+      line_[len_] = '\0';
+      ready_ = true;
+      if (len_) memcpy(history_, line_, len_ + 1);
+      return LINE_READY;
+    case '\x03':   // Ctrl-C
+      writeStr(echo, "^C\r\n");
+      len_ = 0;
+      line_[0] = '\0';
+      return LINE_CANCELLED;
+    case '\x15':   // Ctrl-U
+      erase(len_, echo);
+      len_ = 0;
+      return LINE_PENDING;
+    case '\b':
+    case '\x7f':
+      if (len_) {
+        len_--;
+        erase(1, echo);
+      }
+      return LINE_PENDING;
+    default:
+      break;
+  }
+  if ((unsigned char)c < 0x20 || (unsigned char)c > 0x7e) return LINE_PENDING;
+  if (len_ >= SHELL_LINE_MAX) return LINE_PENDING;   // Full: ignore until Enter
+  line_[len_++] = c;
+  if (echo) echo(&c, 1);
+  return LINE_PENDING;
+}
+
+void shellBegin(const ShellCommand* table, size_t count, ShellWrite write) {
+  commands = table;
+  commandCount = count;
+  output = write;
+  editor.reset();
+  writeStr(output, SHELL_PROMPT);
+}
+
+void shellPrintf(const char* fmt, ...) {
+  char buf[128];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0 || !output) return;
+  output(buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+int shellTokenize(char* line, char** argv, int maxArgs) {
+  int argc = 0;
+  char* s = line;
+  while (*s) {
+    while (*s == ' ') *s++ = '\0';
+    if (!*s) break;
+    if (argc == maxArgs) break;
+    argv[argc++] = s;
+    while (*s && *s != ' ') s++;
+  }
+  return argc;
+}
+
+bool shellExecute(char* line) {
+  char* argv[SHELL_MAX_ARGS];
+  int argc = shellTokenize(line, argv, SHELL_MAX_ARGS);
+  if (argc == 0) return true;
+  if (strcmp(argv[0], "help") == 0) {
+    for (size_t i = 0; i < commandCount; i++) {
+      shellPrintf("  %-8s %s\r\n", commands[i].name, commands[i].usage);
+    }
+    return true;
+  }
+  for (size_t i = 0; i < commandCount; i++) {
+    if (strcmp(argv[0], commands[i].name) == 0) {
+      commands[i].run(argc, argv);
+      return true;
+    }
+  }
+  shellPrintf("unknown command '%s', try help\r\n", argv[0]);
+  return false;
+}
+
+void shellFeed(const char* data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    LineEditor::Result r = editor.feed(data[i], output);
+    if (r == LineEditor::LINE_PENDING) continue;
+    if (r == LineEditor::LINE_READY) shellExecute(editor.line());
+    writeStr(output, SHELL_PROMPT);
+  }
+}
@@ -0,0 +1,140 @@
+#include "series_codec.h"
+
+#include <string.h>
+
+static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+
+static uint32_t floatBits(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+static uint8_t leadingZeros(uint32_t v) {
+  uint8_t n = 0;
+  for (uint32_t bit = 0x80000000u; bit && !(v & bit); bit >>= 1) n++;
+  return n;
+}
+
+static uint8_t trailingZeros(uint32_t v) {
+  uint8_t n = 0;
+  for (uint32_t bit = 1; bit && !(v & bit); bit <<= 1) n++;
+  return n;
+}
+
+void SeriesEncoder::begin(uint8_t* buf, size_t cap) {
+  buf_ = buf;
+  capBits_ = cap > SERIES_HEADER_BYTES ? (cap - SERIES_HEADER_BYTES) * 8 : 0;
+  bitPos_ = 0;
+  count_ = 0;
+  prevDelta_ = 0;
+  tempLeading_ = humLeading_ = 0xFF;
+  tempTrailing_ = humTrailing_ = 0;
+  if (cap > SERIES_HEADER_BYTES) memset(buf + SERIES_HEADER_BYTES, 0, cap - SERIES_HEADER_BYTES);
+}
+
+void SeriesEncoder::putBits(uint32_t value, uint8_t bits) {
+  uint8_t* stream = buf_ + SERIES_HEADER_BYTES;
+  while (bits > 0) {
+    bits--;
+    if ((value >> bits) & 1) stream[bitPos_ >> 3] |= 0x80 >> (bitPos_ & 7);
+    bitPos_++;
+  }
+}
+
+void SeriesEncoder::putVarint(uint32_t value) {
+  do {
+    uint8_t group = value & 0x7F;
+    value >>= 7;
+    putBits(value ? (group | 0x80) : group, 8);
+  } while (value);
+}
+
+void SeriesEncoder::putFloat(float value, uint32_t& prev, uint8_t& leading, uint8_t& trailing) {
+  uint32_t bits = floatBits(value);
+  uint32_t x = bits ^ prev;
+  prev = bits;
+  if (x == 0) {
+    putBits(0, 1);
+    return;
+  }
+  uint8_t lz = leadingZeros(x);
+  uint8_t tz = trailingZeros(x);
+  if (leading != 0xFF && lz >= leading && tz >= trailing) {
+    // Fits the previous meaningful window: reuse it
+    putBits(0b10, 2);
+    putBits(x >> trailing, 32 - leading - trailing);
+    return;
+  }
+  uint8_t length = 32 - lz - tz;
+  putBits(0b11, 2);
+  putBits(lz, 5);
+  putBits(length - 1, 5);
+  putBits(x >> tz, length);
+  leading = lz;
+  trailing = tz;
+}
+
+bool SeriesEncoder::add(const SensorSample& s) {
+  if (count_ == UINT16_MAX) return false;
+  if (count_ == 0) {
+    if (capBits_ < SERIES_FIRST_SAMPLE_BITS) return false;
+    first_ = s;
+    prevTemp_ = floatBits(s.temperature);
+    prevHum_ = floatBits(s.humidity);
+    putBits(prevTemp_, 32);
+    putBits(prevHum_, 32);
+    putVarint(s.lightPercent);
+    putVarint(s.noxPercent);
+    putBits(s.pir ? 1 : 0, 1);
+  } else {
+    if (capBits_ - bitPos_ < SERIES_SAMPLE_MAX_BITS) return false;
+    putVarint(zigzag((int32_t)(s.seq - prev_.seq - 1)));
+    int32_t delta = (int32_t)(s.timestampMs - prev_.timestampMs);
+    if (count_ == 1) {
+      putVarint(zigzag(delta));
+    } else {
+      int32_t dod = delta - prevDelta_;
+      if (dod == 0) {
+        putBits(0, 1);
+      } else if (dod >= -64 && dod <= 63) {
+        putBits(0b10, 2);
+        putBits((uint32_t)dod & 0x7F, 7);
+      } else if (dod >= -256 && dod <= 255) {
+        putBits(0b110, 3);
+        putBits((uint32_t)dod & 0x1FF, 9);
+      } else if (dod >= -2048 && dod <= 2047) {
+        putBits(0b1110, 4);
+        putBits((uint32_t)dod & 0xFFF, 12);
+      } else {
+        putBits(0b1111, 4);
+        putBits((uint32_t)dod, 32);
+      }
+    }
+    prevDelta_ = delta;
+    putFloat(s.temperature, prevTemp_, tempLeading_, tempTrailing_);
+    putFloat(s.humidity, prevHum_, humLeading_, humTrailing_);
+    putVarint(zigzag((int32_t)s.lightPercent - prev_.lightPercent));
+    putVarint(zigzag((int32_t)s.noxPercent - prev_.noxPercent));
+    putBits(s.pir ? 1 : 0, 1);
+  }
+  prev_ = s;
+  count_++;
+  return true;
+}
+
+size_t SeriesEncoder::finish() {
+  if (count_ == 0) return 0;
+  uint8_t* h = buf_;
+  h[0] = 'A';
+  h[1] = 'G';
+  h[2] = SERIES_VERSION;
+  h[3] = 0;
+  h[4] = (uint8_t)count_;
+  h[5] = (uint8_t)(count_ >> 8);
+  for (int i = 0; i < 4; i++) {
+    h[6 + i] = (uint8_t)(first_.seq >> (8 * i));
+    h[10 + i] = (uint8_t)(first_.timestampMs >> (8 * i));
+  }
+  return SERIES_HEADER_BYTES + (bitPos_ + 7) / 8;
+}
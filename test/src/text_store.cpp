@@ -0,0 +1,124 @@
+#include "text_store.h"
+
+#include <string.h>
+
+// Decimal field terminated by `end`; advances `s` past the terminator
+static bool parseField(const char*& s, char end, uint16_t& out) {
+  uint32_t value = 0;
+  const char* start = s;
+  while (*s >= '0' && *s <= '9') {
+    value = value * 10 + (*s - '0');
+    if (value > 0xFFFF) return false;
+    s++;
+  }
+  if (s == start || *s != end) return false;
+  if (end) s++;
+  out = value;
+  return true;
+}
+
+TextTopicKind parseTextTopic(const char* topic, const char* base, ChunkHeader& header) {
+  size_t baseLen = strlen(base);
+  if (strncmp(topic, base, baseLen) != 0) return TEXT_TOPIC_NONE;
+  const char* s = topic + baseLen;
+  if (*s == '\0') return TEXT_TOPIC_WHOLE;
+  if (strncmp(s, "/chunk/", 7) != 0) return TEXT_TOPIC_NONE;
+  s += 7;
+  ChunkHeader h;
+  if (!parseField(s, '/', h.msgId) || !parseField(s, '/', h.index) || !parseField(s, '\0', h.count)) {
+    return TEXT_TOPIC_NONE;
+  }
+  if (h.count == 0 || h.index >= h.count) return TEXT_TOPIC_NONE;
+  header = h;
+  return TEXT_TOPIC_CHUNK;
+}
+
+void TextStore::clear() {
+  text_[0] = '\0';
+  len_ = 0;
+  truncated_ = false;
+  receiving_ = false;
+  msgId_ = 0;
+  nextIndex_ = 0;
+  count_ = 0;
+  codepoint_ = 0;
+  pending_ = 0;
+}
+
+void TextStore::putChar(char c) {
+  if (len_ >= TEXT_STORE_CAPACITY) {
+    truncated_ = true;
+    return;
+  }
+  text_[len_++] = c;
+  text_[len_] = '\0';
+}
+
+// Typographic punctuation LLMs like to emit, folded to ASCII
+static char foldCodepoint(uint32_t cp) {
+  switch (cp) {
+    case 0x00A0: return ' ';
+    case 0x2013: case 0x2014: return '-';
+    case 0x2018: case 0x2019: return '\'';
+    case 0x201C: case 0x201D: return '"';
+    case 0x2026: return '.';
+    default: return '?';
+  }
+}
+
+void TextStore::putByte(uint8_t b) {
+  if (pending_) {
+    if ((b & 0xC0) == 0x80) {
+      codepoint_ = (codepoint_ << 6) | (b & 0x3F);
+      if (--pending_ == 0) putChar(foldCodepoint(codepoint_));
+      return;
+    }
+    // Sequence cut short; emit a placeholder and treat b afresh
+    pending_ = 0;
+    putChar('?');
+  }
+  if (b < 0x80) {
+    putChar((b < 0x20 || b == 0x7F) ? ' ' : (char)b);
+  } else if ((b & 0xE0) == 0xC0) {
+    codepoint_ = b & 0x1F;
+    pending_ = 1;
+  } else if ((b & 0xF0) == 0xE0) {
+    codepoint_ = b & 0x0F;
+    pending_ = 2;
+  } else if ((b & 0xF8) == 0xF0) {
+    codepoint_ = b & 0x07;
+    pending_ = 3;
+  } else {
+    putChar('?');  // Stray continuation or invalid lead byte
+  }
+}
+
+void TextStore::set(const uint8_t* data, size_t len) {
+  clear();
+  for (size_t i = 0; i < len; i++) putByte(data[i]);
+}
+
+ChunkResult TextStore::appendChunk(const ChunkHeader& header, const uint8_t* data, size_t len) {
+  if (header.index == 0) {
+    clear();
+    receiving_ = true;
+    msgId_ = header.msgId;
+    count_ = header.count;
+  } else if (!receiving_ || header.msgId != msgId_ || header.count != count_) {
+    return CHUNK_IGNORED;
+  } else if (header.index != nextIndex_) {
+    // Lost or reordered chunk: keep what we have, stop listening
+    gaps_++;
+    truncated_ = true;
+    receiving_ = false;
+    return CHUNK_IGNORED;
+  }
+
+  // Past capacity putChar() only flags the text as truncated
+  for (size_t i = 0; i < len; i++) putByte(data[i]);
+
+  nextIndex_ = header.index + 1;
+  if (nextIndex_ < count_) return CHUNK_APPENDED;
+  receiving_ = false;
+  return CHUNK_COMPLETE;
+}
@@ -0,0 +1,304 @@
+#include "tls_client.h"
+
+#include <mbedtls/error.h>
+#include <mbedtls/net_sockets.h>
+
+// Ciphersuites that map onto the ESP32 crypto accelerators (AES, SHA and
+// the RSA/bignum unit). Without AURALINK_TLS_HW_CIPHERSUITES the mbedTLS
+// default list is offered and the server may pick a software-only suite.
+#ifdef AURALINK_TLS_HW_CIPHERSUITES
+static const int hwCiphersuites[] = {
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256,
+  0
+};
+#endif
+
+// ------------------------------------------------------------------
+// --- RTC Session Cache: survives software resets and deep sleep ---
+// ------------------------------------------------------------------
+#define TLS_SESSION_MAGIC 0x544C5331  // "TLS1"
+
+struct TlsSessionCache {
+  uint32_t magic;
+  uint32_t hostHash;
+  uint16_t port;
+  uint16_t len;
+  uint8_t data[TLS_SESSION_CACHE_BYTES];
+};
+
+RTC_NOINIT_ATTR static TlsSessionCache rtcSession;
+
+static uint32_t hashHost(const char* s) {
+  uint32_t h = 2166136261u;  // FNV-1a
+  while (s && *s) {
+    h ^= (uint8_t)*s++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+TlsSessionClient::TlsSessionClient(Client& transport) : transport_(transport) {
+  mbedtls_entropy_init(&entropy_);
+  mbedtls_ctr_drbg_init(&drbg_);
+  mbedtls_ssl_config_init(&conf_);
+  mbedtls_ssl_init(&ssl_);
+  mbedtls_x509_crt_init(&ca_);
+}
+
+TlsSessionClient::~TlsSessionClient() {
+  stop();
+  mbedtls_ssl_free(&ssl_);
+  mbedtls_ssl_config_free(&conf_);
+  mbedtls_x509_crt_free(&ca_);
+  mbedtls_ctr_drbg_free(&drbg_);
+  mbedtls_entropy_free(&entropy_);
+}
+
+bool TlsSessionClient::begin(const char* caPem) {
+  static const char pers[] = "auralink-tls";
+  int rc = mbedtls_ctr_drbg_seed(&drbg_, mbedtls_entropy_func, &entropy_,
+                                 (const unsigned char*)pers, sizeof(pers) - 1);
+  if (rc == 0) rc = mbedtls_x509_crt_parse(&ca_, (const unsigned char*)caPem, strlen(caPem) + 1);
+  if (rc == 0) {
+    rc = mbedtls_ssl_config_defaults(&conf_, MBEDTLS_SSL_IS_CLIENT,
+                                     MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+  }
+  if (rc != 0) {
+    char err[96];
+    mbedtls_strerror(rc, err, sizeof(err));
+    Serial.printf("TLS setup failed: %s\n", err);
+    return false;
+  }
+
+  mbedtls_ssl_conf_authmode(&conf_, MBEDTLS_SSL_VERIFY_REQUIRED);
+  mbedtls_ssl_conf_ca_chain(&conf_, &ca_, nullptr);
+  mbedtls_ssl_conf_rng(&conf_, mbedtls_ctr_drbg_random, &drbg_);
+  mbedtls_ssl_conf_verify(&conf_, verifyCallback, this);
+  mbedtls_ssl_conf_session_tickets(&conf_, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#ifdef AURALINK_TLS_HW_CIPHERSUITES
+  mbedtls_ssl_conf_ciphersuites(&conf_, hwCiphersuites);
+#endif
+
+  ready_ = mbedtls_ssl_setup(&ssl_, &conf_) == 0;
+  return ready_;
+}
+
+void TlsSessionClient::setHostname(const char* host) { hostname_ = host; }
+
+// ------------------------------------------------------------------
+// --- BIO callbacks: mbedTLS <-> underlying Arduino Client ---
+// ------------------------------------------------------------------
+int TlsSessionClient::bioSend(void* ctx, const unsigned char* buf, size_t len) {
+  Client* c = static_cast<Client*>(ctx);
+  if (!c->connected()) return MBEDTLS_ERR_NET_CONN_RESET;
+  size_t n = c->write(buf, len);
+  return n == 0 ? MBEDTLS_ERR_SSL_WANT_WRITE : (int)n;
+}
+
+int TlsSessionClient::bioRecv(void* ctx, unsigned char* buf, size_t len) {
+  Client* c = static_cast<Client*>(ctx);
+  int avail = c->available();
+  if (avail <= 0) return c->connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+  int n = c->read(buf, len);
+  return n <= 0 ? MBEDTLS_ERR_SSL_WANT_READ : n;
+}
+
+// Only reached when the server presents a certificate, i.e. on a full
+// handshake. A resumed session skips certificate exchange entirely.
+int TlsSessionClient::verifyCallback(void* ctx, mbedtls_x509_crt*, int depth, uint32_t*) {
+  if (depth == 0) static_cast<TlsSessionClient*>(ctx)->certVerified_ = true;
+  return 0;
+}
+
+// ------------------------------------------------------------------
+// --- Session cache helpers ---
+// ------------------------------------------------------------------
+bool TlsSessionClient::restoreSession(uint16_t port) {
+  if (rtcSession.magic != TLS_SESSION_MAGIC || rtcSession.len == 0 ||
+      rtcSession.len > TLS_SESSION_CACHE_BYTES ||
+      rtcSession.hostHash != hashHost(hostname_) || rtcSession.port != port) {
+    return false;
+  }
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  bool ok = mbedtls_ssl_session_load(&session, rtcSession.data, rtcSession.len) == 0 &&
+            mbedtls_ssl_set_session(&ssl_, &session) == 0;
+  mbedtls_ssl_session_free(&session);
+  if (!ok) rtcSession.magic = 0;
+  return ok;
+}
+
+void TlsSessionClient::saveSession(uint16_t port) {
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  size_t len = 0;
+  if (mbedtls_ssl_get_session(&ssl_, &session) == 0 &&
+      mbedtls_ssl_session_save(&session, rtcSession.data, sizeof(rtcSession.data), &len) == 0) {
+    rtcSession.hostHash = hashHost(hostname_);
+    rtcSession.port = port;
+    rtcSession.len = (uint16_t)len;
+    rtcSession.magic = TLS_SESSION_MAGIC;
+  } else {
+    rtcSession.magic = 0;  // Too large for the cache or not resumable
+  }
+  mbedtls_ssl_session_free(&session);
+}
+
+// ------------------------------------------------------------------
+// --- Handshake with timing (full vs resumed reported separately) ---
+// ------------------------------------------------------------------
+int TlsSessionClient::handshake(uint16_t port) {
+  mbedtls_ssl_session_reset(&ssl_);
+  if (hostname_) mbedtls_ssl_set_hostname(&ssl_, hostname_);
+  mbedtls_ssl_set_bio(&ssl_, &transport_, bioSend, bioRecv, nullptr);
+  bool offered = restoreSession(port);
+  certVerified_ = false;
+
+  uint32_t start = millis();
+  int rc;
+  while ((rc = mbedtls_ssl_handshake(&ssl_)) != 0) {
+    if (rc != MBEDTLS_ERR_SSL_WANT_READ && rc != MBEDTLS_ERR_SSL_WANT_WRITE) break;
+    if (millis() - start > TLS_HANDSHAKE_TIMEOUT_MS) {
+      rc = MBEDTLS_ERR_SSL_TIMEOUT;
+      break;
+    }
+    vTaskDelay(1);
+  }
+  uint32_t elapsed = millis() - start;
+
+  if (rc != 0) {
+    char err[96];
+    mbedtls_strerror(rc, err, sizeof(err));
+    Serial.printf("TLS handshake failed after %lu ms: %s\n", (unsigned long)elapsed, err);
+    stats_.failedCount++;
+    if (offered) rtcSession.magic = 0;  // Do not retry a poisoned session
+    return 0;
+  }
+
+  lastResumed_ = offered && !certVerified_;
+  if (lastResumed_) {
+    stats_.resumedCount++;
+    stats_.lastResumedMs = elapsed;
+    stats_.totalResumedMs += elapsed;
+  } else {
+    stats_.fullCount++;
+    stats_.lastFullMs = elapsed;
+    stats_.totalFullMs += elapsed;
+    saveSession(port);
+  }
+  Serial.printf("TLS %s handshake: %lu ms (%s)\n", lastResumed_ ? "resumed" : "full",
+                (unsigned long)elapsed, mbedtls_ssl_get_ciphersuite(&ssl_));
+  connected_ = true;
+  return 1;
+}
+
+int TlsSessionClient::connect(IPAddress ip, uint16_t port) {
+  if (!ready_) return 0;
+  stop();
+  if (!transport_.connect(ip, port)) return 0;
+  if (!handshake(port)) {
+    transport_.stop();
+    return 0;
+  }
+  return 1;
+}
+
+int TlsSessionClient::connect(const char* host, uint16_t port) {
+  if (!ready_) return 0;
+  if (!hostname_) hostname_ = host;
+  stop();
+  if (!transport_.connect(host, port)) return 0;
+  if (!handshake(port)) {
+    transport_.stop();
+    return 0;
+  }
+  return 1;
+}
+
+// ------------------------------------------------------------------
+// --- Client stream interface ---
+// ------------------------------------------------------------------
+size_t TlsSessionClient::write(uint8_t b) { return write(&b, 1); }
+
+size_t TlsSessionClient::write(const uint8_t* buf, size_t size) {
+  if (!connected_) return 0;
+  size_t sent = 0;
+  uint32_t lastProgress = millis();
+  while (sent < size) {
+    int rc = mbedtls_ssl_write(&ssl_, buf + sent, size - sent);
+    if (rc > 0) {
+      sent += rc;
+      lastProgress = millis();
+    } else if (rc != MBEDTLS_ERR_SSL_WANT_READ && rc != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      stop();
+      break;
+    } else if (millis() - lastProgress > TLS_WRITE_TIMEOUT_MS) {
+      // The peer stopped reading; give up before the task watchdog does
+      Serial.printf("TLS write stalled for %u ms; dropping connection\n", TLS_WRITE_TIMEOUT_MS);
+      stop();
+      break;
+    } else {
+      vTaskDelay(1);
+    }
+  }
+  return sent;
+}
+
+int TlsSessionClient::available() {
+  if (!connected_) return 0;
+  int pending = peeked_ >= 0 ? 1 : 0;
+  if (mbedtls_ssl_get_bytes_avail(&ssl_) == 0 && transport_.available() > 0) {
+    // Pull the next record through the decryptor without consuming data
+    int rc = mbedtls_ssl_read(&ssl_, nullptr, 0);
+    if (rc < 0 && rc != MBEDTLS_ERR_SSL_WANT_READ && rc != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      stop();
+      return pending;
+    }
+  }
+  return pending + (int)mbedtls_ssl_get_bytes_avail(&ssl_);
+}
+
+int TlsSessionClient::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int TlsSessionClient::read(uint8_t* buf, size_t size) {
+  if (!connected_ || size == 0) return -1;
+  size_t got = 0;
+  if (peeked_ >= 0) {
+    buf[got++] = (uint8_t)peeked_;
+    peeked_ = -1;
+    if (got == size) return got;
+  }
+  int rc = mbedtls_ssl_read(&ssl_, buf + got, size - got);
+  if (rc > 0) return got + rc;
+  if (rc == 0 || (rc != MBEDTLS_ERR_SSL_WANT_READ && rc != MBEDTLS_ERR_SSL_WANT_WRITE)) stop();
+  return got > 0 ? (int)got : -1;
+}
+
+int TlsSessionClient::peek() {
+  if (peeked_ < 0) {
+    uint8_t b;
+    if (read(&b, 1) == 1) peeked_ = b;
+  }
+  return peeked_;
+}
+
+void TlsSessionClient::flush() { transport_.flush(); }
+
+void TlsSessionClient::stop() {
+  if (connected_) mbedtls_ssl_close_notify(&ssl_);
+  connected_ = false;
+  peeked_ = -1;
+  transport_.stop();
+}
+
+uint8_t TlsSessionClient::connected() {
+  if (connected_ && !transport_.connected() && mbedtls_ssl_get_bytes_avail(&ssl_) == 0) {
+    connected_ = false;
+  }
+  return connected_;
+}
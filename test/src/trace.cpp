@@ -0,0 +1,48 @@
+#include "trace.h"
+
+#include <string.h>
+
+static uint16_t getU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint32_t getU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float getF32(const uint8_t* p) {
+  uint32_t bits = getU32(p);
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+bool TraceReader::begin(TraceReadFn read, void* ctx, uint32_t sizeBytes) {
+  read_ = nullptr;
+  count_ = 0;
+  position_ = 0;
+  uint8_t header[TRACE_HEADER_BYTES];
+  if (sizeBytes < TRACE_HEADER_BYTES || !read(ctx, 0, header, sizeof(header))) return false;
+  if (memcmp(header, TRACE_MAGIC, 4) != 0) return false;
+  if (getU16(header + 4) != TRACE_VERSION || getU16(header + 6) != TRACE_RECORD_BYTES) return false;
+  uint32_t count = getU32(header + 8);
+  if (count > (sizeBytes - TRACE_HEADER_BYTES) / TRACE_RECORD_BYTES) return false;
+  read_ = read;
+  ctx_ = ctx;
+  count_ = count;
+  return true;
+}
+
+bool TraceReader::next(TraceRecord& rec) {
+  if (!read_ || position_ >= count_) return false;
+  uint8_t buf[TRACE_RECORD_BYTES];
+  uint32_t offset = TRACE_HEADER_BYTES + position_ * TRACE_RECORD_BYTES;
+  if (!read_(ctx_, offset, buf, sizeof(buf))) return false;
+  rec.offsetMs = getU32(buf);
+  rec.readings.temperature = getF32(buf + 4);
+  rec.readings.humidity = getF32(buf + 8);
+  rec.readings.ldrAnalog = getU16(buf + 12);
+  rec.readings.noxRaw = getU16(buf + 14);
+  rec.readings.ldrDigital = buf[16];
+  rec.readings.pir = buf[17];
+  position_++;
+  return true;
+}
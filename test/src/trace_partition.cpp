@@ -0,0 +1,14 @@
+#include "trace_partition.h"
+
+#include <esp_partition.h>
+
+static bool readPartition(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+  return esp_partition_read((const esp_partition_t*)ctx, offset, buf, len) == ESP_OK;
+}
+
+bool tracePartitionBegin(TraceReader& reader) {
+  const esp_partition_t* part = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)TRACE_PARTITION_SUBTYPE, TRACE_PARTITION_LABEL);
+  if (!part) return false;
+  return reader.begin(readPartition, (void*)part, part->size);
+}
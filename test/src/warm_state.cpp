@@ -0,0 +1,107 @@
+#include "warm_state.h"
+
+#include <esp_rom_crc.h>
+
+#define WARM_STATE_MAGIC 0x57524D31   // "WRM1"
+#define WARM_STATE_VERSION 1
+
+struct WarmRecord {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  WarmState state;
+  uint32_t crc;
+};
+
+RTC_NOINIT_ATTR static WarmRecord rtcRecord;
+static WarmState restored;
+static portMUX_TYPE warmMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t recordCrc(const WarmRecord& r) {
+  return esp_rom_crc32_le(0, (const uint8_t*)&r, offsetof(WarmRecord, crc));
+}
+
+// Caller holds warmMux
+static void seal() {
+  rtcRecord.crc = recordCrc(rtcRecord);
+}
+
+bool warmStateBegin() {
+  bool valid = rtcRecord.magic == WARM_STATE_MAGIC && rtcRecord.version == WARM_STATE_VERSION &&
+               rtcRecord.size == sizeof(WarmRecord) && rtcRecord.crc == recordCrc(rtcRecord);
+  portENTER_CRITICAL(&warmMux);
+  if (valid) {
+    restored = rtcRecord.state;
+    rtcRecord.state.bootCount++;
+  } else {
+    memset(&restored, 0, sizeof(restored));
+    memset(&rtcRecord, 0, sizeof(rtcRecord));
+    rtcRecord.magic = WARM_STATE_MAGIC;
+    rtcRecord.version = WARM_STATE_VERSION;
+    rtcRecord.size = sizeof(WarmRecord);
+    rtcRecord.state.bootCount = 1;
+  }
+  seal();
+  portEXIT_CRITICAL(&warmMux);
+  return valid;
+}
+
+const WarmState& warmStateRestored() { return restored; }
+
+void warmStateSaveSample(const SensorSample& sample, uint32_t nextSeq) {
+  portENTER_CRITICAL(&warmMux);
+  rtcRecord.state.lastSample = sample;
+  rtcRecord.state.haveSample = true;
+  rtcRecord.state.sampleSeq = nextSeq;
+  seal();
+  portEXIT_CRITICAL(&warmMux);
+}
+
+void warmStateSaveText(uint8_t slot, const char* text) {
+  if (slot >= WARM_TEXT_SLOTS) return;
+  portENTER_CRITICAL(&warmMux);
+  strncpy(rtcRecord.state.text[slot], text, WARM_TEXT_MAX);
+  rtcRecord.state.text[slot][WARM_TEXT_MAX] = '\0';
+  seal();
+  portEXIT_CRITICAL(&warmMux);
+}
+
+void warmStateSaveUrgency(const LedEffect& effect) {
+  portENTER_CRITICAL(&warmMux);
+  rtcRecord.state.urgency = effect;
+  rtcRecord.state.haveUrgency = true;
+  seal();
+  portEXIT_CRITICAL(&warmMux);
+}
+
+void warmStateSaveWifi(uint8_t channel, const uint8_t* bssid) {
+  portENTER_CRITICAL(&warmMux);
+  rtcRecord.state.wifiChannel = bssid ? channel : 0;
+  if (bssid) memcpy(rtcRecord.state.wifiBssid, bssid, sizeof(rtcRecord.state.wifiBssid));
+  seal();
+  portEXIT_CRITICAL(&warmMux);
+}
+
+void warmStateSaveLocalBroker(const WarmBrokerHint* hint) {
+  portENTER_CRITICAL(&warmMux);
+  rtcRecord.state.haveLocalBroker = hint != nullptr;
+  if (hint) rtcRecord.state.localBroker = *hint;
+  seal();
+  portEXIT_CRITICAL(&warmMux);
+}
+
+const char* resetReasonName(esp_reset_reason_t reason) {
+  switch (reason) {
+    case ESP_RST_POWERON:   return "poweron";
+    case ESP_RST_EXT:       return "external";
+    case ESP_RST_SW:        return "software";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:   return "int_wdt";
+    case ESP_RST_TASK_WDT:  return "task_wdt";
+    case ESP_RST_WDT:       return "wdt";
+    case ESP_RST_DEEPSLEEP: return "deepsleep";
+    case ESP_RST_BROWNOUT:  return "brownout";
+    case ESP_RST_SDIO:      return "sdio";
+    default:                return "unknown";
+  }
+}
@@ -0,0 +1,122 @@
+#include "wire.h"
+
+#include <pb_decode.h>
+#include <pb_encode.h>
+#include <stdio.h>
+
+size_t wireEncodeSample(const SensorSample& s, uint8_t* buf, size_t len) {
+  auralink_Uplink msg = auralink_Uplink_init_zero;
+  msg.schema = WIRE_SCHEMA_VERSION;
+  msg.has_reading = true;
+  msg.reading.seq = s.seq;
+  msg.reading.timestamp_ms = s.timestampMs;
+  msg.reading.temperature = s.temperature;
+  msg.reading.humidity = s.humidity;
+  msg.reading.light_percent = s.lightPercent;
+  msg.reading.nox_percent = s.noxPercent;
+  msg.reading.pir = s.pir != 0;
+
+  pb_ostream_t stream = pb_ostream_from_buffer(buf, len);
+  if (!pb_encode(&stream, auralink_Uplink_fields, &msg)) return 0;
+  return stream.bytes_written;
+}
+
+struct WireSpan {
+  const uint8_t* data;
+  size_t len;
+  bool seen;
+};
+
+// Records where a length-delimited field sits in the payload and skips
+// it. Only valid for buffer streams, whose state is the read position.
+static bool spanField(pb_istream_t* stream, const pb_field_t*, void** arg) {
+  WireSpan* span = (WireSpan*)*arg;
+  span->data = (const uint8_t*)stream->state;
+  span->len = stream->bytes_left;
+  span->seen = true;
+  return pb_read(stream, NULL, stream->bytes_left);
+}
+
+static void fail(char* err, size_t errLen, const char* reason) {
+  if (err && errLen) snprintf(err, errLen, "%s", reason);
+}
+
+bool wireDecodeDownlink(const uint8_t* payload, size_t len, WireDownlink& out,
+                        char* err, size_t errLen) {
+  WireSpan quote = {}, summary = {}, rules = {}, capture = {};
+  auralink_Downlink msg = auralink_Downlink_init_zero;
+  msg.quote.text.funcs.decode = spanField;
+  msg.quote.text.arg = &quote;
+  msg.summary.text.funcs.decode = spanField;
+  msg.summary.text.arg = &summary;
+  msg.rules.funcs.decode = spanField;
+  msg.rules.arg = &rules;
+  msg.capture.funcs.decode = spanField;
+  msg.capture.arg = &capture;
+
+  pb_istream_t stream = pb_istream_from_buffer(payload, len);
+  if (!pb_decode(&stream, auralink_Downlink_fields, &msg)) {
+    fail(err, errLen, PB_GET_ERROR(&stream));
+    return false;
+  }
+  if (msg.schema == auralink_SchemaVersion_SCHEMA_UNSPECIFIED || msg.schema > WIRE_SCHEMA_VERSION) {
+    fail(err, errLen, "unsupported schema");
+    return false;
+  }
+
+  out = WireDownlink();
+  out.schema = (uint8_t)msg.schema;
+  // The body oneof has no which_body here (no_unions), so count members.
+  // protoc senders emit at most one; a payload with several is rejected
+  // rather than resolved last-wins.
+  uint8_t bodies = 0;
+  const auralink_DisplayText* text = NULL;
+  const WireSpan* span = NULL;
+  if (msg.has_quote) {
+    out.kind = WIRE_DOWNLINK_QUOTE;
+    text = &msg.quote;
+    span = &quote;
+    bodies++;
+  }
+  if (msg.has_summary) {
+    out.kind = WIRE_DOWNLINK_SUMMARY;
+    text = &msg.summary;
+    span = &summary;
+    bodies++;
+  }
+  if (msg.has_urgency) {
+    out.kind = WIRE_DOWNLINK_URGENCY;
+    out.urgency = msg.urgency.level;
+    bodies++;
+  }
+  if (rules.seen) {
+    out.kind = WIRE_DOWNLINK_RULES;
+    span = &rules;
+    bodies++;
+  }
+  if (capture.seen) {
+    out.kind = WIRE_DOWNLINK_CAPTURE;
+    span = &capture;
+    bodies++;
+  }
+  if (bodies != 1) {
+    fail(err, errLen, bodies ? "several bodies" : "no body");
+    return false;
+  }
+
+  if (span) {
+    out.data = span->data;
+    out.len = span->len;
+  }
+  if (text && text->count > 0) {
+    if (text->index >= text->count) {
+      fail(err, errLen, "chunk index out of range");
+      return false;
+    }
+    out.chunked = true;
+    out.chunk.msgId = text->msg_id;
+    out.chunk.index = text->index;
+    out.chunk.count = text->count;
+  }
+  return true;
+}
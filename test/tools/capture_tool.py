@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Receive and decode raw ADC captures (see include/capture_codec.h).
+
+  capture_tool.py receive tcp --port 9000 capture.bin   # then: start tcp://<this-ip>:9000
+  capture_tool.py receive udp --port 9000 capture.bin   # then: start udp://<this-ip>:9000
+  capture_tool.py fetch http://<device>/capture capture.bin   # after: start file
+  capture_tool.py to-csv capture.bin capture.csv
+
+Start a capture by publishing to auralink/device/capture, e.g.
+  mosquitto_pub -t auralink/device/capture -m "start udp://192.168.1.10:9000 rate=4000 secs=30"
+"""
+
+import argparse
+import csv
+import socket
+import struct
+import sys
+import urllib.request
+
+HEADER = struct.Struct("<2sBBIIIHH")
+VERSION = 1
+CHANNEL_NAMES = ["ldr_raw", "nox_raw"]
+
+
+def decode_block(data, offset=0):
+    """Returns (header dict, per-channel value lists, block size)."""
+    magic, version, channels, rate, first, dropped, frames, payload = HEADER.unpack_from(data, offset)
+    if magic != b"AC" or version != VERSION:
+        raise ValueError(f"bad block header at offset {offset}")
+    pos = offset + HEADER.size
+    end = pos + payload
+    if end > len(data):
+        raise ValueError(f"truncated block at offset {offset}")
+    values = []
+    for _ in range(channels):
+        (v,) = struct.unpack_from("<H", data, pos)
+        pos += 2
+        column = [v]
+        for _ in range(frames - 1):
+            zz = shift = 0
+            while True:
+                b = data[pos]
+                pos += 1
+                zz |= (b & 0x7F) << shift
+                shift += 7
+                if not b & 0x80:
+                    break
+            v += (zz >> 1) ^ -(zz & 1)
+            column.append(v)
+        values.append(column)
+    if pos != end:
+        raise ValueError(f"block at offset {offset} does not match its length")
+    header = {"channels": channels, "rate": rate, "first": first, "dropped": dropped, "frames": frames}
+    return header, values, end - offset
+
+
+def iter_blocks(data):
+    offset = 0
+    while offset < len(data):
+        header, values, size = decode_block(data, offset)
+        yield header, values
+        offset += size
+
+
+def to_csv(args):
+    with open(args.input, "rb") as f:
+        data = f.read()
+    expected = frames = lost = 0
+    dropped = 0
+    with open(args.output, "w", newline="") as out:
+        w = csv.writer(out)
+        for n, (h, values) in enumerate(iter_blocks(data)):
+            if n == 0:
+                w.writerow(["frame", "time_s"] + CHANNEL_NAMES[: h["channels"]])
+            # Gaps in the frame index are blocks lost in transit or dropped
+            # on the device; rows keep their true frame number and time
+            if h["first"] > expected:
+                lost += h["first"] - expected
+            for i in range(h["frames"]):
+                frame = h["first"] + i
+                w.writerow([frame, f"{frame / h['rate']:.6f}"] + [col[i] for col in values])
+            frames += h["frames"]
+            expected = h["first"] + h["frames"]
+            dropped = h["dropped"]
+    print(f"{args.output}: {frames} frames, {lost} missing ({dropped} dropped on the device), "
+          f"{len(data)} bytes = {frames * 4 / max(len(data), 1):.2f}x vs raw")
+
+
+def receive(args):
+    with open(args.output, "wb") as out:
+        total = 0
+        try:
+            if args.proto == "udp":
+                s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+                s.bind(("", args.port))
+                print(f"listening on udp/{args.port}, Ctrl-C to stop")
+                while True:
+                    block = s.recv(65535)
+                    out.write(block)
+                    total += len(block)
+            else:
+                srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+                srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+                srv.bind(("", args.port))
+                srv.listen(1)
+                print(f"listening on tcp/{args.port}")
+                conn, peer = srv.accept()
+                print(f"capture from {peer[0]}")
+                while True:
+                    chunk = conn.recv(65536)
+                    if not chunk:
+                        break
+                    out.write(chunk)
+                    total += len(chunk)
+        except KeyboardInterrupt:
+            pass
+    print(f"{args.output}: {total} bytes")
+
+
+def fetch(args):
+    with urllib.request.urlopen(args.url) as r, open(args.output, "wb") as out:
+        data = r.read()
+        out.write(data)
+    print(f"{args.output}: {len(data)} bytes")
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = p.add_subparsers(dest="cmd", required=True)
+    s = sub.add_parser("receive")
+    s.add_argument("proto", choices=["tcp", "udp"])
+    s.add_argument("--port", type=int, default=9000)
+    s.add_argument("output")
+    s.set_defaults(fn=receive)
+    s = sub.add_parser("fetch")
+    s.add_argument("url")
+    s.add_argument("output")
+    s.set_defaults(fn=fetch)
+    s = sub.add_parser("to-csv")
+    s.add_argument("input")
+    s.add_argument("output")
+    s.set_defaults(fn=to_csv)
+    args = p.parse_args()
+    try:
+        args.fn(args)
+    except ValueError as e:
+        sys.exit(str(e))
+
+
+if __name__ == "__main__":
+    main()
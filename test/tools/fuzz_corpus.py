@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""Seed corpus for the native fuzzers (src/native/fuzz/, env fuzz-*).
+
+  fuzz_corpus.py seed [--out fuzz/corpus]
+  fuzz_corpus.py record [--host H] [--port P] [--count N] [--out fuzz/corpus]
+
+`seed` runs the backend's own downlink code (backend/downlink.py,
+backend/wire.py) against a recording client, in both the protobuf and
+the text format, and adds the default rule program, capture commands
+and a few known edge cases. So the seeds are the exact bytes the
+backend puts on the wire.
+
+`record` subscribes to every downlink topic on a live broker and saves
+what it sees, for example while backend/main.py runs against a test
+device. Each message is saved to dispatch/ and to the corpus of the
+parser that owns it.
+
+Files are named by content hash, so reruns only add new inputs. The
+bin-* inputs are compiled rule programs (rulesSaveBinary output) and are
+kept as-is.
+
+Per-target formats:
+  rules, capture, wire   the raw payload
+  text, dispatch         message records, see fuzz_text.cpp / fuzz_dispatch.cpp
+"""
+
+import argparse
+import hashlib
+import os
+import re
+import struct
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+PROJECT = os.path.dirname(HERE)
+sys.path.insert(0, os.path.join(PROJECT, "..", "backend"))
+
+import downlink  # noqa: E402
+import wire  # noqa: E402
+
+TOPIC_RULES_SET = "auralink/rules/set"
+TOPIC_CAPTURE_CONTROL = "auralink/device/capture"
+TEXT_TOPICS = (downlink.TOPIC_DISPLAY_QUOTE, downlink.TOPIC_DISPLAY_SUMMARY)
+
+LONG_SUMMARY = (
+    "Your manager moved the Q3 report deadline to Friday and wants a preliminary draft by end of day "
+    "tomorrow — “all hands on deck”. Newsletter: generative models, RL deep dive, "
+    "new vision dataset… Mom asks about dinner on Saturday."
+)
+QUOTES = (
+    "The air hung warm and heavy, as if the afternoon itself were holding its breath.",
+    "Cool and dry, the room waited like a blank page.",
+    "",
+)
+CAPTURE_COMMANDS = (
+    "start file",
+    "start file rate=8000 secs=30",
+    "start tcp://192.168.1.20:9000 rate=20000 secs=3600",
+    "start udp://10.0.0.2:5005",
+    "stop",
+    "start tcp://999.1.1.1:80",
+    "start file rate=0",
+)
+RULE_EDGE_CASES = (
+    "# only a comment\n",
+    "temp > 30 -> publish 31\nhum < 20 -> alert 0\n",
+    "!(temp > 20 && (hum < 40 || light >= 10)) -> led urgency pulse 100 3 900\n",
+    "nox > 60 -> led nox breathe 2000\n",
+    "((((((((temp > 1)))))))) -> led temp on\n",
+    "temp > -> led temp on\n",
+)
+
+
+def default_rules():
+    """The firmware's default program, from src/default_rules.cpp."""
+    with open(os.path.join(PROJECT, "src", "default_rules.cpp")) as f:
+        source = f.read()
+    body = source[source.index("defaultRules[] ="):]
+    return "".join(bytes(s, "utf-8").decode("unicode_escape") for s in re.findall(r'"((?:[^"\\]|\\.)*)"', body))
+
+
+class Recorder:
+    """Stands in for the paho client in the backend's publish helpers."""
+
+    def __init__(self):
+        self.messages = []
+
+    def publish(self, topic, payload, qos=0):
+        if isinstance(payload, str):
+            payload = payload.encode("utf-8")
+        self.messages.append((topic, bytes(payload)))
+
+
+def record_bytes(topic, payload):
+    """One dispatch/text record: see fuzz_dispatch.cpp."""
+    return topic.encode() + b"\0" + struct.pack("<H", len(payload)) + payload
+
+
+def text_record(topic, payload):
+    return bytes([len(topic)]) + topic.encode() + struct.pack("<H", len(payload)) + payload
+
+
+class Corpus:
+    def __init__(self, out):
+        self.out = out
+        self.added = 0
+
+    def add(self, target, data, prefix="seed"):
+        directory = os.path.join(self.out, target)
+        os.makedirs(directory, exist_ok=True)
+        path = os.path.join(directory, f"{prefix}-{hashlib.sha1(data).hexdigest()[:12]}")
+        if not os.path.exists(path):
+            with open(path, "wb") as f:
+                f.write(data)
+            self.added += 1
+
+    def add_message(self, topic, payload, prefix="seed"):
+        """A message into dispatch/ and into the corpus of the parser that owns its topic."""
+        self.add("dispatch", record_bytes(topic, payload), prefix)
+        if topic == wire.TOPIC_DOWNLINK:
+            self.add("wire", payload, prefix)
+        elif topic == TOPIC_RULES_SET:
+            self.add("rules", payload, prefix)
+        elif topic == TOPIC_CAPTURE_CONTROL:
+            self.add("capture", payload, prefix)
+        elif topic.startswith(TEXT_TOPICS):
+            self.add("text", text_record(topic, payload), prefix)
+
+    def add_conversation(self, messages, prefix="seed"):
+        """A whole sequence (e.g. every chunk of one text) as one input."""
+        self.add("dispatch", b"".join(record_bytes(t, p) for t, p in messages), prefix)
+        texts = [(t, p) for t, p in messages if t.startswith(TEXT_TOPICS)]
+        if texts:
+            self.add("text", b"".join(text_record(t, p) for t, p in texts), prefix)
+
+
+def seed(out):
+    corpus = Corpus(out)
+    for fmt in ("protobuf", "text"):
+        downlink.DOWNLINK_FORMAT = fmt
+        for kind, text in [("quote", q) for q in QUOTES] + [("summary", LONG_SUMMARY)]:
+            client = Recorder()
+            downlink.publish_display(client, kind, text, chunk_bytes=64)
+            for topic, payload in client.messages:
+                corpus.add_message(topic, payload)
+            corpus.add_conversation(client.messages)
+        for level in ("LOW", "MEDIUM", "HIGH"):
+            client = Recorder()
+            downlink.publish_urgency(client, level)
+            corpus.add_message(*client.messages[0])
+
+    rules = [default_rules()] + list(RULE_EDGE_CASES)
+    for program in rules:
+        data = program.encode()
+        corpus.add_message(TOPIC_RULES_SET, data)
+        corpus.add_message(wire.TOPIC_DOWNLINK, wire.encode_rules(data))
+    for command in CAPTURE_COMMANDS:
+        corpus.add_message(TOPIC_CAPTURE_CONTROL, command.encode())
+        msg = wire.pb.Downlink(schema=wire.SCHEMA_VERSION, capture=command)
+        corpus.add_message(wire.TOPIC_DOWNLINK, msg.SerializeToString())
+
+    # Out of order, duplicated and foreign chunks
+    quote = downlink.TOPIC_DISPLAY_QUOTE
+    corpus.add_conversation([
+        (f"{quote}/chunk/7/0/3", b"first "),
+        (f"{quote}/chunk/7/2/3", b"third"),
+        (f"{quote}/chunk/8/1/3", b"other message"),
+        (f"{quote}/chunk/7/1/3", b"second "),
+    ])
+    corpus.add_conversation([(f"{quote}/chunk/1/0/1", b"\xe2\x80"), (quote, b"\xff\xfe\x00tail")])
+    # Schema version the firmware must reject
+    corpus.add_message(wire.TOPIC_DOWNLINK, wire.pb.Downlink(schema=2, rules=b"x").SerializeToString())
+    print(f"{corpus.added} new seed inputs in {out}")
+
+
+def record(out, host, port, count):
+    import paho.mqtt.client as mqtt
+
+    corpus = Corpus(out)
+    seen = [0]
+
+    def on_connect(client, userdata, flags, rc):
+        for topic in (wire.TOPIC_DOWNLINK, TOPIC_RULES_SET, TOPIC_CAPTURE_CONTROL, downlink.TOPIC_URGENCY_LED):
+            client.subscribe(topic, qos=1)
+        for topic in TEXT_TOPICS:
+            client.subscribe(topic, qos=1)
+            client.subscribe(topic + "/chunk/#", qos=1)
+
+    def on_message(client, userdata, msg):
+        corpus.add_message(msg.topic, msg.payload, prefix="rec")
+        seen[0] += 1
+        if seen[0] >= count:
+            client.disconnect()
+
+    client = mqtt.Client(client_id="auralink-fuzz-recorder")
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(host, port)
+    print(f"Recording {count} downlinks from {host}:{port} (Ctrl-C to stop early)")
+    try:
+        client.loop_forever()
+    except KeyboardInterrupt:
+        pass
+    print(f"{corpus.added} new inputs from {seen[0]} messages in {out}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("seed", help="seeds from the backend's downlink code")
+    p.add_argument("--out", default=os.path.join(PROJECT, "fuzz", "corpus"))
+    p = sub.add_parser("record", help="seeds from live downlink traffic")
+    p.add_argument("--out", default=os.path.join(PROJECT, "fuzz", "corpus"))
+    p.add_argument("--host", default="127.0.0.1")
+    p.add_argument("--port", type=int, default=1883)
+    p.add_argument("--count", type=int, default=200)
+    args = parser.parse_args()
+    if args.command == "seed":
+        seed(args.out)
+    else:
+        record(args.out, args.host, args.port, args.count)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""Static RAM/flash footprint from a GNU ld map file, per library and per symbol.
+
+  mem_report.py .pio/build/esp32doit-devkit-v1/firmware.map
+  mem_report.py firmware.map --top 30 --json report.json
+  mem_report.py firmware.map --budget dram=96000 --budget iram=100000 \\
+                             --lib-budget PubSubClient=4096
+
+Exits 1 when a budget is exceeded. extra_script.py runs it as the
+`memreport` target and after every link (see platformio.ini).
+
+Regions (ESP32, from the output section an input section landed in):
+  iram   .iram0.*                     instruction RAM
+  dram   .dram0.data, .dram0.bss, .noinit   static data RAM (heap is what is left)
+  rtc    .rtc.*, .rtc_noinit          RTC slow/fast memory
+  flash  .flash.*, plus the .dram0.data and .iram0 images copied out of it at boot
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+from collections import defaultdict
+
+REGIONS = ("iram", "dram", "rtc", "flash")
+
+# Sections whose content is also stored in flash and copied at boot
+_LOADED_FROM_FLASH = ("iram", "dram_data", "rtc_data")
+
+_SIZE_LINE = re.compile(r"^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*)$")
+_INPUT_LINE = re.compile(r"^ (\.\S+|COMMON)(?:\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*))?$")
+_OUTPUT_LINE = re.compile(r"^(\.\S+)(?:\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+))?")
+_SYMBOL_LINE = re.compile(r"^\s+0x[0-9a-fA-F]+\s+([A-Za-z_][\w.$]*)\s*$")
+_ARCHIVE = re.compile(r"(?:^|[\\/])lib([^\\/]+)\.a\((.+)\)$")
+
+# Prefixes -ffunction-sections/-fdata-sections put in front of the symbol
+_SECTION_PREFIXES = (
+    ".text.", ".literal.", ".rodata.", ".data.", ".bss.", ".sbss.", ".sdata.",
+    ".iram1.", ".dram1.", ".rtc.text.", ".rtc.data.", ".rtc.bss.", ".noinit.",
+)
+
+
+def classify(output_section):
+    """Maps an output section to (region, kind) or None when it takes no memory."""
+    s = output_section
+    if s.startswith(".iram0"):
+        return "iram", "iram"
+    if s in (".dram0.data",):
+        return "dram", "dram_data"
+    if s in (".dram0.bss", ".noinit", ".dram0.noinit"):
+        return "dram", "dram_bss"
+    if s.startswith(".rtc") and ("bss" in s or "noinit" in s):
+        return "rtc", "rtc_bss"
+    if s.startswith(".rtc"):
+        return "rtc", "rtc_data"
+    if s.startswith(".flash") and "noload" not in s:
+        return "flash", "flash"
+    return None
+
+
+def owner(path):
+    """Library (or source file) an object file belongs to."""
+    path = path.strip()
+    m = _ARCHIVE.search(path)
+    if m:
+        return m.group(1)
+    norm = path.replace("\\", "/")
+    if "/src/" in norm:
+        return "src/" + norm.split("/src/", 1)[1].replace(".o", "")
+    return os.path.basename(norm)
+
+
+def symbol_name(section):
+    for prefix in _SECTION_PREFIXES:
+        if section.startswith(prefix):
+            return section[len(prefix):]
+    # .literal/.text etc. without a per-function suffix: the whole object
+    return None
+
+
+def parse_map(text):
+    """Returns [region, kind, library, symbol, size] for every sized input section."""
+    entries = []
+    in_map = False
+    output = None
+    pending = None   # Long input section name whose address/size is on the next line
+    unnamed = None   # Last entry, while its section name says nothing (.iram1.5)
+
+    def add(name, path, size):
+        sym = symbol_name(name)
+        if sym is None or sym.isdigit():
+            sym = None
+        entry = [output[0], output[1], owner(path), sym or owner(path), size]
+        entries.append(entry)
+        return None if sym else entry
+
+    for line in text.splitlines():
+        if not in_map:
+            in_map = line.startswith("Linker script and memory map")
+            continue
+        if not line.strip():
+            continue
+        if not line.startswith(" "):
+            m = _OUTPUT_LINE.match(line)
+            output = classify(m.group(1)) if m else None
+            pending = unnamed = None
+            continue
+        if output is None:
+            continue
+        if pending is not None:
+            m = _SIZE_LINE.match(line)
+            name, pending = pending, None
+            if m and int(m.group(2), 16):
+                unnamed = add(name, m.group(3), int(m.group(2), 16))
+            continue
+        m = _SYMBOL_LINE.match(line)
+        if m:
+            # First symbol inside an anonymous section names it
+            if unnamed is not None:
+                unnamed[3] = m.group(1)
+                unnamed = None
+            continue
+        m = _INPUT_LINE.match(line)
+        if not m:
+            continue
+        name, addr, size, path = m.groups()
+        if size is None:
+            pending = name
+            continue
+        unnamed = None
+        if int(size, 16) and not path.startswith("load address"):
+            unnamed = add(name, path, int(size, 16))
+    return entries
+
+
+def build_report(text):
+    libs = defaultdict(lambda: dict.fromkeys(REGIONS, 0))
+    symbols = {r: defaultdict(int) for r in REGIONS}
+    totals = dict.fromkeys(REGIONS, 0)
+    for region, kind, lib, sym, size in parse_map(text):
+        libs[lib][region] += size
+        symbols[region][(lib, sym)] += size
+        totals[region] += size
+        if region != "flash" and kind in _LOADED_FROM_FLASH:
+            libs[lib]["flash"] += size
+            totals["flash"] += size
+    return {"totals": totals, "libs": libs, "symbols": symbols}
+
+
+def print_report(report, top):
+    t = report["totals"]
+    print("Static memory: " + ", ".join(f"{r} {t[r]}" for r in REGIONS))
+    print()
+    print(f"{'library':<36}" + "".join(f"{r:>10}" for r in REGIONS))
+    libs = sorted(report["libs"].items(), key=lambda kv: -(kv[1]["dram"] + kv[1]["iram"]) * 4 - kv[1]["flash"])
+    for lib, sizes in libs[:top]:
+        print(f"{lib[:36]:<36}" + "".join(f"{sizes[r]:>10}" for r in REGIONS))
+    for region in ("dram", "iram"):
+        print()
+        print(f"Largest {region} symbols:")
+        ranked = sorted(report["symbols"][region].items(), key=lambda kv: -kv[1])
+        for (lib, sym), size in ranked[:top]:
+            print(f"  {size:>8}  {sym[:56]:<56} {lib}")
+
+
+def parse_budgets(items):
+    budgets = {}
+    for item in items or []:
+        key, _, value = item.partition("=")
+        if not value:
+            raise argparse.ArgumentTypeError(f"budget '{item}' is not key=bytes")
+        budgets[key.strip()] = int(value, 0)
+    return budgets
+
+
+def check_budgets(report, region_budgets, lib_budgets):
+    """Returns a list of human-readable violations (empty when within budget)."""
+    failures = []
+    for region, limit in region_budgets.items():
+        if region not in REGIONS:
+            failures.append(f"unknown region '{region}' in budget")
+            continue
+        used = report["totals"][region]
+        if used > limit:
+            failures.append(f"{region}: {used} bytes, budget {limit} (+{used - limit})")
+    for lib, limit in lib_budgets.items():
+        used = report["libs"].get(lib, {}).get("dram", 0) + report["libs"].get(lib, {}).get("iram", 0)
+        if used > limit:
+            failures.append(f"{lib}: {used} bytes of RAM, budget {limit} (+{used - limit})")
+    return failures
+
+
+def run(map_path, top=20, json_path=None, region_budgets=None, lib_budgets=None):
+    """Prints the report and returns the list of budget violations."""
+    with open(map_path, encoding="utf-8", errors="replace") as f:
+        report = build_report(f.read())
+    print_report(report, top)
+    if json_path:
+        with open(json_path, "w") as f:
+            json.dump({
+                "totals": report["totals"],
+                "libs": report["libs"],
+                "symbols": {r: [{"lib": lib, "symbol": sym, "size": size}
+                                for (lib, sym), size in sorted(s.items(), key=lambda kv: -kv[1])]
+                            for r, s in report["symbols"].items()},
+            }, f, indent=1)
+    failures = check_budgets(report, region_budgets or {}, lib_budgets or {})
+    for failure in failures:
+        print(f"MEMORY BUDGET EXCEEDED: {failure}")
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map", help="linker map file")
+    parser.add_argument("--top", type=int, default=20, help="rows per table")
+    parser.add_argument("--json", help="also write the full report here")
+    parser.add_argument("--budget", action="append", help="region=bytes (iram, dram, rtc, flash)")
+    parser.add_argument("--lib-budget", action="append", help="library=bytes of RAM (iram + dram)")
+    args = parser.parse_args()
+    failures = run(args.map, args.top, args.json, parse_budgets(args.budget), parse_budgets(args.lib_budget))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
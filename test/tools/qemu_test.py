@@ -0,0 +1,444 @@
+#!/usr/bin/env python3
+"""End-to-end firmware tests in Espressif's QEMU against a local mosquitto.
+
+  pio run -e esp32-qemu -t qemu-test          # builds, then runs this
+  qemu_test.py --build-dir .pio/build/esp32-qemu [--json results.json]
+
+The esp32-qemu build replays a synthetic trace (one sample per
+--period-ms) and reaches the host broker at 10.0.2.2 over the emulated
+OpenETH MAC (include/qemu_net.h). Needs qemu-system-xtensa from
+Espressif's fork (PATH or $QEMU_XTENSA), mosquitto, paho-mqtt and
+protobuf; nothing touches real hardware or the internet.
+
+Scenarios (--scenarios, default all):
+  cadence    uplink spacing, sequence gaps, broker throughput
+  downlink   protobuf rules/quote/urgency downlinks: round-trip and
+             delivery latency
+  reconnect  broker restart mid-run: time to reconnect, and every sample
+             taken during the outage arrives (singly or batched)
+
+Exits 1 if any scenario fails its checks.
+"""
+
+import argparse
+import json
+import math
+import os
+import queue
+import shutil
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, HERE)
+sys.path.insert(0, os.path.join(HERE, "..", "..", "backend"))
+
+import trace_tool  # noqa: E402
+
+try:
+    import paho.mqtt.client as mqtt
+    import wire
+    from series_codec import TOPIC_SENSOR_BATCH, decode_batch
+except ImportError as e:
+    sys.exit(f"qemu_test needs paho-mqtt and protobuf ({e})")
+
+FLASH_SIZE = 4 * 1024 * 1024
+BOOTLOADER_OFFSET = 0x1000
+PARTITIONS_OFFSET = 0x8000
+APP_OFFSET = 0x10000
+
+TOPIC_RULES_STATUS = "auralink/rules/status"
+TOPIC_DEVICE_HEALTH = "auralink/device/health"
+# Same program as src/default_rules.cpp, so the LEDs do not change mid-run
+DEFAULT_RULES = (
+    "nox <= 30 -> led nox off\n"
+    "nox > 60 -> led nox on\n"
+    "nox > 30 && nox <= 60 -> led nox blink 100\n"
+    "pir == 1 -> led pir blink 100\n"
+    "pir != 1 -> led pir off\n"
+    "temp > 30 || temp < 20 -> led temp blink 150\n"
+    "temp >= 20 && temp <= 30 -> led temp on\n"
+    "light > 50 -> led light off\n"
+    "light <= 50 -> led light on\n"
+)
+
+
+def percentile(values, p):
+    if not values:
+        return None
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(math.ceil(p / 100 * len(ordered))) - 1)]
+
+
+def summary(values, unit="ms"):
+    return {
+        "n": len(values),
+        f"p50_{unit}": percentile(values, 50),
+        f"p95_{unit}": percentile(values, 95),
+        f"max_{unit}": max(values) if values else None,
+    }
+
+
+# ------------------------------------------------------------------
+# --- Flash image: bootloader, partition table, app and a trace ---
+# ------------------------------------------------------------------
+def synthetic_trace(path, records, period_ms):
+    rows = []
+    for i in range(records):
+        phase = i / 60.0
+        rows.append((
+            i * period_ms,
+            22.0 + 3.0 * math.sin(phase),
+            45.0 + 10.0 * math.cos(phase / 2),
+            int(2048 + 1500 * math.sin(phase / 3)),
+            int(1200 + 800 * math.sin(phase / 5)),
+            1 if i % 40 < 20 else 0,
+            1 if i % 17 == 0 else 0,
+        ))
+    trace_tool.write_trace(path, rows)
+
+
+def build_flash(build_dir, trace_path, out_path):
+    image = bytearray(b"\xff" * FLASH_SIZE)
+
+    def place(offset, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if offset + len(data) > FLASH_SIZE:
+            sys.exit(f"{path} does not fit at {offset:#x}")
+        image[offset:offset + len(data)] = data
+
+    place(BOOTLOADER_OFFSET, os.path.join(build_dir, "bootloader.bin"))
+    place(PARTITIONS_OFFSET, os.path.join(build_dir, "partitions.bin"))
+    place(APP_OFFSET, os.path.join(build_dir, "firmware.bin"))
+    place(trace_tool.PARTITION_OFFSET, trace_path)
+    with open(out_path, "wb") as f:
+        f.write(image)
+
+
+# ------------------------------------------------------------------
+# --- Local broker (restartable, keeps the observer's session) ---
+# ------------------------------------------------------------------
+class Broker:
+    def __init__(self, workdir, port):
+        self.port = port
+        self.conf = os.path.join(workdir, "mosquitto.conf")
+        with open(self.conf, "w") as f:
+            f.write(
+                f"listener {port}\n"
+                "allow_anonymous true\n"
+                "persistence true\n"
+                f"persistence_location {workdir}/\n"
+                # The observer must not miss QoS 0 uplinks while it reconnects
+                "queue_qos0_messages true\n"
+                "max_queued_messages 10000\n"
+            )
+        self.proc = None
+
+    def start(self):
+        self.proc = subprocess.Popen(["mosquitto", "-c", self.conf],
+                                     stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        deadline = time.time() + 5
+        while time.time() < deadline:
+            try:
+                socket.create_connection(("127.0.0.1", self.port), 0.2).close()
+                return
+            except OSError:
+                time.sleep(0.05)
+        raise RuntimeError(f"mosquitto did not start on port {self.port}")
+
+    def stop(self):
+        if self.proc and self.proc.poll() is None:
+            self.proc.send_signal(signal.SIGTERM)   # Saves the persistent sessions
+            self.proc.wait(5)
+        self.proc = None
+
+
+# ------------------------------------------------------------------
+# --- Observer: every device message, timestamped on arrival ---
+# ------------------------------------------------------------------
+class Observer:
+    def __init__(self, port):
+        self.uplinks = []      # (t, seq, bytes, via_batch)
+        self.messages = 0
+        self.bytes = 0
+        self.status = queue.Queue()
+        self.health = None
+        self.lock = threading.Lock()
+        self.client = mqtt.Client(client_id="auralink-qemu-observer", clean_session=False)
+        self.client.on_connect = self._on_connect
+        self.client.on_message = self._on_message
+        self.client.reconnect_delay_set(0.2, 1)
+        self.client.connect("127.0.0.1", port)
+        self.client.loop_start()
+
+    def _on_connect(self, client, userdata, flags, rc):
+        client.subscribe("auralink/#", qos=1)
+
+    def _on_message(self, client, userdata, msg):
+        now = time.monotonic()
+        with self.lock:
+            self.messages += 1
+            self.bytes += len(msg.payload)
+            if msg.topic == wire.TOPIC_UPLINK:
+                try:
+                    reading = wire.decode_uplink(msg.payload)
+                    self.uplinks.append((now, reading["seq"], len(msg.payload), False))
+                except ValueError:
+                    pass
+            elif msg.topic == TOPIC_SENSOR_BATCH:
+                try:
+                    for s in decode_batch(msg.payload):
+                        self.uplinks.append((now, s["seq"], len(msg.payload), True))
+                except ValueError:
+                    pass
+            elif msg.topic == TOPIC_DEVICE_HEALTH:
+                try:
+                    self.health = json.loads(msg.payload)
+                except ValueError:
+                    pass
+        if msg.topic == TOPIC_RULES_STATUS:
+            self.status.put((now, msg.payload.decode("utf-8", "replace")))
+
+    def publish(self, topic, payload, qos=1):
+        self.client.publish(topic, payload, qos=qos)
+
+    def snapshot(self):
+        with self.lock:
+            return list(self.uplinks), self.messages, self.bytes
+
+    def close(self):
+        self.client.loop_stop()
+        self.client.disconnect()
+
+
+# ------------------------------------------------------------------
+# --- QEMU with the serial console captured line by line ---
+# ------------------------------------------------------------------
+class Device:
+    def __init__(self, qemu, flash_path, log_path):
+        self.lines = []   # (t, text)
+        self.cond = threading.Condition()
+        self.log = open(log_path, "w")
+        self.proc = subprocess.Popen(
+            [qemu, "-machine", "esp32", "-display", "none", "-monitor", "none", "-serial", "stdio",
+             "-no-reboot", "-drive", f"file={flash_path},if=mtd,format=raw",
+             "-nic", "user,model=open_eth"],
+            stdin=subprocess.DEVNULL, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        self.started = time.monotonic()
+        threading.Thread(target=self._read, daemon=True).start()
+
+    def _read(self):
+        for raw in self.proc.stdout:
+            text = raw.decode("utf-8", "replace").rstrip()
+            self.log.write(text + "\n")
+            with self.cond:
+                self.lines.append((time.monotonic(), text))
+                self.cond.notify_all()
+
+    def wait_line(self, needle, after, timeout):
+        """Time of the first line containing `needle` logged after `after`, or None."""
+        deadline = time.monotonic() + timeout
+        with self.cond:
+            while True:
+                for t, text in self.lines:
+                    if t >= after and needle in text:
+                        return t
+                remaining = deadline - time.monotonic()
+                if remaining <= 0 or self.proc.poll() is not None:
+                    return None
+                self.cond.wait(remaining)
+
+    def close(self):
+        if self.proc.poll() is None:
+            self.proc.kill()
+        self.proc.wait()
+        self.log.close()
+
+
+# ------------------------------------------------------------------
+# --- Scenarios ---
+# ------------------------------------------------------------------
+def wait_for_uplinks(observer, count, timeout):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        uplinks, _, _ = observer.snapshot()
+        if len(uplinks) >= count:
+            return True
+        time.sleep(0.1)
+    return False
+
+
+def seq_gaps(seqs):
+    missing = 0
+    ordered = sorted(set(seqs))
+    for a, b in zip(ordered, ordered[1:]):
+        missing += b - a - 1
+    return missing
+
+
+def scenario_cadence(args, device, observer, broker):
+    start_uplinks, start_msgs, start_bytes = observer.snapshot()
+    t0 = time.monotonic()
+    time.sleep(args.cadence_secs)
+    uplinks, msgs, nbytes = observer.snapshot()
+    elapsed = time.monotonic() - t0
+    window = [u for u in uplinks[len(start_uplinks):] if not u[3]]
+    intervals = [(b[0] - a[0]) * 1000 for a, b in zip(window, window[1:])]
+    gaps = seq_gaps([u[1] for u in window])
+    p95 = percentile(intervals, 95)
+    result = {
+        "uplinks": len(window),
+        "interval": summary(intervals),
+        "seq_gaps": gaps,
+        "broker_msgs_per_s": round((msgs - start_msgs) / elapsed, 2),
+        "broker_bytes_per_s": round((nbytes - start_bytes) / elapsed, 1),
+        "uplink_bytes_avg": round(sum(u[2] for u in window) / len(window), 1) if window else None,
+    }
+    tolerance = args.period_ms * args.cadence_tolerance
+    result["ok"] = bool(window) and gaps == 0 and p95 is not None and abs(p95 - args.period_ms) <= tolerance
+    return result
+
+
+def scenario_downlink(args, device, observer, broker):
+    rtts, deliveries = [], []
+    rules = DEFAULT_RULES.encode()
+    for _ in range(args.downlinks):
+        while not observer.status.empty():
+            observer.status.get_nowait()
+        sent = time.monotonic()
+        observer.publish(wire.TOPIC_DOWNLINK, wire.encode_rules(rules))
+        try:
+            t, status = observer.status.get(timeout=10)
+            if status.startswith("ok"):
+                rtts.append((t - sent) * 1000)
+        except queue.Empty:
+            pass
+        for payload in (wire.encode_text("quote", "QEMU says hello"), wire.encode_urgency("MEDIUM")):
+            sent = time.monotonic()
+            observer.publish(wire.TOPIC_DOWNLINK, payload)
+            t = device.wait_line(f"Message arrived [{wire.TOPIC_DOWNLINK}]", sent, 10)
+            if t is not None:
+                deliveries.append((t - sent) * 1000)
+        time.sleep(0.2)
+    result = {
+        "rules_round_trip": summary(rtts),
+        "delivery": summary(deliveries),
+        "lost": args.downlinks * 3 - len(rtts) - len(deliveries),
+    }
+    result["ok"] = result["lost"] == 0
+    return result
+
+
+def scenario_reconnect(args, device, observer, broker):
+    before, _, _ = observer.snapshot()
+    last_seq = max((u[1] for u in before), default=-1)
+    broker.stop()
+    stopped = time.monotonic()
+    time.sleep(args.outage_secs)
+    broker.start()
+    restarted = time.monotonic()
+    expected = int(args.outage_secs * 1000 / args.period_ms)
+    first_after = None
+    deadline = restarted + args.reconnect_timeout
+    while time.monotonic() < deadline:
+        uplinks, _, _ = observer.snapshot()
+        after = [u for u in uplinks if u[0] >= restarted]
+        if after and first_after is None:
+            first_after = after[0][0]
+        seqs = [u[1] for u in uplinks if u[1] > last_seq]
+        if seqs and max(seqs) - last_seq >= expected and seq_gaps([last_seq] + seqs) == 0:
+            break
+        time.sleep(0.2)
+    uplinks, _, _ = observer.snapshot()
+    recovered = [u for u in uplinks if u[1] > last_seq]
+    seqs = [u[1] for u in recovered]
+    result = {
+        "outage_s": args.outage_secs,
+        "reconnect_ms": round((first_after - restarted) * 1000) if first_after else None,
+        "samples_recovered": len(set(seqs)),
+        "via_batch": sum(1 for u in recovered if u[3]),
+        "seq_gaps": seq_gaps([last_seq] + seqs) if seqs else None,
+        "drain_ms": round((max(u[0] for u in recovered) - restarted) * 1000) if recovered else None,
+        "outage_started_s": round(stopped - device.started, 1),
+    }
+    result["ok"] = (first_after is not None and result["seq_gaps"] == 0
+                    and result["samples_recovered"] >= expected)
+    return result
+
+
+SCENARIOS = {
+    "cadence": scenario_cadence,
+    "downlink": scenario_downlink,
+    "reconnect": scenario_reconnect,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--build-dir", default=".pio/build/esp32-qemu")
+    parser.add_argument("--qemu", default=os.environ.get("QEMU_XTENSA", "qemu-system-xtensa"))
+    parser.add_argument("--port", type=int, default=1883, help="must match AURALINK_QEMU_BROKER_PORT")
+    parser.add_argument("--scenarios", default=",".join(SCENARIOS))
+    parser.add_argument("--period-ms", type=int, default=1000, help="trace sample spacing")
+    parser.add_argument("--records", type=int, default=900)
+    parser.add_argument("--boot-timeout", type=float, default=90)
+    parser.add_argument("--cadence-secs", type=float, default=30)
+    parser.add_argument("--cadence-tolerance", type=float, default=0.25, help="p95 interval error, fraction of the period")
+    parser.add_argument("--downlinks", type=int, default=10)
+    parser.add_argument("--outage-secs", type=float, default=15)
+    parser.add_argument("--reconnect-timeout", type=float, default=60)
+    parser.add_argument("--json", help="write results here")
+    args = parser.parse_args()
+
+    for tool in (args.qemu, "mosquitto"):
+        if not shutil.which(tool):
+            sys.exit(f"{tool} not found")
+    unknown = set(args.scenarios.split(",")) - set(SCENARIOS)
+    if unknown:
+        sys.exit(f"unknown scenario(s): {', '.join(sorted(unknown))}")
+
+    workdir = tempfile.mkdtemp(prefix="auralink-qemu-")
+    trace_path = os.path.join(workdir, "trace.bin")
+    flash_path = os.path.join(workdir, "flash.bin")
+    synthetic_trace(trace_path, args.records, args.period_ms)
+    build_flash(args.build_dir, trace_path, flash_path)
+
+    broker = Broker(workdir, args.port)
+    broker.start()
+    observer = Observer(args.port)
+    device = Device(args.qemu, flash_path, os.path.join(args.build_dir, "qemu_serial.log"))
+    results = {}
+    try:
+        if not wait_for_uplinks(observer, 1, args.boot_timeout):
+            results["boot"] = {"ok": False, "error": "no uplink before --boot-timeout"}
+        else:
+            first = observer.snapshot()[0][0][0]
+            results["boot"] = {"ok": True, "first_uplink_s": round(first - device.started, 2)}
+            for name in args.scenarios.split(","):
+                print(f"--- {name}")
+                results[name] = SCENARIOS[name](args, device, observer, broker)
+                print(json.dumps(results[name], indent=1))
+        results["health"] = observer.health
+    finally:
+        device.close()
+        observer.close()
+        broker.stop()
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    ok = all(r.get("ok") for k, r in results.items() if k != "health")
+    results["ok"] = ok
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=1)
+    print("PASS" if ok else "FAIL")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""Build, inspect and flash AuraLink sensor traces (see include/trace.h).
+
+  trace_tool.py from-log  capture.log trace.bin   # TRACE lines from a recording build
+  trace_tool.py from-csv  readings.csv trace.bin  # offset_ms,temperature,humidity,ldr_analog,nox_raw,ldr_digital,pir
+  trace_tool.py to-csv    trace.bin readings.csv
+  trace_tool.py flash     trace.bin --port /dev/ttyUSB0
+
+Recording: build the esp32doit-devkit-v1-record environment and save the
+serial monitor output; every sample is printed as a TRACE line.
+"""
+
+import argparse
+import csv
+import os
+import struct
+import subprocess
+import sys
+
+MAGIC = b"ALTR"
+VERSION = 1
+HEADER = struct.Struct("<4sHHII")
+RECORD = struct.Struct("<IffHHBBH")
+FIELDS = ["offset_ms", "temperature", "humidity", "ldr_analog", "nox_raw", "ldr_digital", "pir"]
+
+# Must match partitions_replay.csv
+PARTITION_OFFSET = 0x310000
+PARTITION_SIZE = 0xF0000
+
+
+def write_trace(path, rows):
+    rows = list(rows)
+    if not rows:
+        sys.exit("no records")
+    base = rows[0][0]
+    with open(path, "wb") as f:
+        f.write(HEADER.pack(MAGIC, VERSION, RECORD.size, len(rows), 0))
+        for ms, t, h, ldr, nox, ldr_do, pir in rows:
+            f.write(RECORD.pack(ms - base, t, h, ldr, nox, ldr_do, pir, 0))
+    size = HEADER.size + len(rows) * RECORD.size
+    if size > PARTITION_SIZE:
+        print(f"warning: {size} bytes will not fit the {PARTITION_SIZE} byte trace partition", file=sys.stderr)
+    print(f"{path}: {len(rows)} records, {size} bytes")
+
+
+def read_trace(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, record_size, count, _ = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION or record_size != RECORD.size:
+        sys.exit(f"{path}: not a version {VERSION} trace")
+    for i in range(count):
+        yield RECORD.unpack_from(data, HEADER.size + i * RECORD.size)[:7]
+
+
+def parse_row(values):
+    ms, t, h, ldr, nox, ldr_do, pir = values
+    return int(ms), float(t), float(h), int(ldr), int(nox), int(ldr_do), int(pir)
+
+
+def from_log(args):
+    rows = []
+    with open(args.input, errors="replace") as f:
+        for line in f:
+            # Monitor filters may prefix timestamps; the record starts at TRACE,
+            idx = line.find("TRACE,")
+            if idx >= 0:
+                rows.append(parse_row(line[idx + 6:].strip().split(",")))
+    write_trace(args.output, rows)
+
+
+def from_csv(args):
+    with open(args.input, newline="") as f:
+        write_trace(args.output, (parse_row(r[k] for k in FIELDS) for r in csv.DictReader(f)))
+
+
+def to_csv(args):
+    with open(args.output, "w", newline="") as f:
+        w = csv.writer(f)
+        w.writerow(FIELDS)
+        # repr() keeps float32 values exact across a CSV round trip
+        for ms, t, h, ldr, nox, ldr_do, pir in read_trace(args.input):
+            w.writerow([ms, repr(t), repr(h), ldr, nox, ldr_do, pir])
+
+
+def flash(args):
+    list(read_trace(args.input))  # validate before writing
+    if os.path.getsize(args.input) > PARTITION_SIZE:
+        sys.exit("trace does not fit the trace partition")
+    cmd = [sys.executable, "-m", "esptool", "--chip", "esp32"]
+    if args.port:
+        cmd += ["--port", args.port]
+    cmd += ["write_flash", hex(PARTITION_OFFSET), args.input]
+    print(" ".join(cmd))
+    sys.exit(subprocess.call(cmd))
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = p.add_subparsers(dest="cmd", required=True)
+    for name, fn in (("from-log", from_log), ("from-csv", from_csv), ("to-csv", to_csv)):
+        s = sub.add_parser(name)
+        s.add_argument("input")
+        s.add_argument("output")
+        s.set_defaults(fn=fn)
+    s = sub.add_parser("flash")
+    s.add_argument("input")
+    s.add_argument("--port")
+    s.set_defaults(fn=flash)
+    args = p.parse_args()
+    args.fn(args)
+
+
+if __name__ == "__main__":
+    main()